@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderBatchTranslator.h"
+#include "shaderThreadPool.h"
+
+/**
+ * Checks that translateBatch() returns the shaders in the order of the
+ * jobs, each one what translate() gives it, for any number of workers.
+ */
+static void testBatch(const std::vector<BenchShader> &corpus) {
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslatorGL33 preprocessed;
+	preprocessed.setPreprocessing(true);
+
+	// Alternate the backends so neighbouring jobs differ.
+	std::vector<ShaderBatchJob> jobs;
+	for (int copy = 0; copy < 4; copy++) {
+		for (const BenchShader &shader : corpus) {
+			jobs.push_back({ shader.source, shader.shaderType, ShaderTranslator::GL21 });
+			jobs.push_back({ shader.source, shader.shaderType, ShaderTranslator::GL33 });
+		}
+	}
+
+	for (unsigned workers : { 1u, 2u, 3u, 8u }) {
+		ShaderBatchTranslator batch(workers);
+		TEST_CHECK(batch.getWorkerCount() == workers);
+		TEST_CHECK(batch.translateBatch({}).empty());
+
+		// The second round reuses the contexts of the first, and the third
+		// uses a translator that was set for a backend.
+		for (int round = 0; round < 3; round++) {
+			if (round == 2)
+				batch.setTranslator(ShaderTranslator::GL33, &preprocessed);
+			const ShaderTranslator &translator33 = (round == 2) ? static_cast<const ShaderTranslator &>(preprocessed) : gl33;
+
+			std::vector<std::string> shaders = batch.translateBatch(jobs);
+			TEST_CHECK(shaders.size() == jobs.size());
+			for (size_t i = 0; i < jobs.size() && i < shaders.size(); i++) {
+				const ShaderTranslator &translator = (jobs[i].backend == ShaderTranslator::GL21) ? static_cast<const ShaderTranslator &>(gl21) : translator33;
+				TEST_CHECK_EQUAL(shaders[i], translator.translate(std::string(jobs[i].source), jobs[i].shaderType));
+			}
+		}
+	}
+}
+
+/**
+ * Checks that every index runs exactly once, and that an exception thrown
+ * by a task reaches the caller and leaves the pool usable.
+ */
+static void testPool() {
+	for (unsigned workers : { 1u, 2u, 4u }) {
+		ShaderThreadPool pool(workers);
+		std::vector<std::atomic<int>> runs(1000);
+		std::atomic<bool> inRange(true);
+		pool.parallelFor(runs.size(), [&runs, &inRange, workers](size_t index, unsigned worker) {
+			if (worker >= workers)
+				inRange = false;
+			runs[index]++;
+		});
+		TEST_CHECK(inRange);
+		bool once = true;
+		for (const std::atomic<int> &it : runs)
+			once = once && it == 1;
+		TEST_CHECK(once);
+
+		std::atomic<int> started(0);
+		bool caught = false;
+		try {
+			pool.parallelFor(1000, [&started](size_t index, unsigned worker) {
+				started++;
+				if (index == 37)
+					throw std::runtime_error("task 37");
+			});
+		} catch (const std::runtime_error &error) {
+			caught = std::string(error.what()) == "task 37";
+		}
+		TEST_CHECK(caught);
+		TEST_CHECK(started > 0 && started <= 1000);
+
+		// Nothing of the failed run is left over for the next one.
+		std::atomic<int> count(0);
+		pool.parallelFor(500, [&count](size_t index, unsigned worker) {
+			count++;
+		});
+		TEST_CHECK(count == 500);
+	}
+}
+
+int main(int argc, const char *argv[]) {
+	testBatch(generateBenchCorpus(true));
+	testPool();
+	return testFinish("GLSLBatchTest");
+}
\ No newline at end of file
@@ -0,0 +1,481 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "shaderTokenFile.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Allocation counting. Every allocation made by the process goes through the
+// replaced operator new below, which keeps the size in front of the block so
+// the live heap size and its peak can be tracked as well.
+//------------------------------------------------------------------------------
+
+#define BENCH_ALLOC_HEADER 16
+
+static std::atomic<uint64_t> sAllocations(0);
+static std::atomic<uint64_t> sAllocatedBytes(0);
+static std::atomic<int64_t> sLiveBytes(0);
+static std::atomic<int64_t> sPeakLiveBytes(0);
+
+static void *benchAllocate(size_t size) {
+	char *block = static_cast<char *>(malloc(size + BENCH_ALLOC_HEADER));
+	if (!block)
+		return nullptr;
+	memcpy(block, &size, sizeof(size));
+
+	sAllocations.fetch_add(1, std::memory_order_relaxed);
+	sAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	int64_t live = sLiveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+	int64_t peak = sPeakLiveBytes.load(std::memory_order_relaxed);
+	while (live > peak && !sPeakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+	}
+	return block + BENCH_ALLOC_HEADER;
+}
+
+static void benchFree(void *ptr) {
+	if (!ptr)
+		return;
+	char *block = static_cast<char *>(ptr) - BENCH_ALLOC_HEADER;
+	size_t size;
+	memcpy(&size, block, sizeof(size));
+	sLiveBytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+	free(block);
+}
+
+void *operator new(size_t size) {
+	void *ptr = benchAllocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	void *ptr = benchAllocate(size);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return benchAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return benchAllocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	benchFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	benchFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	benchFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	benchFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+	benchFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+	benchFree(ptr);
+}
+
+static uint64_t getPeakResidentBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Benchmark
+//------------------------------------------------------------------------------
+
+struct BenchResult {
+	std::string corpus;
+	const char *profile;
+	const char *backend;
+	const char *stage;
+	size_t inputBytes;
+	size_t outputBytes;
+	uint64_t iterations;
+	double seconds;
+	double allocationsPerShader;
+	double allocatedBytesPerShader;
+};
+
+/**
+ * The size of the output of a profile and backend, with and without
+ * minifying, summed over every shader of the corpus.
+ */
+struct BenchMinifyResult {
+	const char *profile;
+	const char *backend;
+	size_t outputBytes;
+	size_t minifiedBytes;
+};
+
+/**
+ * The size of the source of a profile as text and as token files, summed
+ * over every shader of the corpus.
+ */
+struct BenchTokenFileResult {
+	const char *profile;
+	size_t textBytes;
+	size_t fileBytes;
+};
+
+struct BenchOptions {
+	bool quick;
+	double minTime;
+	const char *jsonPath;
+};
+
+static void printUsage() {
+	printf("Usage: GLSLBench [--quick] [--min-time <seconds>] [--json <path>]\n");
+	printf("  --quick       only benchmark the 1 KB and 16 KB shaders\n");
+	printf("  --min-time    time spent on every shader and backend (default 0.25)\n");
+	printf("  --json        also write the results as JSON to <path>, - for stdout,\n");
+	printf("                which moves the table to stderr\n");
+}
+
+static bool parseOptions(int argc, const char *argv[], BenchOptions &options) {
+	options.quick = false;
+	options.minTime = 0.25;
+	options.jsonPath = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			options.quick = true;
+		} else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			options.minTime = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			options.jsonPath = argv[++i];
+		} else {
+			printUsage();
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Times a translation of a shader.
+ * @param translate Translates the shader once and returns the size of the output.
+ */
+static BenchResult runBenchmark(const char *backend, const BenchShader &shader, double minTime, const std::function<size_t()> &translate) {
+	BenchResult result;
+	result.corpus = shader.name;
+	result.profile = getBenchProfileName(shader.profile);
+	result.backend = backend;
+	result.stage = (shader.shaderType == ShaderTranslator::VERTEX) ? "vertex" : "fragment";
+	result.inputBytes = shader.source.length();
+
+	// Warm up the context and the output so the numbers show the steady
+	// state, in which a translation should not allocate at all.
+	result.outputBytes = translate();
+
+	uint64_t allocations = sAllocations.load();
+	uint64_t allocatedBytes = sAllocatedBytes.load();
+	uint64_t iterations = 0;
+	size_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0.0;
+	do {
+		checksum += translate();
+		iterations++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < minTime || iterations < 3);
+
+	result.iterations = iterations;
+	result.seconds = elapsed;
+	result.allocationsPerShader = static_cast<double>(sAllocations.load() - allocations) / iterations;
+	result.allocatedBytesPerShader = static_cast<double>(sAllocatedBytes.load() - allocatedBytes) / iterations;
+	if (checksum != result.outputBytes * iterations)
+		fprintf(stderr, "warning: output of %s changed between iterations\n", shader.name.c_str());
+	return result;
+}
+
+static void printResult(FILE *file, const BenchResult &r) {
+	fprintf(file, "%-28s %-5s %10.1f %12.1f %10.1f %12.0f\n", r.corpus.c_str(), r.backend,
+		(r.inputBytes * r.iterations) / (r.seconds * 1024.0 * 1024.0), r.iterations / r.seconds,
+		r.allocationsPerShader, r.allocatedBytesPerShader);
+}
+
+static const char *getScannerName() {
+	switch (ShaderScanner::getImplementation()) {
+	case ShaderScanner::AVX2:
+		return "avx2";
+	case ShaderScanner::SSE2:
+		return "sse2";
+	default:
+		return "scalar";
+	}
+}
+
+static void printMinifyResult(FILE *file, const BenchMinifyResult &r) {
+	fprintf(file, "%-28s %-5s %12zu %12zu %9.1f%%\n", r.profile, r.backend, r.outputBytes, r.minifiedBytes,
+		r.outputBytes ? (r.outputBytes - r.minifiedBytes) * 100.0 / r.outputBytes : 0.0);
+}
+
+static void printTokenFileResult(FILE *file, const BenchTokenFileResult &r) {
+	fprintf(file, "%-28s %12zu %12zu %9.1f%%\n", r.profile, r.textBytes, r.fileBytes,
+		r.textBytes ? r.fileBytes * 100.0 / r.textBytes : 0.0);
+}
+
+static void writeJson(FILE *file, const std::vector<BenchResult> &results, const std::vector<BenchMinifyResult> &minified, const std::vector<BenchTokenFileResult> &tokenFiles) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"rules_version\": %d,\n", SHADER_TRANSLATOR_RULES_VERSION);
+	fprintf(file, "  \"scanner\": \"%s\",\n", getScannerName());
+	fprintf(file, "  \"peak_heap_bytes\": %lld,\n", static_cast<long long>(sPeakLiveBytes.load()));
+	fprintf(file, "  \"peak_rss_bytes\": %llu,\n", static_cast<unsigned long long>(getPeakResidentBytes()));
+	fprintf(file, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult &r = results[i];
+		fprintf(file, "    {\"corpus\": \"%s\", \"profile\": \"%s\", \"backend\": \"%s\", \"stage\": \"%s\", ",
+			r.corpus.c_str(), r.profile, r.backend, r.stage);
+		fprintf(file, "\"input_bytes\": %zu, \"output_bytes\": %zu, \"iterations\": %llu, \"seconds\": %.6f, ",
+			r.inputBytes, r.outputBytes, static_cast<unsigned long long>(r.iterations), r.seconds);
+		fprintf(file, "\"mb_per_s\": %.3f, \"shaders_per_s\": %.3f, \"allocations_per_shader\": %.2f, \"allocated_bytes_per_shader\": %.1f}%s\n",
+			(r.inputBytes * r.iterations) / (r.seconds * 1024.0 * 1024.0), r.iterations / r.seconds,
+			r.allocationsPerShader, r.allocatedBytesPerShader, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"minified\": [\n");
+	for (size_t i = 0; i < minified.size(); i++) {
+		const BenchMinifyResult &r = minified[i];
+		fprintf(file, "    {\"profile\": \"%s\", \"backend\": \"%s\", \"output_bytes\": %zu, \"minified_bytes\": %zu}%s\n",
+			r.profile, r.backend, r.outputBytes, r.minifiedBytes, (i + 1 < minified.size()) ? "," : "");
+	}
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"token_files\": [\n");
+	for (size_t i = 0; i < tokenFiles.size(); i++) {
+		const BenchTokenFileResult &r = tokenFiles[i];
+		fprintf(file, "    {\"profile\": \"%s\", \"text_bytes\": %zu, \"file_bytes\": %zu}%s\n",
+			r.profile, r.textBytes, r.fileBytes, (i + 1 < tokenFiles.size()) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, const char * argv[]) {
+	BenchOptions options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	std::vector<BenchShader> corpus = generateBenchCorpus(options.quick);
+
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslatorGL21 minifyGL21;
+	ShaderTranslatorGL33 minifyGL33;
+	minifyGL21.setMinify(true);
+	minifyGL33.setMinify(true);
+	ShaderTranslatorGL33 reflectGL33;
+	reflectGL33.setReflection(true);
+	reflectGL33.setExplicitLocations(true);
+	struct {
+		const ShaderTranslator *translator;
+		const ShaderTranslator *minifier;
+		const char *name;
+		const char *tokenFileName;
+	} backends[] = { { &gl21, &minifyGL21, "GL21", "tok21" }, { &gl33, &minifyGL33, "GL33", "tok33" } };
+
+	// The JSON can go to stdout, so the table goes to stderr then.
+	bool jsonToStdout = options.jsonPath && strcmp(options.jsonPath, "-") == 0;
+	FILE *table = jsonToStdout ? stderr : stdout;
+
+	fprintf(table, "%-28s %-5s %10s %12s %10s %12s\n", "corpus", "lang", "MB/s", "shaders/s", "allocs", "alloc bytes");
+	std::vector<BenchResult> results;
+	bool allocated = false;
+	ShaderTranslationContext context;
+	std::string output;
+	std::string secondOutput;
+	std::string tokenFileData;
+	ShaderTokenFile tokenFile;
+	BenchTokenFileResult tokenFileSizes[BENCH_PROFILE_COUNT] = {};
+	for (const auto &shader : corpus) {
+		std::vector<ShaderTranslator::Target> targets = {
+			{ &gl21, shader.shaderType, &output },
+			{ &gl33, shader.shaderType, &secondOutput }
+		};
+
+		for (const auto &backend : backends) {
+			BenchResult r = runBenchmark(backend.name, shader, options.minTime, [&]() {
+				backend.translator->translateInto(context, shader.source, shader.shaderType, output);
+				return output.length();
+			});
+			printResult(table, r);
+			results.push_back(r);
+			allocated |= r.allocationsPerShader != 0.0;
+		}
+
+		// GL33 with the interface reflected and the attributes placed.
+		BenchResult reflected = runBenchmark("refl33", shader, options.minTime, [&]() {
+			reflectGL33.translateInto(context, shader.source, shader.shaderType, output);
+			return output.length();
+		});
+		printResult(table, reflected);
+		results.push_back(reflected);
+		allocated |= reflected.allocationsPerShader != 0.0;
+
+		// Both backends from one tokenize.
+		BenchResult r = runBenchmark("both", shader, options.minTime, [&]() {
+			ShaderTranslator::translateAll(context, shader.source, targets);
+			return output.length() + secondOutput.length();
+		});
+		printResult(table, r);
+		results.push_back(r);
+		allocated |= r.allocationsPerShader != 0.0;
+
+		// Loading a token file that was built offline and translating it,
+		// against translating the text above.
+		ShaderTokenFile::build(shader.source, tokenFileData);
+		tokenFileSizes[shader.profile].textBytes += shader.source.length();
+		tokenFileSizes[shader.profile].fileBytes += tokenFileData.length();
+		for (const auto &backend : backends) {
+			BenchResult r = runBenchmark(backend.tokenFileName, shader, options.minTime, [&]() {
+				tokenFile.load(tokenFileData.data(), tokenFileData.length());
+				backend.translator->translateTokenFile(context, tokenFile, shader.shaderType, output);
+				return output.length();
+			});
+			printResult(table, r);
+			results.push_back(r);
+			allocated |= r.allocationsPerShader != 0.0;
+		}
+	}
+
+	// How much smaller minifying makes the output, for every profile. This
+	// runs after the timings, as the minifier is allowed to allocate.
+	fprintf(table, "\n%-28s %-5s %12s %12s %10s\n", "minified", "lang", "bytes", "minified", "saved");
+	std::vector<BenchMinifyResult> minified;
+	for (const auto &backend : backends) {
+		BenchMinifyResult all = { "all", backend.name, 0, 0 };
+		for (int profile = 0; profile < BENCH_PROFILE_COUNT; profile++) {
+			BenchMinifyResult r = { getBenchProfileName(static_cast<BenchProfile>(profile)), backend.name, 0, 0 };
+			for (const auto &shader : corpus) {
+				if (shader.profile != profile)
+					continue;
+				backend.translator->translateInto(context, shader.source, shader.shaderType, output);
+				r.outputBytes += output.length();
+				backend.minifier->translateInto(context, shader.source, shader.shaderType, output);
+				r.minifiedBytes += output.length();
+			}
+			printMinifyResult(table, r);
+			minified.push_back(r);
+			all.outputBytes += r.outputBytes;
+			all.minifiedBytes += r.minifiedBytes;
+		}
+		printMinifyResult(table, all);
+		minified.push_back(all);
+	}
+
+	fprintf(table, "\n%-28s %12s %12s %10s\n", "token files", "text bytes", "file bytes", "size");
+	std::vector<BenchTokenFileResult> tokenFiles;
+	BenchTokenFileResult allTokenFiles = { "all", 0, 0 };
+	for (int profile = 0; profile < BENCH_PROFILE_COUNT; profile++) {
+		BenchTokenFileResult &r = tokenFileSizes[profile];
+		r.profile = getBenchProfileName(static_cast<BenchProfile>(profile));
+		tokenFiles.push_back(r);
+		allTokenFiles.textBytes += r.textBytes;
+		allTokenFiles.fileBytes += r.fileBytes;
+	}
+	tokenFiles.push_back(allTokenFiles);
+	for (const BenchTokenFileResult &r : tokenFiles)
+		printTokenFileResult(table, r);
+
+#ifdef GLSL_TRANSLATOR_STATS
+	// Where the time went, over every shader of the run.
+	ShaderTranslationStats stats = ShaderTranslator::getGlobalStats();
+	double total = static_cast<double>(stats.tokenizeNs + stats.rewriteNs + stats.emitNs);
+	if (total > 0.0) {
+		fprintf(table, "\nphases: tokenize %.1f%%, rewrite %.1f%%, emit %.1f%% over %llu translations\n",
+			stats.tokenizeNs * 100.0 / total, stats.rewriteNs * 100.0 / total, stats.emitNs * 100.0 / total,
+			static_cast<unsigned long long>(stats.translations));
+	}
+#endif
+
+	fprintf(table, "\nscanner: %s, peak heap: %lld bytes, peak rss: %llu bytes\n", getScannerName(),
+		static_cast<long long>(sPeakLiveBytes.load()), static_cast<unsigned long long>(getPeakResidentBytes()));
+
+	if (options.jsonPath) {
+		FILE *file = jsonToStdout ? stdout : fopen(options.jsonPath, "w");
+		if (!file) {
+			fprintf(stderr, "Could not open %s\n", options.jsonPath);
+			return 1;
+		}
+		writeJson(file, results, minified, tokenFiles);
+		if (file != stdout)
+			fclose(file);
+	}
+
+	if (allocated) {
+		fprintf(stderr, "error: translating with a warmed up context and output allocated memory\n");
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
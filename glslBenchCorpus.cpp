@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include "glslBenchCorpus.h"
+
+// A tiny deterministic generator, so a corpus is the same on every machine.
+class BenchRandom {
+public:
+	explicit BenchRandom(unsigned seed) : mState(seed * 2654435761u + 1) {}
+
+	unsigned next(unsigned range) {
+		mState ^= mState << 13;
+		mState ^= mState >> 17;
+		mState ^= mState << 5;
+		return mState % range;
+	}
+
+private:
+	unsigned mState;
+};
+
+static const char *TYPES[] = { "float", "vec2", "vec3", "vec4", "mat3", "mat4" };
+static const char *SAMPLERS[] = { "texture2D", "texture2DLod", "textureCube", "texture2DProj", "shadow2D" };
+
+// Vertex shaders can only pick the level of detail themselves.
+static const char *VERTEX_SAMPLERS[] = { "texture2DLod", "textureCubeLod", "texture2DProjLod" };
+
+static const char *SAMPLER_UNIFORMS =
+	"uniform sampler2D u_sampler0;\nuniform sampler2D u_sampler1;\nuniform sampler2D u_sampler2;\nuniform sampler2D u_sampler3;\n"
+	"uniform samplerCube u_sampler0Cube;\nuniform samplerCube u_sampler1Cube;\nuniform samplerCube u_sampler2Cube;\nuniform samplerCube u_sampler3Cube;\n";
+static const char *WORDS[] = { "light", "albedo", "normal", "shadow", "fog", "specular", "rim", "detail", "bone", "weight" };
+
+static void appendName(std::string &out, BenchRandom &random, const char *prefix, unsigned index) {
+	out += prefix;
+	out += WORDS[random.next(10)];
+	out += std::to_string(index);
+}
+
+static void appendComment(std::string &out, BenchRandom &random) {
+	if (random.next(2) == 0) {
+		out += "// ";
+		for (unsigned i = 0, n = 4 + random.next(10); i < n; i++) {
+			out += WORDS[random.next(10)];
+			out += ' ';
+		}
+		out += '\n';
+	} else {
+		out += "/*\n * The ";
+		out += WORDS[random.next(10)];
+		out += " term is computed in view space so that the varying and attribute\n";
+		out += " * inputs line up with the texture2D lookups further down.\n */\n";
+	}
+}
+
+static void appendUniform(std::string &out, BenchRandom &random, unsigned index) {
+	out += "uniform ";
+	out += TYPES[random.next(6)];
+	out += ' ';
+	appendName(out, random, "u_", index);
+	if (random.next(4) == 0) {
+		out += '[';
+		out += std::to_string(1 + random.next(16));
+		out += ']';
+	}
+	out += ";\n";
+}
+
+static void appendTextureLine(std::string &out, BenchRandom &random, unsigned index) {
+	unsigned sampler = random.next(5);
+	std::string name;
+	appendName(name, random, "s_", index);
+	out += "\tvec4 ";
+	out += name;
+	out += " = ";
+	out += SAMPLERS[sampler];
+	out += "(u_sampler";
+	out += std::to_string(random.next(4));
+	switch (sampler) {
+	case 1:
+		out += ", uv, 2.0);\n";
+		break;
+	case 2:
+		out += "Cube, worldNormal);\n";
+		break;
+	case 3:
+		out += ", vec4(uv, 0.0, 1.0));\n";
+		break;
+	default:
+		out += ", uv);\n";
+		break;
+	}
+	out += "\tcolor += ";
+	out += name;
+	out += " * 0.25;\n";
+}
+
+static void appendVertexTextureLine(std::string &out, BenchRandom &random, unsigned index) {
+	unsigned sampler = random.next(3);
+	std::string name;
+	appendName(name, random, "s_", index);
+	out += "\tvec4 ";
+	out += name;
+	out += " = ";
+	out += VERTEX_SAMPLERS[sampler];
+	out += "(u_sampler";
+	out += std::to_string(random.next(4));
+	switch (sampler) {
+	case 1:
+		out += "Cube, inNormal, 0.0);\n";
+		break;
+	case 2:
+		out += ", vec4(inTexCoord, 0.0, 1.0), 0.0);\n";
+		break;
+	default:
+		out += ", inTexCoord, 0.0);\n";
+		break;
+	}
+	out += "\tcolor += ";
+	out += name;
+	out += " * 0.25;\n";
+}
+
+static void appendMathLine(std::string &out, BenchRandom &random, unsigned index) {
+	std::string name;
+	appendName(name, random, "t_", index);
+	out += "\tfloat ";
+	out += name;
+	out += " = max(dot(worldNormal, vec3(0.0, 1.0, 0.0)), 0.0) * ";
+	out += std::to_string(random.next(100));
+	out += ".5;\n\tcolor.rgb += vec3(";
+	out += name;
+	out += ");\n";
+}
+
+const char *getBenchProfileName(BenchProfile profile) {
+	switch (profile) {
+	case BENCH_PROFILE_UNIFORMS:
+		return "uniforms";
+	case BENCH_PROFILE_TEXTURES:
+		return "textures";
+	case BENCH_PROFILE_COMMENTS:
+		return "comments";
+	default:
+		return "mixed";
+	}
+}
+
+std::string generateBenchShader(BenchProfile profile, ShaderTranslator::ShaderType shaderType, size_t size, unsigned seed) {
+	BenchRandom random(seed);
+	bool vertex = (shaderType == ShaderTranslator::VERTEX);
+	std::string out;
+	out.reserve(size + 512);
+
+	// The interface of the shader.
+	appendComment(out, random);
+	if (vertex) {
+		out += "attribute vec3 inPosition;\nattribute vec3 inNormal;\nattribute vec2 inTexCoord;\n";
+		out += "varying vec3 worldNormal;\nvarying vec2 uv;\n";
+		if (profile == BENCH_PROFILE_TEXTURES)
+			out += SAMPLER_UNIFORMS;
+	} else {
+		out += "varying vec3 worldNormal;\nvarying vec2 uv;\n";
+		out += SAMPLER_UNIFORMS;
+	}
+	out += "uniform mat4 modelViewProjection;\n\n";
+
+	// Declarations up to a third of the shader, the rest goes in the body.
+	unsigned index = 0;
+	while (out.length() < size / 3) {
+		unsigned pick = random.next(10);
+		if (profile == BENCH_PROFILE_UNIFORMS || (profile == BENCH_PROFILE_MIXED && pick < 5))
+			appendUniform(out, random, index++);
+		else if (profile == BENCH_PROFILE_COMMENTS && pick < 7)
+			appendComment(out, random);
+		else
+			appendUniform(out, random, index++);
+	}
+
+	out += "\nvoid main() {\n\tvec4 color = vec4(0.0);\n";
+	while (out.length() + 64 < size) {
+		unsigned pick = random.next(10);
+		if (profile == BENCH_PROFILE_COMMENTS && pick < 6)
+			appendComment(out, random);
+		else if (vertex && profile == BENCH_PROFILE_TEXTURES && pick < 8)
+			appendVertexTextureLine(out, random, index++);
+		else if (!vertex && (profile == BENCH_PROFILE_TEXTURES ? pick < 8 : pick < 3))
+			appendTextureLine(out, random, index++);
+		else
+			appendMathLine(out, random, index++);
+	}
+
+	if (vertex)
+		out += "\tworldNormal = inNormal;\n\tuv = inTexCoord;\n\tgl_Position = modelViewProjection * vec4(inPosition + color.xyz * 0.0, 1.0);\n}\n";
+	else
+		out += "\tgl_FragColor = color;\n}\n";
+	return out;
+}
+
+std::vector<BenchShader> generateBenchCorpus(bool quick) {
+	static const size_t SIZES[] = { 1024, 16 * 1024, 256 * 1024, 1024 * 1024 };
+	size_t sizeCount = quick ? 2 : 4;
+
+	std::vector<BenchShader> corpus;
+	unsigned seed = 1;
+	for (size_t s = 0; s < sizeCount; s++) {
+		for (int p = 0; p < BENCH_PROFILE_COUNT; p++) {
+			for (int t = 0; t < 2; t++) {
+				BenchShader shader;
+				shader.profile = static_cast<BenchProfile>(p);
+				shader.shaderType = static_cast<ShaderTranslator::ShaderType>(t);
+				shader.source = generateBenchShader(shader.profile, shader.shaderType, SIZES[s], seed++);
+
+				char name[64];
+				snprintf(name, sizeof(name), "%s-%s-%zuKB", getBenchProfileName(shader.profile), t == 0 ? "vertex" : "fragment", SIZES[s] / 1024);
+				shader.name = name;
+				corpus.push_back(shader);
+			}
+		}
+	}
+	return corpus;
+}
\ No newline at end of file
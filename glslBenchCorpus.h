@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef glslBenchCorpus_h
+#define glslBenchCorpus_h
+
+#include <string>
+#include <vector>
+#include "shaderTranslator.h"
+
+/**
+ * The kind of code a generated shader is heavy on.
+ */
+enum BenchProfile {
+	BENCH_PROFILE_MIXED,
+	BENCH_PROFILE_UNIFORMS,
+	BENCH_PROFILE_TEXTURES,
+	BENCH_PROFILE_COMMENTS,
+	BENCH_PROFILE_COUNT
+};
+
+/**
+ * A generated shader of the benchmark corpus.
+ */
+struct BenchShader {
+	std::string name;
+	BenchProfile profile;
+	ShaderTranslator::ShaderType shaderType;
+	std::string source;
+};
+
+/**
+ * Get's the name of a profile.
+ * @param profile The profile.
+ * @return the name of the profile.
+ */
+const char *getBenchProfileName(BenchProfile profile);
+
+/**
+ * Generates a GLSL 120 shader that looks like hand written engine code.
+ * The output only depends on the arguments.
+ * @param profile What the shader is heavy on.
+ * @param shaderType The type of shader to generate.
+ * @param size The size to generate, in bytes. The shader is cut off at the
+ *  end of the line that reaches it.
+ * @param seed The seed of the generator.
+ * @return the shader source.
+ */
+std::string generateBenchShader(BenchProfile profile, ShaderTranslator::ShaderType shaderType, size_t size, unsigned seed);
+
+/**
+ * Generates the corpus: every profile and shader type at sizes from 1 KB to 1 MB.
+ * @param quick Set to only generate the smaller sizes.
+ * @return the shaders of the corpus.
+ */
+std::vector<BenchShader> generateBenchCorpus(bool quick);
+
+#endif /* glslBenchCorpus_h */
\ No newline at end of file
@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glslTest.h"
+#include "shaderTranslationCache.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * Builds a key that only differs from the others by its hash.
+ */
+static ShaderTranslationCache::Key makeTestKey(uint64_t hash) {
+	ShaderTranslationCache::Key key = {};
+	key.hash = hash;
+	key.length = 1;
+	key.shaderType = ShaderTranslator::VERTEX;
+	return key;
+}
+
+/**
+ * Checks that the least recently used shaders are evicted once the byte
+ * budget is exceeded, and that the counters follow along.
+ */
+static void testEviction() {
+	ShaderTranslationCache cache(1024 * 1024);
+	const std::string text(100, 'x');
+	cache.insert(makeTestKey(1), text);
+	const size_t entryBytes = cache.getByteSize();
+	TEST_CHECK(entryBytes >= text.length());
+
+	// Room for exactly three shaders.
+	cache.setByteBudget(entryBytes * 3);
+	cache.insert(makeTestKey(2), text);
+	cache.insert(makeTestKey(3), text);
+	TEST_CHECK(cache.getEntryCount() == 3);
+	TEST_CHECK(cache.getByteSize() == entryBytes * 3);
+	TEST_CHECK(cache.getEvictionCount() == 0);
+
+	// Using 1 makes 2 the least recently used.
+	TEST_CHECK(cache.find(makeTestKey(1)) != nullptr);
+	cache.insert(makeTestKey(4), text);
+	TEST_CHECK(cache.getEntryCount() == 3);
+	TEST_CHECK(cache.getEvictionCount() == 1);
+	TEST_CHECK(cache.find(makeTestKey(2)) == nullptr);
+	TEST_CHECK(cache.find(makeTestKey(1)) != nullptr);
+	TEST_CHECK(cache.find(makeTestKey(3)) != nullptr);
+	TEST_CHECK(cache.find(makeTestKey(4)) != nullptr);
+	TEST_CHECK(cache.getHitCount() == 4);
+	TEST_CHECK(cache.getMissCount() == 1);
+
+	// The order is now 4, 3, 1, so shrinking the budget evicts 1 and then 3.
+	cache.setByteBudget(entryBytes * 2);
+	TEST_CHECK(cache.find(makeTestKey(1)) == nullptr);
+	TEST_CHECK(cache.find(makeTestKey(3)) != nullptr);
+	cache.setByteBudget(entryBytes);
+	TEST_CHECK(cache.getEntryCount() == 1);
+	TEST_CHECK(cache.find(makeTestKey(4)) == nullptr);
+	TEST_CHECK(cache.find(makeTestKey(3)) != nullptr);
+	TEST_CHECK(cache.getEvictionCount() == 3);
+
+	// Storing a key again keeps the first shader and costs nothing.
+	auto stored = cache.insert(makeTestKey(3), std::string(100, 'y'));
+	TEST_CHECK(*stored == text);
+	TEST_CHECK(cache.getByteSize() == entryBytes);
+
+	// A shader bigger than the budget is handed back but not stored.
+	auto big = cache.insert(makeTestKey(5), std::string(entryBytes, 'z'));
+	TEST_CHECK(big->length() == entryBytes);
+	TEST_CHECK(cache.find(makeTestKey(5)) == nullptr);
+	TEST_CHECK(cache.find(makeTestKey(3)) != nullptr);
+
+	// Clearing empties the cache but keeps the counters.
+	uint64_t hits = cache.getHitCount();
+	uint64_t misses = cache.getMissCount();
+	cache.clear();
+	TEST_CHECK(cache.getEntryCount() == 0);
+	TEST_CHECK(cache.getByteSize() == 0);
+	TEST_CHECK(cache.getHitCount() == hits);
+	TEST_CHECK(cache.getMissCount() == misses);
+}
+
+/**
+ * Checks that translate() keys shaders by source, configuration and type.
+ */
+static void testTranslate() {
+	ShaderTranslationCache cache;
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslatorGL33 located;
+	located.setExplicitLocations(true);
+	const std::string source = "varying vec2 uv;\nvoid main() { gl_FragColor = texture2D(s, uv); }\n";
+
+	const ShaderTranslator *translators[] = { &gl21, &gl33, &located };
+	for (int pass = 0; pass < 2; pass++) {
+		for (const ShaderTranslator *translator : translators) {
+			for (ShaderTranslator::ShaderType shaderType : { ShaderTranslator::VERTEX, ShaderTranslator::FRAGMENT })
+				TEST_CHECK_EQUAL(cache.translate(*translator, source, shaderType), translator->translate(source, shaderType));
+		}
+		TEST_CHECK(cache.getMissCount() == 6);
+		TEST_CHECK(cache.getHitCount() == (pass ? 6u : 0u));
+	}
+	TEST_CHECK(cache.getEntryCount() == 6);
+
+	// A different source of the same length is a different shader.
+	std::string other = source;
+	other[0] = 'V';
+	TEST_CHECK_EQUAL(cache.translate(gl33, other, ShaderTranslator::VERTEX), gl33.translate(other, ShaderTranslator::VERTEX));
+	TEST_CHECK(cache.getMissCount() == 7);
+}
+
+/**
+ * Checks that threads looking up and storing the same shaders, under a
+ * budget small enough to keep evicting, always get the right translation
+ * and leave the cache consistent.
+ */
+static void testConcurrent() {
+	ShaderTranslatorGL33 gl33;
+	std::vector<std::string> sources;
+	std::vector<std::string> expected;
+	for (int i = 0; i < 64; i++) {
+		sources.push_back("varying vec2 uv" + std::to_string(i) + ";\nvoid main() { gl_FragColor = texture2D(s, uv" + std::to_string(i) + "); }\n");
+		expected.push_back(gl33.translate(sources.back(), ShaderTranslator::FRAGMENT));
+	}
+
+	ShaderTranslationCache cache(4 * 1024);
+	const int threadCount = 8;
+	const int lookups = 4000;
+	std::atomic<int> wrong(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			for (int i = 0; i < lookups; i++) {
+				size_t index = static_cast<size_t>(i * 7 + t * 13) % sources.size();
+				ShaderTranslationCache::Key key = ShaderTranslationCache::makeKey(gl33, sources[index], ShaderTranslator::FRAGMENT);
+				auto found = cache.find(key);
+				if (!found)
+					found = cache.insert(key, gl33.translate(sources[index], ShaderTranslator::FRAGMENT));
+				if (*found != expected[index])
+					wrong++;
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	TEST_CHECK(wrong == 0);
+	TEST_CHECK(cache.getHitCount() + cache.getMissCount() == static_cast<uint64_t>(threadCount * lookups));
+	TEST_CHECK(cache.getHitCount() > 0);
+	TEST_CHECK(cache.getEvictionCount() > 0);
+	TEST_CHECK(cache.getByteSize() <= cache.getByteBudget());
+	TEST_CHECK(cache.getEntryCount() > 0);
+
+	// Every shader that is left is still found with the right translation.
+	size_t found = 0;
+	for (size_t i = 0; i < sources.size(); i++) {
+		auto translated = cache.find(ShaderTranslationCache::makeKey(gl33, sources[i], ShaderTranslator::FRAGMENT));
+		if (translated) {
+			TEST_CHECK_EQUAL(*translated, expected[i]);
+			found++;
+		}
+	}
+	TEST_CHECK(found == cache.getEntryCount());
+}
+
+int main(int argc, const char *argv[]) {
+	testEviction();
+	testTranslate();
+	testConcurrent();
+	return testFinish("GLSLCacheTest");
+}
\ No newline at end of file
@@ -0,0 +1,536 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "shaderFile.h"
+#include "shaderFileProvider.h"
+#include "shaderHash.h"
+#include "shaderIncludeTranslator.h"
+#include "shaderThreadPool.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * The version of the manifest file. Bump this whenever its layout changes.
+ */
+#define COMPILE_MANIFEST_VERSION 1
+
+/**
+ * The name of the manifest in the output directory, unless --manifest is given.
+ */
+#define COMPILE_MANIFEST_NAME ".glslcompile"
+
+//------------------------------------------------------------------------------
+// Options
+//------------------------------------------------------------------------------
+
+struct CompileOptions {
+	std::vector<std::string> inputs;
+	std::string output;
+	std::string manifest;
+	std::string depfile;
+	bool backends[SHADER_BACKEND_COUNT];
+	unsigned jobs;
+	bool force;
+	bool minify;
+	bool minifyMap;
+	bool reflect;
+	bool locations;
+	bool verbose;
+};
+
+static void printUsage() {
+	printf("Usage: GLSLCompile [options] -o <output dir> <input dir>...\n");
+	printf("Translates every .vert/.vs/.vsh and .frag/.fs/.fsh shader below the input\n");
+	printf("directories to <output dir>/<backend>/<path>. #include \"file\" is looked up\n");
+	printf("next to the including file, then from the input directory the shader is in.\n");
+	printf("  -o <dir>            the output directory\n");
+	printf("  --backend <name>    gl21, gl33 or all (default all)\n");
+	printf("  --jobs <count>      the number of threads (default one per core)\n");
+	printf("  --manifest <path>   where the incremental build state is kept\n");
+	printf("                      (default <output dir>/" COMPILE_MANIFEST_NAME ")\n");
+	printf("  --depfile <path>    also write the dependencies of every output as Makefile rules\n");
+	printf("  --force             translate every shader, even if it is up to date\n");
+	printf("  --minify            strip comments and whitespace and shorten local names\n");
+	printf("  --minify-map        --minify, and append the map of short names to every shader\n");
+	printf("  --reflect           append the attributes, varyings and uniforms to every shader\n");
+	printf("  --locations         place gl33 attributes and fragment outputs at explicit locations\n");
+	printf("  -v                  print every shader that is translated\n");
+}
+
+static bool parseOptions(int argc, const char *argv[], CompileOptions &options) {
+	options.backends[ShaderTranslator::GL21] = true;
+	options.backends[ShaderTranslator::GL33] = true;
+	options.jobs = 0;
+	options.force = false;
+	options.minify = false;
+	options.minifyMap = false;
+	options.reflect = false;
+	options.locations = false;
+	options.verbose = false;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "-o") == 0 && hasValue) {
+			options.output = argv[++i];
+		} else if (strcmp(argv[i], "--backend") == 0 && hasValue) {
+			const char *name = argv[++i];
+			bool all = strcmp(name, "all") == 0;
+			options.backends[ShaderTranslator::GL21] = all || strcmp(name, "gl21") == 0;
+			options.backends[ShaderTranslator::GL33] = all || strcmp(name, "gl33") == 0;
+			if (!options.backends[ShaderTranslator::GL21] && !options.backends[ShaderTranslator::GL33]) {
+				fprintf(stderr, "Unknown backend %s\n", name);
+				return false;
+			}
+		} else if (strcmp(argv[i], "--jobs") == 0 && hasValue) {
+			options.jobs = static_cast<unsigned>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--manifest") == 0 && hasValue) {
+			options.manifest = argv[++i];
+		} else if (strcmp(argv[i], "--depfile") == 0 && hasValue) {
+			options.depfile = argv[++i];
+		} else if (strcmp(argv[i], "--force") == 0) {
+			options.force = true;
+		} else if (strcmp(argv[i], "--minify") == 0) {
+			options.minify = true;
+		} else if (strcmp(argv[i], "--minify-map") == 0) {
+			options.minify = true;
+			options.minifyMap = true;
+		} else if (strcmp(argv[i], "--reflect") == 0) {
+			options.reflect = true;
+		} else if (strcmp(argv[i], "--locations") == 0) {
+			options.locations = true;
+		} else if (strcmp(argv[i], "-v") == 0) {
+			options.verbose = true;
+		} else if (argv[i][0] != '-') {
+			options.inputs.push_back(argv[i]);
+		} else {
+			printUsage();
+			return false;
+		}
+	}
+
+	if (options.output.empty() || options.inputs.empty()) {
+		printUsage();
+		return false;
+	}
+	if (options.manifest.empty())
+		options.manifest = (fs::path(options.output) / COMPILE_MANIFEST_NAME).string();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Manifest. For every output it records the configuration it was translated
+// with and the hash of every file it was built from, which is what decides
+// whether the output is up to date. One line per output:
+// <output>\t<configuration>\t<file>\t<hash>\t<file>\t<hash>...
+//------------------------------------------------------------------------------
+
+struct ManifestEntry {
+	uint64_t configuration;
+	std::vector<std::pair<std::string, uint64_t>> files;
+};
+
+typedef std::unordered_map<std::string, ManifestEntry> Manifest;
+
+static void splitTabs(const std::string &line, std::vector<std::string> &fields) {
+	fields.clear();
+	size_t start = 0;
+	for (;;) {
+		size_t tab = line.find('\t', start);
+		fields.push_back(line.substr(start, tab - start));
+		if (tab == std::string::npos)
+			break;
+		start = tab + 1;
+	}
+}
+
+static void readManifest(const std::string &path, Manifest &manifest) {
+	ShaderMappedFile file;
+	if (!file.open(path) || !file.getData())
+		return;
+
+	std::string text(file.getData(), file.getSize());
+	std::vector<std::string> fields;
+	size_t start = 0;
+	bool first = true;
+	while (start < text.length()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos)
+			end = text.length();
+		std::string line = text.substr(start, end - start);
+		start = end + 1;
+
+		// Outputs of another manifest layout or rules version are rebuilt.
+		if (first) {
+			char header[64];
+			snprintf(header, sizeof(header), "GLSLCompile %d %d", COMPILE_MANIFEST_VERSION, SHADER_TRANSLATOR_RULES_VERSION);
+			if (line != header)
+				return;
+			first = false;
+			continue;
+		}
+
+		splitTabs(line, fields);
+		if (fields.size() < 2 || fields.size() % 2 != 0)
+			continue;
+		ManifestEntry &entry = manifest[fields[0]];
+		entry.configuration = strtoull(fields[1].c_str(), nullptr, 16);
+		for (size_t i = 2; i < fields.size(); i += 2)
+			entry.files.emplace_back(fields[i], strtoull(fields[i + 1].c_str(), nullptr, 16));
+	}
+}
+
+static bool writeManifest(const std::string &path, const Manifest &manifest) {
+	std::vector<const Manifest::value_type *> entries;
+	for (const auto &entry : manifest)
+		entries.push_back(&entry);
+	std::sort(entries.begin(), entries.end(), [](const Manifest::value_type *a, const Manifest::value_type *b) {
+		return a->first < b->first;
+	});
+
+	char number[32];
+	std::string text = "GLSLCompile " + std::to_string(COMPILE_MANIFEST_VERSION) + " " + std::to_string(SHADER_TRANSLATOR_RULES_VERSION) + "\n";
+	for (const auto *entry : entries) {
+		snprintf(number, sizeof(number), "%016llx", static_cast<unsigned long long>(entry->second.configuration));
+		text += entry->first + '\t' + number;
+		for (const auto &file : entry->second.files) {
+			snprintf(number, sizeof(number), "%016llx", static_cast<unsigned long long>(file.second));
+			text += '\t' + file.first + '\t' + number;
+		}
+		text += '\n';
+	}
+	return shaderWriteFileAtomic(path, text.data(), text.length());
+}
+
+//------------------------------------------------------------------------------
+// Dependency file, one Makefile rule per output.
+//------------------------------------------------------------------------------
+
+static std::string escapeMakePath(const std::string &path) {
+	std::string escaped;
+	for (char c : path) {
+		if (c == ' ' || c == '#')
+			escaped += '\\';
+		else if (c == '$')
+			escaped += '$';
+		escaped += c;
+	}
+	return escaped;
+}
+
+static bool writeDepfile(const std::string &path, const std::string &outputDir, const Manifest &manifest) {
+	std::vector<const Manifest::value_type *> entries;
+	for (const auto &entry : manifest)
+		entries.push_back(&entry);
+	std::sort(entries.begin(), entries.end(), [](const Manifest::value_type *a, const Manifest::value_type *b) {
+		return a->first < b->first;
+	});
+
+	std::string text;
+	for (const auto *entry : entries) {
+		text += escapeMakePath((fs::path(outputDir) / entry->first).generic_string()) + ':';
+		// Missing includes only stay in the manifest, since make stops at a
+		// prerequisite it has no rule for.
+		for (const auto &file : entry->second.files) {
+			if (file.second != 0)
+				text += ' ' + escapeMakePath(file.first);
+		}
+		text += '\n';
+	}
+	return shaderWriteFileAtomic(path, text.data(), text.length());
+}
+
+//------------------------------------------------------------------------------
+// Compiling
+//------------------------------------------------------------------------------
+
+struct CompileShader {
+	size_t root;
+	std::string name;
+	ShaderTranslator::ShaderType shaderType;
+};
+
+struct CompileJob {
+	const CompileShader *shader;
+	ShaderTranslator::ShaderBackend backend;
+	std::string output;
+};
+
+struct CompileResult {
+	enum Status {
+		UP_TO_DATE,
+		TRANSLATED,
+		FAILED
+	};
+
+	Status status;
+	ManifestEntry entry;
+};
+
+static bool getShaderType(const fs::path &path, ShaderTranslator::ShaderType &shaderType) {
+	std::string extension = path.extension().string();
+	if (extension == ".vert" || extension == ".vs" || extension == ".vsh") {
+		shaderType = ShaderTranslator::VERTEX;
+		return true;
+	}
+	if (extension == ".frag" || extension == ".fs" || extension == ".fsh") {
+		shaderType = ShaderTranslator::FRAGMENT;
+		return true;
+	}
+	return false;
+}
+
+static const char *getBackendName(ShaderTranslator::ShaderBackend backend) {
+	return (backend == ShaderTranslator::GL21) ? "gl21" : "gl33";
+}
+
+/**
+ * Hashes the input files, each one only once however many outputs use it.
+ * Files that do not exist hash to 0.
+ */
+class CompileFileHashes {
+public:
+	uint64_t get(const std::string &path) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mHashes.find(path);
+			if (it != mHashes.end())
+				return it->second;
+		}
+
+		uint64_t hash = 0;
+		ShaderMappedFile file;
+		// The low bit is set so that no file that exists hashes to 0.
+		if (file.open(path))
+			hash = shaderHash64(file.getData(), file.getSize()) | 1;
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mHashes.emplace(path, hash);
+		return hash;
+	}
+
+private:
+	std::mutex mMutex;
+	std::unordered_map<std::string, uint64_t> mHashes;
+};
+
+static bool isUpToDate(const Manifest &manifest, const CompileJob &job, uint64_t configuration, const std::string &outputPath, CompileFileHashes &hashes) {
+	auto it = manifest.find(job.output);
+	if (it == manifest.end() || it->second.configuration != configuration || it->second.files.empty())
+		return false;
+
+	std::error_code error;
+	if (!fs::exists(outputPath, error))
+		return false;
+	for (const auto &file : it->second.files) {
+		if (hashes.get(file.first) != file.second)
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, const char * argv[]) {
+	CompileOptions options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Find every shader below the input directories.
+	std::vector<CompileShader> shaders;
+	std::vector<std::unique_ptr<ShaderDirectoryFileProvider>> providers;
+	std::vector<std::string> roots;
+	for (size_t root = 0; root < options.inputs.size(); root++) {
+		fs::path dir(options.inputs[root]);
+		std::error_code error;
+		if (!fs::is_directory(dir, error)) {
+			fprintf(stderr, "%s is not a directory\n", options.inputs[root].c_str());
+			return 1;
+		}
+		roots.push_back(dir.lexically_normal().generic_string());
+		providers.emplace_back(new ShaderDirectoryFileProvider(roots.back()));
+
+		for (fs::recursive_directory_iterator it(dir, error), end; it != end; it.increment(error)) {
+			ShaderTranslator::ShaderType shaderType;
+			if (it->is_regular_file(error) && getShaderType(it->path(), shaderType))
+				shaders.push_back({ root, it->path().lexically_relative(dir).generic_string(), shaderType });
+		}
+	}
+	std::sort(shaders.begin(), shaders.end(), [](const CompileShader &a, const CompileShader &b) {
+		return (a.root != b.root) ? a.root < b.root : a.name < b.name;
+	});
+
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	gl21.setMinify(options.minify, options.minifyMap);
+	gl33.setMinify(options.minify, options.minifyMap);
+	gl21.setReflection(options.reflect);
+	gl33.setReflection(options.reflect);
+	gl33.setExplicitLocations(options.locations);
+	const ShaderTranslator *translators[SHADER_BACKEND_COUNT] = { &gl21, &gl33 };
+
+	std::vector<CompileJob> jobs;
+	std::unordered_set<std::string> outputs;
+	for (const CompileShader &shader : shaders) {
+		for (int backend = 0; backend < SHADER_BACKEND_COUNT; backend++) {
+			if (!options.backends[backend])
+				continue;
+			std::string output = std::string(getBackendName(static_cast<ShaderTranslator::ShaderBackend>(backend))) + '/' + shader.name;
+
+			// Two input directories can have a shader with the same name.
+			if (!outputs.insert(output).second) {
+				fprintf(stderr, "%s is in more than one input directory\n", shader.name.c_str());
+				return 1;
+			}
+			jobs.push_back({ &shader, static_cast<ShaderTranslator::ShaderBackend>(backend), output });
+		}
+	}
+
+	Manifest oldManifest;
+	readManifest(options.manifest, oldManifest);
+
+	// Every thread gets its own include translators, one per input directory,
+	// since they keep the files they translated.
+	ShaderThreadPool pool(options.jobs);
+	std::vector<std::vector<std::unique_ptr<ShaderIncludeTranslator>>> includes(pool.getWorkerCount());
+	for (auto &worker : includes) {
+		for (const auto &provider : providers)
+			worker.emplace_back(new ShaderIncludeTranslator(*provider));
+	}
+
+	CompileFileHashes hashes;
+	std::vector<CompileResult> results(jobs.size());
+	std::mutex printMutex;
+	pool.parallelFor(jobs.size(), [&](size_t index, unsigned worker) {
+		const CompileJob &job = jobs[index];
+		const CompileShader &shader = *job.shader;
+		const ShaderTranslator &translator = *translators[job.backend];
+		CompileResult &result = results[index];
+		std::string outputPath = (fs::path(options.output) / job.output).string();
+		uint64_t configuration = translator.getConfigurationHash();
+		if (!options.force && isUpToDate(oldManifest, job, configuration, outputPath, hashes)) {
+			result.status = CompileResult::UP_TO_DATE;
+			result.entry = oldManifest.find(job.output)->second;
+			return;
+		}
+
+		result.status = CompileResult::FAILED;
+		auto translated = includes[worker][shader.root]->translate(translator, shader.name, shader.shaderType);
+		std::error_code error;
+		fs::create_directories(fs::path(outputPath).parent_path(), error);
+		if (!translated || !shaderWriteFileAtomic(outputPath, translated->source.data(), translated->source.length())) {
+			std::lock_guard<std::mutex> lock(printMutex);
+			fprintf(stderr, "error: could not %s %s\n", translated ? "write" : "read", translated ? outputPath.c_str() : shader.name.c_str());
+			return;
+		}
+
+		// Missing includes are recorded too, so adding them rebuilds the shader.
+		const std::string &root = roots[shader.root];
+		result.entry.configuration = configuration;
+		for (const auto *files : { &translated->files, &translated->missing }) {
+			for (const std::string &file : *files) {
+				std::string path = root + '/' + file;
+				result.entry.files.emplace_back(path, hashes.get(path));
+			}
+		}
+		result.status = CompileResult::TRANSLATED;
+
+		if (options.verbose) {
+			std::lock_guard<std::mutex> lock(printMutex);
+			printf("%s\n", outputPath.c_str());
+		}
+	});
+
+	Manifest manifest;
+	size_t translated = 0;
+	size_t upToDate = 0;
+	size_t failed = 0;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		switch (results[i].status) {
+		case CompileResult::UP_TO_DATE:
+			upToDate++;
+			break;
+		case CompileResult::TRANSLATED:
+			translated++;
+			break;
+		default:
+			failed++;
+			continue;
+		}
+		manifest.emplace(jobs[i].output, std::move(results[i].entry));
+	}
+
+	// Remove the outputs of shaders that no longer exist. The outputs of
+	// backends that were left out this time, and of jobs that failed, keep
+	// their old entries so they are neither lost nor taken for up to date.
+	std::unordered_set<std::string> names;
+	for (const CompileShader &shader : shaders)
+		names.insert(shader.name);
+	size_t removed = 0;
+	for (auto &entry : oldManifest) {
+		if (manifest.count(entry.first))
+			continue;
+		size_t slash = entry.first.find('/');
+		if (slash != std::string::npos && names.count(entry.first.substr(slash + 1))) {
+			manifest.emplace(entry.first, std::move(entry.second));
+			continue;
+		}
+		std::error_code error;
+		if (fs::remove(fs::path(options.output) / entry.first, error))
+			removed++;
+	}
+
+	if (!writeManifest(options.manifest, manifest)) {
+		fprintf(stderr, "error: could not write %s\n", options.manifest.c_str());
+		return 1;
+	}
+	if (!options.depfile.empty() && !writeDepfile(options.depfile, options.output, manifest)) {
+		fprintf(stderr, "error: could not write %s\n", options.depfile.c_str());
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("GLSLCompile: %zu translated, %zu up to date, %zu removed, %zu failed in %.2f s on %u threads\n",
+		translated, upToDate, removed, failed, seconds, pool.getWorkerCount());
+	return failed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <string>
+#include "glslTest.h"
+#include "shaderConstexprTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+// Outputs that are known exactly are checked by the compiler already.
+static_assert(SHADER_TRANSLATE_CONSTEXPR(GL21, VERTEX, "").view() == SHADER_GL21_HEADER, "An empty GL21 shader is only the header.");
+static_assert(SHADER_TRANSLATE_CONSTEXPR(GL33, FRAGMENT, "").view() == SHADER_GL33_FRAGMENT_HEADER, "An empty GL33 fragment shader is only the header.");
+static_assert(SHADER_TRANSLATE_CONSTEXPR(GL33, VERTEX, "texture2DLod(s, uv, 0.0);").view() ==
+	"#version 330 core\n#define GL33\n\ntextureLod(s, uv, 0.0);", "texture2DLod( is a call.");
+static_assert(SHADER_TRANSLATE_CONSTEXPR(GL33, VERTEX, "texture2DLodX(s, uv, 0.0);").view() ==
+	"#version 330 core\n#define GL33\n\ntexture2DLodX(s, uv, 0.0);", "texture2DLodX is another identifier.");
+static_assert(SHADER_TRANSLATE_CONSTEXPR(GL33, FRAGMENT, "// varying vec2 uv;\n/* gl_FragColor */ varying vec2 uv;").view() ==
+	"#version 330 core\n#define GL33\n\nout vec4 " SHADER_GL33_FRAG_OUTPUT ";\n\n// varying vec2 uv;\n/* gl_FragColor */ in vec2 uv;", "Comments are kept as they are.");
+
+/**
+ * Checks that a string literal translates the same at compile time as at
+ * runtime, for every backend and shader type.
+ */
+#define CHECK_CONSTEXPR(source) \
+	do { \
+		static constexpr auto vertex21 = SHADER_TRANSLATE_CONSTEXPR(GL21, VERTEX, source); \
+		static constexpr auto fragment21 = SHADER_TRANSLATE_CONSTEXPR(GL21, FRAGMENT, source); \
+		static constexpr auto vertex33 = SHADER_TRANSLATE_CONSTEXPR(GL33, VERTEX, source); \
+		static constexpr auto fragment33 = SHADER_TRANSLATE_CONSTEXPR(GL33, FRAGMENT, source); \
+		TEST_CHECK_EQUAL(vertex21.view(), gl21.translate(source, ShaderTranslator::VERTEX)); \
+		TEST_CHECK_EQUAL(fragment21.view(), gl21.translate(source, ShaderTranslator::FRAGMENT)); \
+		TEST_CHECK_EQUAL(vertex33.view(), gl33.translate(source, ShaderTranslator::VERTEX)); \
+		TEST_CHECK_EQUAL(fragment33.view(), gl33.translate(source, ShaderTranslator::FRAGMENT)); \
+		TEST_CHECK(vertex21.c_str()[vertex21.length()] == '\0'); \
+	} while (0)
+
+int main(int argc, const char *argv[]) {
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+
+	// The shaders of GLSLTest.
+	CHECK_CONSTEXPR("// blah blah blah\n\nattribute vec3 pos;\nvarying vec3 col;\nvarying vec2 uv;\nuniform vec4 mvp;\nvoid main() {\n   gl_Position = vec4(pos, 1) * mvp;\n   col = vec4(1.0f, 0.0f, 0.0f, 1.0f);\n   uv = vec2(0, 0);\n}\n");
+	CHECK_CONSTEXPR("varying vec4 col;\nvarying vec2 uv;\nuniform sampler2D diffuseTexture;\nvoid main() {\n   gl_FragColor = texture2D(diffuseTexture, uv) * color;\n}\n");
+
+	// Empty input.
+	CHECK_CONSTEXPR("");
+
+	// Comments, including ones that hold keywords and ones that never end.
+	CHECK_CONSTEXPR("// varying vec2 uv;\nvarying vec2 uv; /* texture2D(s, uv) */\nattribute vec3 pos;\n");
+	CHECK_CONSTEXPR("/* varying\n   gl_FragColor */ gl_FragColor = vec4(1);\n//");
+	CHECK_CONSTEXPR("varying vec2 uv;\n/* never ends\nvarying vec2 uv;");
+	CHECK_CONSTEXPR("varying/**/vec2 uv;//varying\ngl_FragColor/*x*/=texture2D/*y*/(s, uv);");
+
+	// Calls, and identifiers that only start like one.
+	CHECK_CONSTEXPR("texture2DLod(s, uv, 0.0); texture2DLodX(s, uv, 0.0); texture2DLod_(s); xtexture2D(s, uv);");
+	CHECK_CONSTEXPR("vec4 texture2D = texture2D(s, uv); float shadow2DProjLod; shadow2DProjLod(s, uv, 0.0);");
+
+	// Whitespace between a call and its '('.
+	CHECK_CONSTEXPR("texture2D (s, uv); texture2D\t(s, uv); texture2D\n(s, uv); texture2D/**/(s, uv);");
+
+	// Numbers, operators and identifiers at the very end of the input.
+	CHECK_CONSTEXPR("float f = 1.0e-3f + 0x1F + .5;\nvec2 v = a.xy-b.yx;\ngl_FragColor");
+	CHECK_CONSTEXPR("texture2D");
+
+	return testFinish("GLSLConstexprTest");
+}
\ No newline at end of file
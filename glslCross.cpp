@@ -30,7 +30,7 @@
 
 #include <iostream>
 #include <string>
-#include <memory>
+#include "shaderBatchTranslator.h"
 #include "shaderTranslator.h"
 #include "shaderTranslatorGL21.h"
 #include "shaderTranslatorGL33.h"
@@ -40,33 +40,47 @@ int main(int argc, const char * argv[]) {
 	const std::string frag = "varying vec4 col;\nvarying vec2 uv;\nuniform sampler2D diffuseTexture;\nvoid main() {\n   gl_FragColor = texture2D(diffuseTexture, uv) * color;\n}\n";
 	
 	{
+		// Translators keep no state, so one translator handles every shader.
+		ShaderTranslatorGL21 translator;
+
 		// test vertex shader translation from base shader to GLSL 120
-		auto vertexTranslator = std::make_unique<ShaderTranslatorGL21>();
-		const auto &translatedSource = vertexTranslator->translate(vertex, ShaderTranslator::ShaderType::VERTEX);
+		const auto translatedSource = translator.translate(vertex, ShaderTranslator::ShaderType::VERTEX);
 		printf("%s\n", translatedSource.c_str());
 
-		// test vertex shader translation from base shader to GLSL 120
-		auto fragmentTranslator = std::make_unique<ShaderTranslatorGL21>();
-		const auto &translatedFragSource = fragmentTranslator->translate(frag, ShaderTranslator::ShaderType::FRAGMENT);
+		// test fragment shader translation from base shader to GLSL 120
+		const auto translatedFragSource = translator.translate(frag, ShaderTranslator::ShaderType::FRAGMENT);
 		printf("%s\n", translatedFragSource.c_str());
 	}
 
 	printf("\nAnd Now we test OpenGL 3.3 core profile!\n\n");
 
 	{
+		ShaderTranslatorGL33 translator;
+
 		// test vertex shader translation from base shader to GLSL 330 core profile
-		auto vertexTranslator = std::make_unique<ShaderTranslatorGL33>();
-		const auto &translatedSource = vertexTranslator->translate(vertex, ShaderTranslator::ShaderType::VERTEX);
+		const auto translatedSource = translator.translate(vertex, ShaderTranslator::ShaderType::VERTEX);
 		printf("%s\n", translatedSource.c_str());
 
-		// test vertex shader translation from base shader to GLSL 330 core profile
-		auto fragmentTranslator = std::make_unique<ShaderTranslatorGL33>();
-		const auto &translatedFragSource = fragmentTranslator->translate(frag, ShaderTranslator::ShaderType::FRAGMENT);
+		// test fragment shader translation from base shader to GLSL 330 core profile
+		const auto translatedFragSource = translator.translate(frag, ShaderTranslator::ShaderType::FRAGMENT);
 		printf("%s\n", translatedFragSource.c_str());
 	}
 
+	{
+		// test translating every shader for every backend at once.
+		ShaderBatchTranslator batch;
+		std::vector<ShaderBatchJob> jobs = {
+			{ vertex, ShaderTranslator::VERTEX, ShaderTranslator::GL21 },
+			{ frag, ShaderTranslator::FRAGMENT, ShaderTranslator::GL21 },
+			{ vertex, ShaderTranslator::VERTEX, ShaderTranslator::GL33 },
+			{ frag, ShaderTranslator::FRAGMENT, ShaderTranslator::GL33 }
+		};
+		const auto shaders = batch.translateBatch(jobs);
+		printf("\nBatch translated %d shaders on %u threads.\n", static_cast<int>(shaders.size()), batch.getWorkerCount());
+	}
+
 #ifdef _WIN32
 	system("PAUSE");
 #endif
 	return 0;
-}
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "shaderTranslatorGL33.h"
+
+// Measures the cost of deciding the rewrite of a single token, comparing the
+// old chain of string compares and substring searches against the perfect
+// hash rewrite tables.
+
+#define DISPATCH_BENCH_REPEAT 200
+
+static const char *SAMPLE_LINES[] = {
+	"attribute vec3 inPosition;\n",
+	"attribute vec2 inTexCoord;\n",
+	"varying vec2 texCoord;\n",
+	"varying vec3 worldNormal;\n",
+	"uniform sampler2D diffuseTexture;\n",
+	"uniform mat4 modelViewProjection;\n",
+	"vec4 albedo = texture2D(diffuseTexture, texCoord) * tint;\n",
+	"vec4 lod = texture2DLod(diffuseTexture, texCoord, 2.0);\n",
+	"float lit = max(dot(worldNormal, lightDirection), 0.0);\n",
+	"gl_FragColor = vec4(albedo.rgb * lit, albedo.a);\n",
+	"gl_Position = modelViewProjection * vec4(inPosition, 1.0);\n",
+	"vec3 mytextureLookup = sampleNormal(texCoord);\n"
+};
+
+struct DispatchToken {
+	std::string text;
+	std::string next;
+	std::string_view view;
+	char nextCharacter;
+};
+
+// The rules as they were written before the rewrite tables, kept here as the
+// baseline of the benchmark.
+static const char *legacyVertex(const std::string &tok, const std::string &next) {
+	if (tok == "attribute")
+		return "in";
+	else if (tok == "varying")
+		return "out";
+	else if (tok.find("texture") != std::string::npos && next == "(")
+		return "texture";
+	return nullptr;
+}
+
+static const char *legacyFragment(const std::string &tok, const std::string &next) {
+	if (tok.find("gl_") != std::string::npos) {
+		if (tok == "gl_FragColor")
+			return "GEN_OUTPUT_FINAL_COLOR";
+	} else if (tok == "varying") {
+		return "in";
+	} else if (tok.find("texture") != std::string::npos && next == "(") {
+		return "texture";
+	}
+	return nullptr;
+}
+
+static double nanosecondsPerToken(std::chrono::steady_clock::duration elapsed, size_t tokens) {
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(tokens);
+}
+
+int main(int argc, const char * argv[]) {
+	std::string source;
+	for (int i = 0; i < 500; i++)
+		for (const char *line : SAMPLE_LINES)
+			source += line;
+
+	// Only identifiers go through the rewrite rules.
+	ShaderTranslationContext context;
+	context.tokenize(source);
+	const ShaderTokenList &tokens = context.getTokens();
+	std::vector<DispatchToken> identifiers;
+	for (size_t i = 0; i < tokens.size(); i++) {
+		if (tokens[i].kind != ShaderToken::IDENTIFIER)
+			continue;
+		DispatchToken tok;
+		tok.view = context.getTokenText(tokens[i]);
+		tok.text = std::string(tok.view);
+		tok.next = (i + 1 < tokens.size()) ? std::string(context.getTokenText(tokens[i + 1])) : std::string();
+		tok.nextCharacter = context.getNextCharacter(i);
+		identifiers.push_back(tok);
+	}
+
+	ShaderTranslatorGL33 translator;
+	const ShaderTranslator::ShaderType types[] = { ShaderTranslator::VERTEX, ShaderTranslator::FRAGMENT };
+	const char *names[] = { "vertex", "fragment" };
+	size_t total = identifiers.size() * DISPATCH_BENCH_REPEAT;
+
+	printf("%zu identifier tokens, %d passes\n", identifiers.size(), DISPATCH_BENCH_REPEAT);
+	for (int t = 0; t < 2; t++) {
+		size_t legacyHits = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < DISPATCH_BENCH_REPEAT; r++) {
+			for (const auto &tok : identifiers) {
+				const char *rep = (types[t] == ShaderTranslator::VERTEX) ? legacyVertex(tok.text, tok.next) : legacyFragment(tok.text, tok.next);
+				legacyHits += (rep != nullptr);
+			}
+		}
+		auto legacy = std::chrono::steady_clock::now() - start;
+
+		const ShaderRewriteTable &table = translator.getRewriteTable(types[t]);
+		size_t tableHits = 0;
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < DISPATCH_BENCH_REPEAT; r++) {
+			for (const auto &tok : identifiers)
+				tableHits += !table.rewrite(tok.view, tok.nextCharacter).empty();
+		}
+		auto hashed = std::chrono::steady_clock::now() - start;
+
+		printf("%-8s  compare chain: %6.2f ns/token (%zu rewrites)  rewrite table: %6.2f ns/token (%zu rewrites)\n",
+			names[t], nanosecondsPerToken(legacy, total), legacyHits, nanosecondsPerToken(hashed, total), tableHits);
+	}
+	return 0;
+}
\ No newline at end of file
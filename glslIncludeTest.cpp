@@ -0,0 +1,227 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "glslTest.h"
+#include "shaderFileProvider.h"
+#include "shaderIncludeTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * Counts how often some text appears in a shader.
+ */
+static size_t countText(const std::string &source, const std::string &text) {
+	size_t count = 0;
+	for (size_t pos = source.find(text); pos != std::string::npos; pos = source.find(text, pos + text.length()))
+		count++;
+	return count;
+}
+
+/**
+ * Checks that quoted includes are found next to the including file, and
+ * that a file two others include is spliced in once.
+ */
+static void testNestedAndDiamond() {
+	ShaderMemoryFileProvider files;
+	files.setFile("shaders/mesh.frag",
+		"#include \"lib/a.glsl\"\n"
+		"#include \"lib/b.glsl\"\n"
+		"void main() {\n"
+		"\tgl_FragColor = a() + b();\n"
+		"}\n");
+	files.setFile("shaders/lib/a.glsl",
+		"#include \"common.glsl\"\n"
+		"vec4 a() { return common(); }\n");
+	files.setFile("shaders/lib/b.glsl",
+		"#include \"../lib/./common.glsl\"\n"
+		"vec4 b() { return common(); }\n");
+	files.setFile("shaders/lib/common.glsl",
+		"uniform vec4 color;\n"
+		"vec4 common() { return color; }\n");
+	// Only found if the include were looked up from the root.
+	files.setFile("common.glsl", "vec4 wrong() { return vec4(0.0); }\n");
+
+	ShaderTranslatorGL33 gl33;
+	ShaderIncludeTranslator includes(files);
+	auto shader = includes.translate(gl33, "shaders/mesh.frag", ShaderTranslator::FRAGMENT);
+	TEST_CHECK(shader != nullptr);
+	if (!shader)
+		return;
+
+	const std::string expected =
+		std::string(gl33.getHeader(ShaderTranslator::FRAGMENT)) +
+		"#line 0 0\n"
+		"#line 0 1\n"
+		"#line 0 2\n"
+		"uniform vec4 color;\n"
+		"vec4 common() { return color; }\n"
+		"#line 1 1\n"
+		"vec4 a() { return common(); }\n"
+		"#line 1 0\n"
+		"#line 0 3\n"
+		"\n"
+		"vec4 b() { return common(); }\n"
+		"#line 2 0\n"
+		"void main() {\n"
+		"\tGEN_OUTPUT_FINAL_COLOR = a() + b();\n"
+		"}\n";
+	TEST_CHECK_EQUAL(shader->source, expected);
+	TEST_CHECK((shader->files == std::vector<std::string>{ "shaders/mesh.frag", "shaders/lib/a.glsl", "shaders/lib/common.glsl", "shaders/lib/b.glsl" }));
+	TEST_CHECK(shader->missing.empty());
+	TEST_CHECK(countText(shader->source, "uniform vec4 color;") == 1);
+	TEST_CHECK(countText(shader->source, "wrong") == 0);
+
+	// Both paths to the shared file lead to the shader.
+	TEST_CHECK((includes.getDependents("shaders/lib/common.glsl") == std::vector<std::string>{ "shaders/mesh.frag" }));
+	TEST_CHECK(includes.getDependents("common.glsl").empty());
+	TEST_CHECK((includes.invalidate("shaders/lib/common.glsl") == std::vector<std::string>{ "shaders/mesh.frag" }));
+}
+
+/**
+ * Checks that quoted includes fall back to the root, that angled includes
+ * only look there, and that every place a missing file was looked for is
+ * reported.
+ */
+static void testRootLookup() {
+	ShaderMemoryFileProvider files;
+	files.setFile("shaders/mesh.vert",
+		"#include \"shared.glsl\"\n"
+		"#include <lib/util.glsl>\n"
+		"#include \"missing.glsl\"\n"
+		"void main() {}\n");
+	files.setFile("shared.glsl", "float shared() { return 1.0; }\n");
+	files.setFile("lib/util.glsl", "float util() { return 2.0; }\n");
+	files.setFile("shaders/lib/util.glsl", "float wrong() { return 0.0; }\n");
+
+	ShaderTranslatorGL21 gl21;
+	ShaderIncludeTranslator includes(files);
+	auto shader = includes.translate(gl21, "shaders/mesh.vert", ShaderTranslator::VERTEX);
+	TEST_CHECK(shader != nullptr);
+	if (!shader)
+		return;
+
+	TEST_CHECK((shader->files == std::vector<std::string>{ "shaders/mesh.vert", "shared.glsl", "lib/util.glsl" }));
+	// Every place a name was looked for without finding it is missing,
+	// including those next to the shader that fell back to the root.
+	TEST_CHECK((shader->missing == std::vector<std::string>{ "shaders/shared.glsl", "shaders/missing.glsl", "missing.glsl" }));
+	TEST_CHECK(countText(shader->source, "float shared()") == 1);
+	TEST_CHECK(countText(shader->source, "float util()") == 1);
+	TEST_CHECK(countText(shader->source, "wrong") == 0);
+	TEST_CHECK(countText(shader->source, "#include \"missing.glsl\"") == 1);
+
+	// Adding the missing file at any of those places rebuilds the shader.
+	TEST_CHECK((includes.getDependents("missing.glsl") == std::vector<std::string>{ "shaders/mesh.vert" }));
+	TEST_CHECK((includes.getDependents("shaders/shared.glsl") == std::vector<std::string>{ "shaders/mesh.vert" }));
+	TEST_CHECK((includes.invalidate("missing.glsl") == std::vector<std::string>{ "shaders/mesh.vert" }));
+	TEST_CHECK(includes.getDependents("shaders/missing.glsl").empty());
+
+	shader = includes.translate(gl21, "shaders/mesh.vert", ShaderTranslator::VERTEX);
+	TEST_CHECK(shader != nullptr);
+	TEST_CHECK((includes.invalidate("shaders/missing.glsl") == std::vector<std::string>{ "shaders/mesh.vert" }));
+}
+
+/**
+ * Checks that files that include each other are spliced in once each.
+ */
+static void testCycle() {
+	ShaderMemoryFileProvider files;
+	files.setFile("a.glsl", "#include \"b.glsl\"\nfloat a() { return 1.0; }\n");
+	files.setFile("b.glsl", "#include \"a.glsl\"\nfloat b() { return 2.0; }\n");
+	files.setFile("mesh.frag", "#include \"a.glsl\"\n#include \"b.glsl\"\nvoid main() {}\n");
+
+	ShaderTranslatorGL21 gl21;
+	ShaderIncludeTranslator includes(files);
+	auto shader = includes.translate(gl21, "mesh.frag", ShaderTranslator::FRAGMENT);
+	TEST_CHECK(shader != nullptr);
+	if (!shader)
+		return;
+
+	TEST_CHECK((shader->files == std::vector<std::string>{ "mesh.frag", "a.glsl", "b.glsl" }));
+	TEST_CHECK(countText(shader->source, "float a()") == 1);
+	TEST_CHECK(countText(shader->source, "float b()") == 1);
+	TEST_CHECK(countText(shader->source, "#include") == 0);
+}
+
+/**
+ * Writes a file for the directory provider.
+ */
+static void writeFile(const std::filesystem::path &path, const std::string &source) {
+	std::ofstream file(path, std::ios::binary);
+	file << source;
+}
+
+/**
+ * Checks that includes can not read files outside of the directory a
+ * directory provider reads from.
+ */
+static void testDirectoryRoot() {
+	std::filesystem::path base = std::filesystem::temp_directory_path() / "glslIncludeTest";
+	std::error_code error;
+	std::filesystem::remove_all(base, error);
+	std::filesystem::create_directories(base / "root" / "shaders", error);
+	writeFile(base / "secret.glsl", "float secret() { return 0.0; }\n");
+	writeFile(base / "root" / "common.glsl", "float common() { return 1.0; }\n");
+	writeFile(base / "root" / "shaders" / "mesh.frag",
+		"#include \"../common.glsl\"\n"
+		"#include \"../../secret.glsl\"\n"
+		"#include <../secret.glsl>\n"
+		"void main() {}\n");
+
+	ShaderDirectoryFileProvider files((base / "root").string());
+	std::string source;
+	TEST_CHECK(files.readFile("shaders/../common.glsl", source));
+	TEST_CHECK(!files.readFile("../secret.glsl", source));
+	TEST_CHECK(!files.readFile("shaders/../../secret.glsl", source));
+	TEST_CHECK(!files.readFile((base / "secret.glsl").generic_string(), source));
+
+	ShaderTranslatorGL21 gl21;
+	ShaderIncludeTranslator includes(files);
+	auto shader = includes.translate(gl21, "shaders/mesh.frag", ShaderTranslator::FRAGMENT);
+	TEST_CHECK(shader != nullptr);
+	if (shader) {
+		TEST_CHECK((shader->files == std::vector<std::string>{ "shaders/mesh.frag", "common.glsl" }));
+		TEST_CHECK(shader->missing.empty());
+		TEST_CHECK(countText(shader->source, "float common()") == 1);
+		TEST_CHECK(countText(shader->source, "secret()") == 0);
+	}
+	std::filesystem::remove_all(base, error);
+}
+
+int main(int argc, const char *argv[]) {
+	testNestedAndDiamond();
+	testRootLookup();
+	testCycle();
+	testDirectoryRoot();
+	return testFinish("GLSLIncludeTest");
+}
\ No newline at end of file
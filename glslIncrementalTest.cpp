@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <random>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderIncrementalTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * Text that edits insert, picked to split, join and create tokens that
+ * are rewritten, as well as comments and conditionals.
+ */
+static const char *const EDIT_TEXTS[] = {
+	"texture2D", "texture2D(", "gl_FragColor", "attribute", "varying", "texture",
+	"2D", "gl_", "(", ")", " ", "\n", "\t", ";", "/", "*", "/*", "*/", "//",
+	"#ifdef GL21\n", "#ifdef GL33\n", "#else\n", "#endif\n", "#if 0\n", "\\\n",
+	"vec4 c = texture2D(tex, uv);\n", "x", "_", "0"
+};
+
+/**
+ * Applies random edits to a shader and checks after every one that the
+ * incremental output is the output of translating the edited source.
+ */
+static void testEdits(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType, const std::string &source, std::mt19937 &rng, int edits) {
+	ShaderIncrementalTranslator shader(translator, shaderType);
+	std::string expected = source;
+	TEST_CHECK_EQUAL(shader.translate(source), translator.translate(source, shaderType));
+
+	for (int i = 0; i < edits; i++) {
+		size_t offset = expected.empty() ? 0 : rng() % (expected.length() + 1);
+		size_t length = 0;
+		if (rng() % 2 && offset < expected.length())
+			length = rng() % std::min<size_t>(expected.length() - offset + 1, 24);
+
+		std::string text;
+		if (rng() % 4)
+			text = EDIT_TEXTS[rng() % (sizeof(EDIT_TEXTS) / sizeof(EDIT_TEXTS[0]))];
+		else if (length)
+			text = expected.substr(rng() % expected.length(), rng() % 16);
+
+		expected.replace(offset, length, text);
+		shader.edit(offset, length, text);
+		TEST_CHECK_EQUAL(shader.getSource(), expected);
+		TEST_CHECK_EQUAL(shader.getOutput(), translator.translate(expected, shaderType));
+	}
+}
+
+int main(int argc, const char *argv[]) {
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslatorGL33 preprocessed;
+	preprocessed.setPreprocessing(true);
+	const ShaderTranslator *translators[] = { &gl21, &gl33, &preprocessed };
+
+	std::vector<BenchShader> shaders = generateBenchCorpus(true);
+	shaders.push_back({ "small", BENCH_PROFILE_MIXED, ShaderTranslator::FRAGMENT,
+		"uniform sampler2D tex;\nvarying vec2 uv;\n#ifdef GL21\nvoid main() { gl_FragColor = texture2D(tex, uv); }\n#else\nvoid main() { gl_FragColor = texture(tex, uv); }\n#endif\n" });
+	shaders.push_back({ "empty", BENCH_PROFILE_MIXED, ShaderTranslator::VERTEX, "" });
+
+	std::mt19937 rng(12);
+	for (const ShaderTranslator *translator : translators) {
+		for (const BenchShader &shader : shaders) {
+			// Small shaders take many more edits, so that they end up
+			// nothing like where they started.
+			int edits = (shader.source.length() < 4096) ? 400 : 60;
+			testEdits(*translator, shader.shaderType, shader.source, rng, edits);
+		}
+	}
+	return testFinish("GLSLIncrementalTest");
+}
\ No newline at end of file
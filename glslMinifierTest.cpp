@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include "glslTest.h"
+#include "shaderMinifier.h"
+
+/**
+ * Minifies a shader.
+ * @param nameMap Set to append the name map comments.
+ */
+static std::string minify(ShaderMinifier &minifier, std::string shader, bool nameMap = false) {
+	minifier.minify(shader, nameMap);
+	return shader;
+}
+
+int main(int argc, const char *argv[]) {
+	ShaderMinifier minifier;
+
+	// A local that shadows another gets the same short name, and so does a
+	// parameter of another function that is spelled the same.
+	TEST_CHECK_EQUAL(minify(minifier,
+		"float scaled(float amount) {\n"
+		"\tfloat result = amount;\n"
+		"\t{\n"
+		"\t\tfloat result = 2.0;\n"
+		"\t\tresult += amount;\n"
+		"\t}\n"
+		"\treturn result;\n"
+		"}\n"
+		"float other(float result) { return result * 2.0; }\n"
+		"void main() { gl_Position = vec4(scaled(1.0) + other(2.0)); }\n"),
+		"float c(float b){float a=b;{float a=2.0;a+=b;}return a;}float d(float a){return a*2.0;}void main(){gl_Position=vec4(c(1.0)+d(2.0));}\n");
+
+	// Names that a macro uses are kept everywhere, and the directives keep
+	// their lines.
+	TEST_CHECK_EQUAL(minify(minifier,
+		"#define SCALE(v) (v * brightness)\n"
+		"uniform float strength;\n"
+		"float brightness = 2.0;\n"
+		"float other = 3.0;\n"
+		"void main() { gl_FragColor = vec4(SCALE(other) * strength); }\n"),
+		"#define SCALE(v) (v * brightness)\n"
+		"uniform float strength;float brightness=2.0;float a=3.0;void main(){gl_FragColor=vec4(SCALE(a)*strength);}\n");
+	TEST_CHECK_EQUAL(minify(minifier,
+		"#ifdef FAST\n"
+		"#define STEPS count\n"
+		"#endif\n"
+		"void main() {\n"
+		"\tint count = 4;\n"
+		"\tint steps = STEPS;\n"
+		"\tgl_FragColor = vec4(float(steps));\n"
+		"}\n"),
+		"#ifdef FAST\n"
+		"#define STEPS count\n"
+		"#endif\n"
+		"void main(){int count=4;int a=STEPS;gl_FragColor=vec4(float(a));}\n");
+
+	// Struct members keep their names, also where a local is spelled the
+	// same, and so do swizzles.
+	TEST_CHECK_EQUAL(minify(minifier,
+		"struct Light { vec3 position; float range; };\n"
+		"uniform Light light;\n"
+		"void main() {\n"
+		"\tLight current = light;\n"
+		"\tvec3 position = current.position.xyz;\n"
+		"\tvec4 color = vec4(position.zyx, current.range);\n"
+		"\tgl_FragColor = color.rgba;\n"
+		"}\n"),
+		"struct Light{vec3 position;float range;};uniform Light light;void main(){Light a=light;vec3 position=a.position.xyz;vec4 b=vec4(position.zyx,a.range);gl_FragColor=b.rgba;}\n");
+
+	// Operators that would merge into another operator stay apart.
+	TEST_CHECK_EQUAL(minify(minifier,
+		"void main() {\n"
+		"\tint count = 1;\n"
+		"\tint total = count - -count;\n"
+		"\ttotal = total - --count;\n"
+		"\ttotal = total + ++count;\n"
+		"\ttotal = total - - -count;\n"
+		"\tgl_FragColor = vec4(float(total));\n"
+		"}\n"),
+		"void main(){int b=1;int a=b- -b;a=a- --b;a=a+ ++b;a=a- - -b;gl_FragColor=vec4(float(a));}\n");
+
+	// A division next to a comment does not turn into a comment.
+	TEST_CHECK_EQUAL(minify(minifier,
+		"void main() {\n"
+		"\tfloat x = 4.0;\n"
+		"\tfloat y = 2.0;\n"
+		"\tgl_FragColor = vec4(x/ /*c*/ y, x/y, x / y, x//c\n"
+		"\t);\n"
+		"}\n"),
+		"void main(){float x=4.0;float y=2.0;gl_FragColor=vec4(x/y,x/y,x/y,x);}\n");
+
+	// The name map lists the shortened names, the most used first.
+	const std::string source =
+		"uniform sampler2D tex;\n"
+		"varying vec2 uv;\n"
+		"vec4 sampleTexture(vec2 coord) { return texture2D(tex, coord); }\n"
+		"void main() {\n"
+		"\tvec4 color = sampleTexture(uv);\n"
+		"\tgl_FragColor = color * color;\n"
+		"}\n";
+	TEST_CHECK_EQUAL(minify(minifier, source, true),
+		"uniform sampler2D tex;varying vec2 uv;vec4 b(vec2 c){return texture2D(tex,c);}void main(){vec4 a=b(uv);gl_FragColor=a*a;}\n"
+		"// a = color\n"
+		"// b = sampleTexture\n"
+		"// c = coord\n");
+	const std::vector<ShaderMinifiedName> &names = minifier.getNameMap();
+	TEST_CHECK(names.size() == 3);
+	if (names.size() == 3) {
+		TEST_CHECK_EQUAL(names[0].shortName, "a");
+		TEST_CHECK_EQUAL(names[0].name, "color");
+		TEST_CHECK_EQUAL(names[1].shortName, "b");
+		TEST_CHECK_EQUAL(names[1].name, "sampleTexture");
+		TEST_CHECK_EQUAL(names[2].shortName, "c");
+		TEST_CHECK_EQUAL(names[2].name, "coord");
+	}
+	TEST_CHECK_EQUAL(minify(minifier, source),
+		"uniform sampler2D tex;varying vec2 uv;vec4 b(vec2 c){return texture2D(tex,c);}void main(){vec4 a=b(uv);gl_FragColor=a*a;}\n");
+
+	return testFinish("GLSLMinifierTest");
+}
\ No newline at end of file
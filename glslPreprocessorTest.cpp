@@ -0,0 +1,474 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "glslTest.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+typedef std::map<std::string, std::string> ReferenceDefines;
+
+/**
+ * Evaluates #if expressions the way a C preprocessor does, for checking the
+ * translator against. Identifiers that are not defined are 0.
+ */
+class ReferenceExpression {
+public:
+	ReferenceExpression(const std::string &text, const ReferenceDefines &defines) :
+		mDefines(defines) {
+		for (size_t i = 0; i < text.length(); ) {
+			char c = text[i];
+			if (c == ' ' || c == '\t') {
+				i++;
+			} else if (isalnum(static_cast<unsigned char>(c)) || c == '_') {
+				size_t start = i;
+				while (i < text.length() && (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_'))
+					i++;
+				mTokens.push_back(text.substr(start, i - start));
+			} else if (i + 1 < text.length() && std::string("|&=!<>").find(c) != std::string::npos &&
+				(text[i + 1] == '=' || (text[i + 1] == c && (c == '|' || c == '&')))) {
+				mTokens.push_back(text.substr(i, 2));
+				i += 2;
+			} else {
+				mTokens.push_back(std::string(1, c));
+				i++;
+			}
+		}
+	}
+
+	int64_t evaluate() {
+		return evaluateOr();
+	}
+
+private:
+	bool accept(const char *token) {
+		if (mPos < mTokens.size() && mTokens[mPos] == token) {
+			mPos++;
+			return true;
+		}
+		return false;
+	}
+
+	int64_t evaluateOr() {
+		int64_t value = evaluateAnd();
+		while (accept("||")) {
+			int64_t right = evaluateAnd();
+			value = value || right;
+		}
+		return value;
+	}
+
+	int64_t evaluateAnd() {
+		int64_t value = evaluateEquality();
+		while (accept("&&")) {
+			int64_t right = evaluateEquality();
+			value = value && right;
+		}
+		return value;
+	}
+
+	int64_t evaluateEquality() {
+		int64_t value = evaluateRelation();
+		for (;;) {
+			if (accept("=="))
+				value = value == evaluateRelation();
+			else if (accept("!="))
+				value = value != evaluateRelation();
+			else
+				return value;
+		}
+	}
+
+	int64_t evaluateRelation() {
+		int64_t value = evaluateUnary();
+		for (;;) {
+			if (accept("<="))
+				value = value <= evaluateUnary();
+			else if (accept(">="))
+				value = value >= evaluateUnary();
+			else if (accept("<"))
+				value = value < evaluateUnary();
+			else if (accept(">"))
+				value = value > evaluateUnary();
+			else
+				return value;
+		}
+	}
+
+	int64_t evaluateUnary() {
+		if (accept("!"))
+			return !evaluateUnary();
+		if (accept("-"))
+			return -evaluateUnary();
+		if (accept("(")) {
+			int64_t value = evaluateOr();
+			accept(")");
+			return value;
+		}
+		if (mPos >= mTokens.size())
+			return 0;
+
+		std::string token = mTokens[mPos++];
+		if (token == "defined") {
+			bool parens = accept("(");
+			std::string name = (mPos < mTokens.size()) ? mTokens[mPos++] : std::string();
+			if (parens)
+				accept(")");
+			return mDefines.count(name);
+		}
+		if (isdigit(static_cast<unsigned char>(token[0])))
+			return strtoll(token.c_str(), nullptr, 0);
+		auto it = mDefines.find(token);
+		return (it == mDefines.end()) ? 0 : strtoll(it->second.c_str(), nullptr, 0);
+	}
+
+	const ReferenceDefines &mDefines;
+	std::vector<std::string> mTokens;
+	size_t mPos = 0;
+};
+
+/**
+ * Preprocesses a shader the way the driver would and lists the marker
+ * lines ("m<number>;") that are compiled, with the line number the driver
+ * gives each of them. #line n numbers the next line n + 1, as in GLSL
+ * before 4.20.
+ */
+static std::string referencePreprocess(const std::string &source, ReferenceDefines defines) {
+	struct Block {
+		bool parent;
+		bool taken;
+	};
+	std::vector<Block> blocks;
+	bool active = true;
+	std::string result;
+	uint32_t line = 1;
+	for (size_t start = 0; start < source.length(); line++) {
+		size_t end = source.find('\n', start);
+		if (end == std::string::npos)
+			end = source.length();
+		std::string text = source.substr(start, end - start);
+		start = end + 1;
+		text.erase(0, text.find_first_not_of(" \t"));
+
+		if (text.empty() || text[0] != '#') {
+			if (active && text[0] == 'm')
+				result += text + " @" + std::to_string(line) + '\n';
+			continue;
+		}
+
+		size_t nameEnd = text.find_first_of(" \t", 1);
+		std::string directive = text.substr(1, nameEnd - 1);
+		std::string rest = (nameEnd == std::string::npos) ? std::string() : text.substr(nameEnd + 1);
+		rest.erase(0, rest.find_first_not_of(" \t"));
+		if (directive == "if" || directive == "ifdef" || directive == "ifndef") {
+			bool condition;
+			if (directive == "if")
+				condition = ReferenceExpression(rest, defines).evaluate() != 0;
+			else
+				condition = defines.count(rest) == (directive == "ifdef" ? 1 : 0);
+			blocks.push_back({ active, condition });
+			active = active && condition;
+		} else if (directive == "elif") {
+			Block &block = blocks.back();
+			bool condition = !block.taken && ReferenceExpression(rest, defines).evaluate() != 0;
+			active = block.parent && condition;
+			block.taken = block.taken || condition;
+		} else if (directive == "else") {
+			Block &block = blocks.back();
+			active = block.parent && !block.taken;
+			block.taken = true;
+		} else if (directive == "endif") {
+			active = blocks.back().parent;
+			blocks.pop_back();
+		} else if (active && directive == "line") {
+			line = static_cast<uint32_t>(strtoul(rest.c_str(), nullptr, 10));
+		} else if (active && directive == "define") {
+			size_t space = rest.find(' ');
+			defines[rest.substr(0, space)] = (space == std::string::npos) ? std::string() : rest.substr(space + 1);
+		} else if (active && directive == "undef") {
+			defines.erase(rest);
+		}
+	}
+	return result;
+}
+
+/**
+ * Writes random nested conditionals with a marker on every line of code.
+ */
+class ConditionalGenerator {
+public:
+	explicit ConditionalGenerator(std::mt19937 &rng) :
+		mRng(rng) {
+	}
+
+	std::string generate() {
+		mSource.clear();
+		mMarker = 0;
+		writeBlock(0);
+		return mSource;
+	}
+
+private:
+	static const char *pick(std::mt19937 &rng, const std::vector<const char *> &items) {
+		return items[rng() % items.size()];
+	}
+
+	std::string expression(int depth) {
+		static const std::vector<const char *> names = { "A", "B", "C", "U", "V", "GL21", "GL33", "Q" };
+		static const std::vector<const char *> values = { "A", "U", "V", "Q", "__VERSION__", "0", "1", "2", "3", "330" };
+		static const std::vector<const char *> operators = { "||", "&&", "==", "!=", "<", ">", "<=", ">=" };
+		switch ((depth > 2) ? mRng() % 3 : mRng() % 6) {
+		case 0:
+			return std::string("defined(") + pick(mRng, names) + ")";
+		case 1:
+			return std::string("defined ") + pick(mRng, names);
+		case 2:
+			return pick(mRng, values);
+		case 3:
+			return "!" + expression(depth + 1);
+		case 4:
+			return "(" + expression(depth + 1) + ")";
+		default:
+			return "(" + expression(depth + 1) + " " + pick(mRng, operators) + " " + expression(depth + 1) + ")";
+		}
+	}
+
+	void writeCode() {
+		switch (mRng() % 6) {
+		case 0:
+			mSource += "\n";
+			break;
+		case 1:
+			// Comments spanning lines move the line numbers too.
+			mSource += "/* a\n comment */\n";
+			break;
+		default:
+			mSource += "m" + std::to_string(mMarker++) + ";\n";
+			break;
+		}
+	}
+
+	void writeDirective(const std::string &text) {
+		mSource += (mRng() % 4 == 0) ? "  " : "";
+		mSource += text + '\n';
+	}
+
+	void writeBlock(int depth) {
+		int count = 1 + mRng() % 4;
+		for (int i = 0; i < count; i++) {
+			if (depth >= 3 || mRng() % 3) {
+				writeCode();
+				continue;
+			}
+
+			static const std::vector<const char *> names = { "A", "B", "C", "U", "V", "GL21", "GL33" };
+			switch (mRng() % 3) {
+			case 0:
+				writeDirective(std::string("#ifdef ") + pick(mRng, names));
+				break;
+			case 1:
+				writeDirective(std::string("#ifndef ") + pick(mRng, names));
+				break;
+			default:
+				writeDirective("#if " + expression(0));
+				break;
+			}
+			writeBlock(depth + 1);
+			for (int elifs = mRng() % 3; elifs > 0; elifs--) {
+				writeDirective("#elif " + expression(0));
+				writeBlock(depth + 1);
+			}
+			if (mRng() % 2) {
+				writeDirective("#else");
+				writeBlock(depth + 1);
+			}
+			writeDirective("#endif");
+		}
+	}
+
+	std::mt19937 &mRng;
+	std::string mSource;
+	int mMarker = 0;
+};
+
+/**
+ * Checks the output of a few shaders exactly.
+ */
+static void testExpected() {
+	ShaderTranslatorGL33 gl33;
+	gl33.setPreprocessing(true);
+	gl33.define("A", "2");
+	gl33.undefine("B");
+	std::string header =
+		"#version 330 core\n"
+		"#define GL33\n"
+		"\n"
+		"out vec4 GEN_OUTPUT_FINAL_COLOR;\n"
+		"\n";
+
+	// #elif after a taken branch, #elif defined() of an undefined macro,
+	// and conditions on identifiers nothing is known about.
+	TEST_CHECK_EQUAL(gl33.translate(
+		"#if A > 1\n"
+		"float a;\n"
+		"#elif U\n"
+		"float b;\n"
+		"#endif\n"
+		"#ifdef U\n"
+		"float u;\n"
+		"#elif defined(B)\n"
+		"float x;\n"
+		"#else\n"
+		"float y;\n"
+		"#endif\n"
+		"#if Q == 0 && A\n"
+		"float q;\n"
+		"#endif\n"
+		"float z;\n", ShaderTranslator::FRAGMENT),
+		header +
+		"#define A 2\n"
+		"#line 0\n"
+		"\n"
+		"float a;\n"
+		"#line 5\n"
+		"#ifdef U\n"
+		"float u;\n"
+		"\n"
+		"\n"
+		"#else\n"
+		"float y;\n"
+		"#endif\n"
+		"#if Q == 0 && A\n"
+		"float q;\n"
+		"#endif\n"
+		"float z;\n");
+
+	// Nested conditionals, where a dropped outer block takes its inner ones
+	// along and an #elif that becomes the first kept branch turns into #if.
+	TEST_CHECK_EQUAL(gl33.translate(
+		"#ifdef GL21\n"
+		"#if U\n"
+		"float a;\n"
+		"#endif\n"
+		"#elif U\n"
+		"#ifndef B\n"
+		"float b;\n"
+		"#else\n"
+		"float c;\n"
+		"#endif\n"
+		"#endif\n"
+		"float d;\n", ShaderTranslator::FRAGMENT),
+		header +
+		"#line 0\n"
+		"#line 4\n"
+		"#if U\n"
+		"\n"
+		"float b;\n"
+		"\n"
+		"\n"
+		"\n"
+		"#endif\n"
+		"float d;\n");
+
+	// Integers that do not fit in 64 bits are left to the driver.
+	TEST_CHECK_EQUAL(gl33.translate(
+		"#if 0xFFFFFFFFFFFFFFFF\n"
+		"float a;\n"
+		"#endif\n"
+		"#if 9223372036854775807 > 0 && 0777777777777777777777 > 0\n"
+		"float b;\n"
+		"#endif\n", ShaderTranslator::FRAGMENT),
+		header +
+		"#line 0\n"
+		"#if 0xFFFFFFFFFFFFFFFF\n"
+		"float a;\n"
+		"#endif\n"
+		"\n"
+		"float b;\n"
+		"\n");
+}
+
+/**
+ * Checks random conditionals against the reference preprocessor for every
+ * value of the macros the translator does not know about: what the driver
+ * compiles, and on which lines, has to stay the same.
+ */
+static void testRandom(ShaderTranslator &translator, const ReferenceDefines &builtins, int shaders) {
+	translator.setPreprocessing(true);
+	translator.define("A", "2");
+	translator.undefine("B");
+	translator.define("C");
+
+	ReferenceDefines known = builtins;
+	known["A"] = "2";
+	known["C"] = "";
+	const ReferenceDefines unknowns[] = {
+		{},
+		{ { "U", "0" } },
+		{ { "U", "1" }, { "V", "2" } },
+		{ { "V", "0" }, { "Q", "1" } },
+		{ { "U", "3" }, { "Q", "0" } }
+	};
+
+	std::mt19937 rng(1234);
+	ConditionalGenerator generator(rng);
+	for (int i = 0; i < shaders; i++) {
+		std::string source = generator.generate();
+		std::string output = translator.translate(source, ShaderTranslator::FRAGMENT);
+		for (const ReferenceDefines &unknown : unknowns) {
+			// The driver still defines its builtins for the output.
+			ReferenceDefines defines = known;
+			defines.insert(unknown.begin(), unknown.end());
+			ReferenceDefines driver = builtins;
+			driver.insert(unknown.begin(), unknown.end());
+			std::string expected = referencePreprocess(source, defines);
+			std::string actual = referencePreprocess(output, driver);
+			TEST_CHECK_EQUAL(actual, expected);
+			if (actual != expected) {
+				printf("source:\n%s\noutput:\n%s\n", source.c_str(), output.c_str());
+				return;
+			}
+		}
+	}
+}
+
+int main(int argc, const char *argv[]) {
+	testExpected();
+
+	ShaderTranslatorGL21 gl21;
+	testRandom(gl21, { { "GL21", "" }, { "__VERSION__", "120" } }, 2000);
+	ShaderTranslatorGL33 gl33;
+	testRandom(gl33, { { "GL33", "" }, { "GL_core_profile", "1" }, { "__VERSION__", "330" } }, 2000);
+	return testFinish("GLSLPreprocessorTest");
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <random>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderScanner.h"
+#include "shaderTranslationContext.h"
+
+static const char *IMPLEMENTATION_NAMES[] = { "scalar", "sse2", "avx2" };
+
+/**
+ * Builds sources whose runs start and end around the 16 and 32 byte blocks
+ * the SIMD scanners read.
+ */
+static std::vector<std::string> buildEdgeInputs() {
+	std::vector<std::string> inputs;
+	const size_t lengths[] = { 1, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65, 100 };
+	for (size_t offset = 0; offset < 34; offset++) {
+		std::string lead(offset, ';');
+		for (size_t length : lengths) {
+			inputs.push_back(lead + std::string(length, 'a') + "(");
+			inputs.push_back(lead + std::string(length, 'a'));
+			inputs.push_back(lead + std::string(length, ' ') + "x");
+			inputs.push_back(lead + std::string(length, '\t'));
+
+			// Words and spaces that run into high bit bytes.
+			std::string high = lead + std::string(length, '_');
+			high.push_back(static_cast<char>(0x80));
+			high += std::string(length, ' ');
+			high.push_back(static_cast<char>(0xff));
+			high.push_back(static_cast<char>(0xe9));
+			inputs.push_back(high);
+
+			// Windows line endings inside space runs.
+			std::string crlf = lead;
+			for (size_t i = 0; i < length; i++)
+				crlf += (i % 3 == 2) ? "\r\n" : " ";
+			inputs.push_back(crlf + "y\r\n");
+		}
+
+		// Comment openers and closers that straddle a block.
+		for (size_t at : { 14, 15, 16, 30, 31, 32 }) {
+			std::string line = lead + std::string(at, 'b') + "//" + std::string(20, 'c') + "\r\nd";
+			inputs.push_back(line);
+			std::string block = lead + std::string(at, ' ') + "/*" + std::string(at, '*') + "*/e";
+			inputs.push_back(block);
+			inputs.push_back(lead + std::string(at, 'f') + "/");
+			inputs.push_back(lead + std::string(at, 'f') + "/*");
+		}
+	}
+
+	// Random text from an alphabet that makes short runs of every kind.
+	const char alphabet[] = "aZ_09 \t\r\n/*;(.\x80\xff";
+	std::mt19937 rng(3);
+	for (int i = 0; i < 500; i++) {
+		std::string text(rng() % 200, ' ');
+		for (char &c : text)
+			c = alphabet[rng() % (sizeof(alphabet) - 1)];
+		inputs.push_back(text);
+	}
+	return inputs;
+}
+
+/**
+ * Checks that every implementation finds the same run ends from every
+ * position as the scalar one, and tokenizes the same tokens.
+ */
+static void testImplementations(const std::vector<std::string> &inputs) {
+	ShaderTranslationContext context;
+	for (const std::string &input : inputs) {
+		ShaderScanner::setImplementation(ShaderScanner::SCALAR);
+		std::vector<size_t> wordEnds;
+		std::vector<size_t> spaceEnds;
+		for (size_t pos = 0; pos < input.length(); pos++) {
+			wordEnds.push_back(ShaderScanner::findWordEnd(input.data(), pos, input.length()));
+			spaceEnds.push_back(ShaderScanner::findSpaceEnd(input.data(), pos, input.length()));
+		}
+		context.tokenize(input);
+		ShaderTokenList expected = context.getTokens();
+
+		for (int implementation = ShaderScanner::SSE2; implementation <= ShaderScanner::AVX2; implementation++) {
+			if (ShaderScanner::setImplementation(static_cast<ShaderScanner::Implementation>(implementation)) != implementation)
+				continue;
+
+			for (size_t pos = 0; pos < input.length(); pos++) {
+				TEST_CHECK(ShaderScanner::findWordEnd(input.data(), pos, input.length()) == wordEnds[pos]);
+				TEST_CHECK(ShaderScanner::findSpaceEnd(input.data(), pos, input.length()) == spaceEnds[pos]);
+			}
+
+			context.tokenize(input);
+			const ShaderTokenList &tokens = context.getTokens();
+			TEST_CHECK(tokens.size() == expected.size());
+			for (size_t i = 0; i < tokens.size() && i < expected.size(); i++) {
+				TEST_CHECK(tokens[i].offset == expected[i].offset);
+				TEST_CHECK(tokens[i].length == expected[i].length);
+				TEST_CHECK(tokens[i].kind == expected[i].kind);
+			}
+		}
+	}
+}
+
+/**
+ * Checks that sources too large for the token offsets are rejected without
+ * being read, and that the next source tokenizes as usual.
+ */
+static void testSourceLimit() {
+	ShaderTranslationContext context;
+	const char source[] = "void main() {}";
+	if (sizeof(size_t) > sizeof(uint32_t)) {
+		TEST_CHECK(!context.tokenize(std::string_view(source, static_cast<size_t>(UINT32_MAX) + 1)));
+		TEST_CHECK(context.getTokens().empty());
+		TEST_CHECK(context.getSource().empty());
+	}
+
+	TEST_CHECK(context.tokenize(source));
+	TEST_CHECK(context.getTokens().size() == 8);
+}
+
+int main(int argc, const char *argv[]) {
+	ShaderScanner::Implementation best = ShaderScanner::getBestImplementation();
+	printf("Comparing the scanners up to %s\n", IMPLEMENTATION_NAMES[best]);
+
+	std::vector<std::string> inputs = buildEdgeInputs();
+	for (const BenchShader &shader : generateBenchCorpus(true))
+		inputs.push_back(shader.source);
+	testImplementations(inputs);
+	testSourceLimit();
+
+	ShaderScanner::setImplementation(best);
+	return testFinish("GLSLScannerTest");
+}
\ No newline at end of file
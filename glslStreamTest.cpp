@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderStreamTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * Streams a shader that is cut into the given chunks.
+ * @param cuts Where each chunk ends, in increasing order.
+ * @return the streamed output.
+ */
+static std::string streamChunks(const ShaderTranslator &translator, const std::string &source, ShaderTranslator::ShaderType shaderType, const std::vector<size_t> &cuts) {
+	std::string output;
+	ShaderStreamTranslator stream(translator, shaderType, [&output](const char *data, size_t length) {
+		output.append(data, length);
+	});
+	size_t start = 0;
+	for (size_t cut : cuts) {
+		stream.feed(source.data() + start, cut - start);
+		start = cut;
+	}
+	stream.feed(source.data() + start, source.length() - start);
+	stream.finish();
+	return output;
+}
+
+/**
+ * Checks that every shader of the corpus streams to what translate() gives,
+ * when it is fed in chunks of random length from 1 byte up.
+ */
+static void testCorpus(const std::vector<BenchShader> &corpus, const ShaderTranslator &translator) {
+	std::mt19937 rng(1234);
+	for (const BenchShader &shader : corpus) {
+		const std::string expected = translator.translate(shader.source, shader.shaderType);
+		for (size_t maxChunk : { 1, 2, 7, 64, 4096 }) {
+			std::uniform_int_distribution<size_t> length(1, maxChunk);
+			std::vector<size_t> cuts;
+			for (size_t cut = length(rng); cut < shader.source.length(); cut += length(rng))
+				cuts.push_back(cut);
+			TEST_CHECK_EQUAL(streamChunks(translator, shader.source, shader.shaderType, cuts), expected);
+		}
+	}
+}
+
+/**
+ * Checks shaders that are cut at every position, and at every pair of
+ * positions, so each split of a comment marker or identifier is covered.
+ */
+static void testSplits(const ShaderTranslator &translator) {
+	const char *sources[] = {
+		"varying/* a */vec2 uv;// gl_FragColor\n gl_FragColor = texture2D(s, uv);\n",
+		"a/b/*c*/d**/e; x / *y; x//y\nz",
+		"/*/ gl_FragColor */gl_FragColor/**/=/***/texture2D//*\n(s, uv);",
+		"texture2DLod(s, uv, 0.0); texture2DLodX(s); texture2D (s, uv);",
+		"attribute vec3 pos; varying vec2 uv; /* never ends varying",
+		"gl_FragColor"
+	};
+
+	for (ShaderTranslator::ShaderType shaderType : { ShaderTranslator::VERTEX, ShaderTranslator::FRAGMENT }) {
+		for (const char *it : sources) {
+			const std::string source = it;
+			const std::string expected = translator.translate(source, shaderType);
+			TEST_CHECK_EQUAL(streamChunks(translator, source, shaderType, {}), expected);
+			for (size_t first = 0; first <= source.length(); first++) {
+				TEST_CHECK_EQUAL(streamChunks(translator, source, shaderType, { first }), expected);
+				for (size_t second = first; second <= source.length(); second++)
+					TEST_CHECK_EQUAL(streamChunks(translator, source, shaderType, { first, second }), expected);
+			}
+		}
+	}
+}
+
+/**
+ * Checks the stream to stream helper.
+ */
+static void testStreams(const std::vector<BenchShader> &corpus, const ShaderTranslator &translator) {
+	for (const BenchShader &shader : corpus) {
+		std::istringstream in(shader.source);
+		std::ostringstream out;
+		ShaderStreamTranslator::translate(translator, in, out, shader.shaderType);
+		TEST_CHECK_EQUAL(out.str(), translator.translate(shader.source, shader.shaderType));
+	}
+}
+
+int main(int argc, const char *argv[]) {
+	std::vector<BenchShader> corpus = generateBenchCorpus(true);
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	for (const ShaderTranslator *translator : { static_cast<const ShaderTranslator *>(&gl21), static_cast<const ShaderTranslator *>(&gl33) }) {
+		testCorpus(corpus, *translator);
+		testSplits(*translator);
+		testStreams(corpus, *translator);
+	}
+	return testFinish("GLSLStreamTest");
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef glslTest_h
+#define glslTest_h
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/**
+ * The number of checks that failed in this test executable.
+ */
+inline int gTestFailures = 0;
+
+/**
+ * Checks a condition, printing it along with where it is if it does not
+ * hold. The test keeps going, so one run reports every failure.
+ */
+#define TEST_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			gTestFailures++; \
+		} \
+	} while (0)
+
+/**
+ * Checks that two strings are equal, printing where they first differ.
+ */
+#define TEST_CHECK_EQUAL(a, b) \
+	do { \
+		if (!testCheckEqual(a, b, #a, #b)) { \
+			fprintf(stderr, "%s:%d: check failed: %s == %s\n", __FILE__, __LINE__, #a, #b); \
+			gTestFailures++; \
+		} \
+	} while (0)
+
+inline bool testCheckEqual(std::string_view a, std::string_view b, const char *aName, const char *bName) {
+	if (a == b)
+		return true;
+
+	size_t i = 0;
+	while (i < a.length() && i < b.length() && a[i] == b[i])
+		i++;
+	size_t start = (i > 20) ? i - 20 : 0;
+	fprintf(stderr, "  %s and %s differ at byte %zu:\n", aName, bName, i);
+	fprintf(stderr, "  %s: \"%s\"\n", aName, std::string(a.substr(start, 60)).c_str());
+	fprintf(stderr, "  %s: \"%s\"\n", bName, std::string(b.substr(start, 60)).c_str());
+	return false;
+}
+
+/**
+ * Reports the result of the test executable.
+ * @param name The name of the test.
+ * @return the exit code of the test.
+ */
+inline int testFinish(const char *name) {
+	if (gTestFailures) {
+		fprintf(stderr, "%s: %d checks failed\n", name, gTestFailures);
+		return 1;
+	}
+	printf("%s: passed\n", name);
+	return 0;
+}
+
+#endif /* glslTest_h */
\ No newline at end of file
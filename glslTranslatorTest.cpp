@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderDiskCache.h"
+#include "shaderTokenFile.h"
+#include "shaderTranslatorCached.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * Checks that translateAll() gives every target what translate() gives it,
+ * including targets that wrap another translator in a disk cache.
+ */
+static void testTranslateAll(const std::vector<BenchShader> &corpus, const std::string &cachePath) {
+	ShaderDiskCache cache;
+	TEST_CHECK(cache.open(cachePath));
+
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 preprocessed;
+	preprocessed.setPreprocessing(true);
+	ShaderTranslatorGL33 minified;
+	minified.setMinify(true);
+	minified.setReflection(true);
+	ShaderTranslatorCached cachedPreprocessed(preprocessed, cache);
+	ShaderTranslatorCached cachedMinified(minified, cache);
+	TEST_CHECK(cachedPreprocessed.isPreprocessing());
+	TEST_CHECK(cachedMinified.needsTokenList());
+
+	const std::string branches =
+		"#ifdef GL21\n"
+		"varying vec2 uv;\n"
+		"#else\n"
+		"in vec2 uv;\n"
+		"#endif\n"
+		"uniform sampler2D tex;\n"
+		"void main() {\n"
+		"\tgl_FragColor = texture2D(tex, uv);\n"
+		"}\n";
+
+	std::vector<BenchShader> shaders = corpus;
+	shaders.push_back({ "branches", BENCH_PROFILE_MIXED, ShaderTranslator::FRAGMENT, branches });
+
+	const ShaderTranslator *translators[] = { &gl21, &preprocessed, &cachedPreprocessed, &cachedMinified };
+	ShaderTranslationContext context;
+	std::string outputs[4];
+	for (int pass = 0; pass < 2; pass++) {
+		// The second pass is served from the cache.
+		uint64_t hits = cache.getHitCount();
+		for (const BenchShader &shader : shaders) {
+			std::vector<ShaderTranslator::Target> targets;
+			for (size_t i = 0; i < 4; i++)
+				targets.push_back({ translators[i], shader.shaderType, &outputs[i] });
+			ShaderTranslator::translateAll(context, shader.source, targets);
+
+			for (size_t i = 0; i < 4; i++)
+				TEST_CHECK_EQUAL(outputs[i], translators[i]->translate(shader.source, shader.shaderType));
+		}
+		if (pass == 1)
+			TEST_CHECK(cache.getHitCount() >= hits + shaders.size() * 4);
+	}
+
+	// The wrapped translator's preprocessing resolves the branches.
+	ShaderTranslator::translateAll(context, branches, { { &cachedPreprocessed, ShaderTranslator::FRAGMENT, &outputs[0] } });
+	TEST_CHECK(outputs[0].find("#ifdef") == std::string::npos);
+	TEST_CHECK(outputs[0].find("varying") == std::string::npos);
+	cache.close();
+}
+
+/**
+ * Checks that translateTokenFile() gives what translate() gives for every
+ * kind of translator, including ones wrapped in a disk cache.
+ */
+static void testTranslateTokenFile(const std::vector<BenchShader> &corpus, const std::string &cachePath) {
+	ShaderDiskCache cache;
+	TEST_CHECK(cache.open(cachePath));
+
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslatorGL33 preprocessed;
+	preprocessed.setPreprocessing(true);
+	ShaderTranslatorGL33 minified;
+	minified.setMinify(true);
+	minified.setReflection(true);
+	ShaderTranslatorGL33 located;
+	located.setExplicitLocations(true);
+	ShaderTranslatorCached cachedGL33(gl33, cache);
+	ShaderTranslatorCached cachedPreprocessed(preprocessed, cache);
+	ShaderTranslatorCached cachedMinified(minified, cache);
+	const ShaderTranslator *translators[] = { &gl21, &gl33, &preprocessed, &minified, &located, &cachedGL33, &cachedPreprocessed, &cachedMinified };
+
+	ShaderTranslationContext context;
+	std::string data;
+	std::string shader;
+	ShaderTokenFile file;
+	for (int pass = 0; pass < 2; pass++) {
+		size_t hits = cache.getHitCount();
+		for (const BenchShader &it : corpus) {
+			TEST_CHECK(ShaderTokenFile::build(it.source, data));
+			TEST_CHECK(!file.load(data.data(), data.size() - 1));
+			TEST_CHECK(file.load(data.data(), data.size()));
+
+			// The kinds the file leaves out have to come back as tokenize() has them.
+			ShaderTranslationContext tokenized;
+			tokenized.tokenize(it.source);
+			TEST_CHECK(file.decodeTokens(context));
+			TEST_CHECK(context.getTokens().size() == tokenized.getTokens().size());
+			for (size_t i = 0; i < context.getTokens().size() && i < tokenized.getTokens().size(); i++) {
+				const ShaderToken &decoded = context.getTokens()[i];
+				const ShaderToken &token = tokenized.getTokens()[i];
+				TEST_CHECK(decoded.offset == token.offset && decoded.length == token.length && decoded.kind == token.kind);
+			}
+
+			for (const ShaderTranslator *translator : translators) {
+				translator->translateTokenFile(context, file, it.shaderType, shader);
+				TEST_CHECK_EQUAL(shader, translator->translate(it.source, it.shaderType));
+			}
+			file.close();
+		}
+		// The wrapped translators are looked up in the cache on the second pass.
+		if (pass == 1)
+			TEST_CHECK(cache.getHitCount() >= hits + corpus.size() * 6);
+	}
+	cache.close();
+}
+
+/**
+ * Checks that a view returned by ShaderDiskCache::find() survives storing
+ * the same shader again.
+ */
+static void testDiskCacheViews(const std::string &cachePath) {
+	ShaderDiskCache cache;
+	TEST_CHECK(cache.open(cachePath));
+
+	ShaderTranslatorGL33 gl33;
+	for (size_t length : { 8, 4096 }) {
+		std::string source(length, 'a');
+		ShaderDiskCache::Key key = ShaderTranslationCache::makeKey(gl33, source, ShaderTranslator::VERTEX);
+		std::string first(length, 'b');
+		std::string second(length, 'c');
+
+		std::string_view view;
+		TEST_CHECK(cache.store(key, first));
+		TEST_CHECK(cache.find(key, view));
+		TEST_CHECK(cache.store(key, second));
+		TEST_CHECK_EQUAL(view, first);
+
+		std::string_view latest;
+		TEST_CHECK(cache.find(key, latest));
+		TEST_CHECK_EQUAL(latest, second);
+	}
+	cache.close();
+}
+
+/**
+ * Checks that shaders stored in a run are served from the file once there
+ * are enough of them to map it again, while views returned by find() before
+ * that stay valid.
+ */
+static void testDiskCacheRemap(const std::string &cachePath) {
+	ShaderDiskCache cache;
+	TEST_CHECK(cache.open(cachePath));
+
+	// Enough shaders to map the file again a few times over.
+	ShaderTranslatorGL33 gl33;
+	const size_t count = 1024;
+	std::vector<ShaderDiskCache::Key> keys;
+	std::vector<std::string> translations;
+	std::vector<std::string_view> views;
+	for (size_t i = 0; i < count; i++) {
+		std::string source = "shader " + std::to_string(i);
+		keys.push_back(ShaderTranslationCache::makeKey(gl33, source, ShaderTranslator::VERTEX));
+		translations.push_back(std::string(8 * 1024, static_cast<char>('a' + i % 26)) + source);
+		TEST_CHECK(cache.store(keys[i], translations[i]));
+
+		// Hold on to views of stored shaders, of shaders stored again and of
+		// shaders that are already served from the file.
+		if (i % 64 == 0) {
+			std::string_view view;
+			TEST_CHECK(cache.find(keys[i], view));
+			views.push_back(view);
+			TEST_CHECK(cache.find(keys[i / 2], view));
+			views.push_back(view);
+		}
+		if (i % 100 == 0) {
+			TEST_CHECK(cache.store(keys[i], translations[i]));
+			TEST_CHECK(cache.store(keys[i / 3], translations[i / 3]));
+		}
+	}
+	TEST_CHECK(cache.getEntryCount() == count);
+
+	size_t view = 0;
+	for (size_t i = 0; i < count; i += 64) {
+		TEST_CHECK_EQUAL(views[view++], translations[i]);
+		TEST_CHECK_EQUAL(views[view++], translations[i / 2]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		std::string_view found;
+		TEST_CHECK(cache.find(keys[i], found));
+		TEST_CHECK_EQUAL(found, translations[i]);
+	}
+
+	// Everything made it to the file.
+	cache.close();
+	TEST_CHECK(cache.open(cachePath));
+	TEST_CHECK(cache.getEntryCount() == count);
+	for (size_t i = 0; i < count; i++) {
+		std::string_view found;
+		TEST_CHECK(cache.find(keys[i], found));
+		TEST_CHECK_EQUAL(found, translations[i]);
+	}
+	cache.close();
+}
+
+int main(int argc, const char *argv[]) {
+	std::vector<BenchShader> corpus = generateBenchCorpus(true);
+	std::filesystem::path cachePath = std::filesystem::temp_directory_path() / "glslTranslatorTest.bin";
+	std::error_code error;
+	std::filesystem::remove(cachePath, error);
+
+	testTranslateAll(corpus, cachePath.string());
+	std::filesystem::remove(cachePath, error);
+	testTranslateTokenFile(corpus, cachePath.string());
+	std::filesystem::remove(cachePath, error);
+	testDiskCacheViews(cachePath.string());
+	std::filesystem::remove(cachePath, error);
+	testDiskCacheRemap(cachePath.string());
+
+	std::filesystem::remove(cachePath, error);
+	return testFinish("GLSLTranslatorTest");
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <set>
+#include <string>
+#include <vector>
+#include "glslBenchCorpus.h"
+#include "glslTest.h"
+#include "shaderVariantTranslator.h"
+
+/**
+ * Code around a corpus shader that makes it an uber shader.
+ */
+static const char *UBER_PROLOGUE =
+	"#ifdef FOG\n"
+	"uniform vec4 fogColor;\n"
+	"varying float fogDepth;\n"
+	"#endif\n"
+	"#if QUALITY > 1\n"
+	"uniform sampler2D detailTexture;\n"
+	"#elif defined(SKINNING)\n"
+	"attribute vec4 boneWeights;\n"
+	"#else\n"
+	"varying vec2 lowUv;\n"
+	"#endif\n";
+
+static const char *UBER_EPILOGUE =
+	"\n#ifndef SKINNING\n"
+	"// not skinned\n"
+	"#endif\n"
+	"#ifdef GL33\n"
+	"float gl33Only;\n"
+	"#endif\n"
+	"#if defined(FOG) && QUALITY > 1\n"
+	"float foggyDetail() { return texture2D(detailTexture, lowUv).r * fogColor.a; }\n"
+	"#endif\n";
+
+/**
+ * Translates a variant the slow way, with a translator of its own.
+ * @param minify Set to minify like the variant translator's GL33 translator.
+ * @param quality The QUALITY the GL33 translator defines, or null.
+ */
+static std::string translateVariant(ShaderTranslator::ShaderBackend backend, bool minify, const char *quality, const std::vector<ShaderDefineSet> &defineSets, size_t set, const std::string &source, ShaderTranslator::ShaderType shaderType) {
+	ShaderTranslatorGL21 gl21;
+	ShaderTranslatorGL33 gl33;
+	ShaderTranslator &translator = (backend == ShaderTranslator::GL21) ? static_cast<ShaderTranslator &>(gl21) : gl33;
+	translator.setPreprocessing(true);
+	if (backend != ShaderTranslator::GL33) {
+		minify = false;
+		quality = nullptr;
+	}
+	translator.setMinify(minify);
+	if (quality)
+		translator.define("QUALITY", quality);
+
+	// Whatever only other variants define is undefined in this one.
+	for (const ShaderDefineSet &other : defineSets) {
+		for (const ShaderDefine &define : other.getDefines()) {
+			if (!defineSets[set].find(define.name) && !(quality && define.name == "QUALITY"))
+				translator.undefine(define.name);
+		}
+	}
+	for (const ShaderDefine &define : defineSets[set].getDefines()) {
+		if (define.defined)
+			translator.define(define.name, define.value);
+		else
+			translator.undefine(define.name);
+	}
+	return translator.translate(source, shaderType);
+}
+
+/**
+ * Checks every variant of a shader against translate(), and that variants
+ * share a shader exactly when their output is the same.
+ */
+static void checkVariants(ShaderVariantTranslator &variants, bool minify, const char *quality, const std::vector<ShaderDefineSet> &defineSets, const std::string &source, ShaderTranslator::ShaderType shaderType) {
+	const std::vector<ShaderTranslator::ShaderBackend> backends = { ShaderTranslator::GL21, ShaderTranslator::GL33 };
+	ShaderVariantList list = variants.translate(source, shaderType, defineSets, backends);
+	TEST_CHECK(list.variants.size() == defineSets.size() * backends.size());
+	TEST_CHECK(std::set<std::string>(list.shaders.begin(), list.shaders.end()).size() == list.shaders.size());
+
+	for (size_t i = 0; i < list.variants.size(); i++) {
+		const ShaderVariant &variant = list.variants[i];
+		TEST_CHECK(variant.backend == backends[i / defineSets.size()]);
+		TEST_CHECK(variant.defines == i % defineSets.size());
+		TEST_CHECK(variant.shader < list.shaders.size());
+		if (variant.shader >= list.shaders.size())
+			continue;
+		TEST_CHECK_EQUAL(list.shaders[variant.shader], translateVariant(variant.backend, minify, quality, defineSets, variant.defines, source, shaderType));
+	}
+}
+
+/**
+ * Checks the variants of every corpus shader, as it is and as an uber shader.
+ */
+static void testCorpus(const std::vector<BenchShader> &corpus) {
+	std::vector<ShaderDefineSet> defineSets(8);
+	defineSets[1].define("FOG");
+	defineSets[2].define("SKINNING");
+	defineSets[3].define("QUALITY", "2");
+	defineSets[4].define("FOG");
+	defineSets[4].define("QUALITY", "2");
+	defineSets[5].define("UNUSED");
+	defineSets[6].define("QUALITY", "0");
+	defineSets[6].undefine("FOG");
+	defineSets[7].define("FOG");
+
+	ShaderVariantTranslator variants;
+	ShaderTranslatorGL33 configured;
+	configured.setMinify(true);
+	configured.define("QUALITY", "3");
+	for (const BenchShader &shader : corpus) {
+		const std::string uber = UBER_PROLOGUE + shader.source + UBER_EPILOGUE;
+		checkVariants(variants, false, nullptr, defineSets, shader.source, shader.shaderType);
+		checkVariants(variants, false, nullptr, defineSets, uber, shader.shaderType);
+
+		// A translator with options and defines of its own.
+		variants.setTranslator(ShaderTranslator::GL33, &configured);
+		checkVariants(variants, true, "3", defineSets, uber, shader.shaderType);
+		variants.setTranslator(ShaderTranslator::GL33, nullptr);
+	}
+}
+
+/**
+ * Checks which variants of a small uber shader share their shader.
+ */
+static void testDeduplication() {
+	std::vector<ShaderDefineSet> defineSets(5);
+	defineSets[1].define("FOG");
+	defineSets[2].define("UNUSED");
+	defineSets[3].define("FOG");
+	defineSets[4].define("SKINNING");
+
+	ShaderVariantTranslator variants;
+	const std::string source = std::string(UBER_PROLOGUE) + "void main() {}\n" + UBER_EPILOGUE;
+	ShaderVariantList list = variants.translate(source, ShaderTranslator::VERTEX, defineSets, { ShaderTranslator::GL33 });
+	TEST_CHECK(list.variants.size() == 5);
+	if (list.variants.size() != 5)
+		return;
+
+	// A macro nothing tests does not make a new shader, and neither does
+	// defining the same macros twice.
+	TEST_CHECK(list.shaders.size() == 3);
+	TEST_CHECK(list.variants[0].shader == list.variants[2].shader);
+	TEST_CHECK(list.variants[1].shader == list.variants[3].shader);
+	TEST_CHECK(list.variants[0].shader != list.variants[1].shader);
+	TEST_CHECK(list.variants[0].shader != list.variants[4].shader);
+	TEST_CHECK(list.variants[1].shader != list.variants[4].shader);
+}
+
+int main(int argc, const char *argv[]) {
+	testCorpus(generateBenchCorpus(true));
+	testDeduplication();
+	return testFinish("GLSLVariantTest");
+}
\ No newline at end of file
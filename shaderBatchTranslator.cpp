@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderBatchTranslator.h"
+
+ShaderBatchTranslator::ShaderBatchTranslator(unsigned workerCount) :
+	mPool(workerCount) {
+	mTranslators[ShaderTranslator::GL21] = &mGL21;
+	mTranslators[ShaderTranslator::GL33] = &mGL33;
+	mContexts.resize(mPool.getWorkerCount());
+}
+
+void ShaderBatchTranslator::setTranslator(ShaderTranslator::ShaderBackend backend, const ShaderTranslator *translator) {
+	if (!translator) {
+		if (backend == ShaderTranslator::GL21)
+			translator = &mGL21;
+		else
+			translator = &mGL33;
+	}
+	mTranslators[backend] = translator;
+}
+
+std::vector<std::string> ShaderBatchTranslator::translateBatch(const std::vector<ShaderBatchJob> &jobs) {
+	std::vector<std::string> shaders(jobs.size());
+	mPool.parallelFor(jobs.size(), [this, &jobs, &shaders](size_t index, unsigned worker) {
+		const ShaderBatchJob &job = jobs[index];
+		mTranslators[job.backend]->translateInto(mContexts[worker], job.source, job.shaderType, shaders[index]);
+	});
+	return shaders;
+}
\ No newline at end of file
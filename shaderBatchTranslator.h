@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderBatchTranslator_h
+#define shaderBatchTranslator_h
+
+#include "shaderThreadPool.h"
+#include "shaderTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * A single shader of a batch.
+ */
+struct ShaderBatchJob {
+	/**
+	 * The shader source. It must stay alive until the batch is translated.
+	 */
+	std::string_view source;
+	ShaderTranslator::ShaderType shaderType;
+	ShaderTranslator::ShaderBackend backend;
+};
+
+/**
+ * Translates many shaders at once on a pool of worker threads.
+ * Example usage:
+ *
+ * ShaderBatchTranslator batch;
+ * std::vector<ShaderBatchJob> jobs;
+ * jobs.push_back({ vertex, ShaderTranslator::VERTEX, ShaderTranslator::GL33 });
+ * jobs.push_back({ fragment, ShaderTranslator::FRAGMENT, ShaderTranslator::GL33 });
+ * std::vector<std::string> shaders = batch.translateBatch(jobs);
+ */
+class ShaderBatchTranslator {
+public:
+	/**
+	 * Creates a batch translator.
+	 * @param workerCount The number of threads to translate on, including the
+	 *  calling thread. 0 uses one per hardware thread.
+	 */
+	explicit ShaderBatchTranslator(unsigned workerCount = 0);
+
+	/**
+	 * Changes the translator used for a backend, for example to one with
+	 * different options or one that is backed by a cache.
+	 * @param backend The backend.
+	 * @param translator The translator to use, or null for the default one.
+	 *  It must outlive the batch translator and be safe to call from any thread.
+	 */
+	void setTranslator(ShaderTranslator::ShaderBackend backend, const ShaderTranslator *translator);
+
+	/**
+	 * Translates a batch of shaders.
+	 * @param jobs The shaders to translate.
+	 * @return the translated shaders, in the same order as the jobs.
+	 */
+	std::vector<std::string> translateBatch(const std::vector<ShaderBatchJob> &jobs);
+
+	unsigned getWorkerCount() const {
+		return mPool.getWorkerCount();
+	}
+
+private:
+	ShaderThreadPool mPool;
+
+	ShaderTranslatorGL21 mGL21;
+	ShaderTranslatorGL33 mGL33;
+	const ShaderTranslator *mTranslators[SHADER_BACKEND_COUNT];
+
+	/**
+	 * One context per worker, kept between batches.
+	 */
+	std::vector<ShaderTranslationContext> mContexts;
+};
+
+#endif /* shaderBatchTranslator_h */
\ No newline at end of file
@@ -0,0 +1,188 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderConstexprTranslator_h
+#define shaderConstexprTranslator_h
+
+#include <cstddef>
+#include <string_view>
+#include "shaderRewriteRules.h"
+#include "shaderScanner.h"
+#include "shaderTranslationContext.h"
+#include "shaderTranslator.h"
+
+/**
+ * A translated shader that was built at compile time. It is a plain
+ * character array, so a static instance costs nothing at startup.
+ */
+template <size_t N>
+struct ShaderConstexprString {
+	char data[N + 1];
+
+	constexpr const char *c_str() const {
+		return data;
+	}
+
+	constexpr size_t length() const {
+		return N;
+	}
+
+	constexpr std::string_view view() const {
+		return std::string_view(data, N);
+	}
+};
+
+/**
+ * Translates shaders at compile time, for shaders that are compiled into the
+ * program as string literals. It uses the same tokenizer rules, rewrite
+ * tables and headers as ShaderTranslatorGL21 and ShaderTranslatorGL33, so the
+ * output is the same as translating at runtime without preprocessing.
+ * Example usage:
+ *
+ * static constexpr auto shader = SHADER_TRANSLATE_CONSTEXPR(GL33, FRAGMENT,
+ *    "varying vec2 uv;\nvoid main() { gl_FragColor = vec4(uv, 0, 1); }\n");
+ * glShaderSource(id, 1, &shader.data, nullptr);
+ */
+class ShaderConstexprTranslator {
+public:
+	/**
+	 * Translates a shader.
+	 * @param str The shader source.
+	 * @param backend The backend to translate to.
+	 * @param shaderType The type of shader that is being translated.
+	 * @param output Receives the translated source and a terminating 0, or
+	 *  null to only work out the length.
+	 * @return the length of the translated source.
+	 */
+	static constexpr size_t translate(std::string_view str, ShaderTranslator::ShaderBackend backend, ShaderTranslator::ShaderType shaderType, char *output) {
+		size_t length = 0;
+		append(output, length, getHeader(backend, shaderType));
+
+		const ShaderRewriteTable &table = getRewriteTable(backend, shaderType);
+		const char *data = str.data();
+		size_t len = str.length();
+		for (size_t i = 0; i < len; ) {
+			ShaderToken token = shaderScanToken<Scan>(data, len, i);
+			std::string_view text = str.substr(token.offset, token.length);
+			i += token.length;
+			if (token.kind == ShaderToken::IDENTIFIER) {
+				std::string_view replacement = table.rewrite(text, (i < len) ? data[i] : '\0');
+				if (!replacement.empty())
+					text = replacement;
+			}
+			append(output, length, text);
+		}
+
+		if (output)
+			output[length] = '\0';
+		return length;
+	}
+
+	/**
+	 * The same header as the runtime translator of the backend.
+	 */
+	static constexpr std::string_view getHeader(ShaderTranslator::ShaderBackend backend, ShaderTranslator::ShaderType shaderType) {
+		if (backend == ShaderTranslator::GL21)
+			return SHADER_GL21_HEADER;
+		return (shaderType == ShaderTranslator::FRAGMENT) ? SHADER_GL33_FRAGMENT_HEADER : SHADER_GL33_VERTEX_HEADER;
+	}
+
+	/**
+	 * The same rewrite rules as the runtime translator of the backend.
+	 */
+	static constexpr const ShaderRewriteTable &getRewriteTable(ShaderTranslator::ShaderBackend backend, ShaderTranslator::ShaderType shaderType) {
+		if (backend == ShaderTranslator::GL21)
+			return SHADER_EMPTY_REWRITE_TABLE;
+		return (shaderType == ShaderTranslator::FRAGMENT) ? SHADER_GL33_FRAGMENT_TABLE : SHADER_GL33_VERTEX_TABLE;
+	}
+
+private:
+	/**
+	 * Finds the ends of runs one character at a time, since the SIMD scanner
+	 * cannot run at compile time.
+	 */
+	struct Scan {
+		static constexpr size_t findWordEnd(const char *data, size_t pos, size_t len) {
+			while (pos < len && SHADER_CHAR_TABLE.is(data[pos], SHADER_CHAR_WORD))
+				pos++;
+			return pos;
+		}
+
+		static constexpr size_t findSpaceEnd(const char *data, size_t pos, size_t len) {
+			while (pos < len && SHADER_CHAR_TABLE.is(data[pos], SHADER_CHAR_SPACE))
+				pos++;
+			return pos;
+		}
+
+		static constexpr size_t findChar(const char *data, size_t pos, size_t len, char c) {
+			while (pos < len && data[pos] != c)
+				pos++;
+			return pos;
+		}
+	};
+
+	static constexpr void append(char *output, size_t &length, std::string_view text) {
+		if (output) {
+			for (char c : text)
+				output[length++] = c;
+		} else {
+			length += text.length();
+		}
+	}
+};
+
+/**
+ * Translates a shader at compile time. The source is passed in as a lambda
+ * that returns it, which is how a string can be a constant expression inside
+ * a function in C++17. Use SHADER_TRANSLATE_CONSTEXPR instead of calling
+ * this directly.
+ * @param source A lambda without captures that returns the shader source.
+ * @return the translated shader.
+ */
+template <ShaderTranslator::ShaderBackend Backend, ShaderTranslator::ShaderType Type, typename Source>
+constexpr auto shaderTranslateConstexpr(Source source) {
+	constexpr std::string_view str = source();
+	constexpr size_t length = ShaderConstexprTranslator::translate(str, Backend, Type, nullptr);
+	ShaderConstexprString<length> shader = {};
+	ShaderConstexprTranslator::translate(str, Backend, Type, shader.data);
+	return shader;
+}
+
+/**
+ * Translates a string literal, or any constant expression that converts to
+ * a std::string_view, at compile time.
+ * @param backend GL21 or GL33.
+ * @param type VERTEX or FRAGMENT.
+ * @param source The shader source.
+ */
+#define SHADER_TRANSLATE_CONSTEXPR(backend, type, source) \
+	shaderTranslateConstexpr<ShaderTranslator::backend, ShaderTranslator::type>([]() { return std::string_view(source); })
+
+#endif /* shaderConstexprTranslator_h */
\ No newline at end of file
@@ -0,0 +1,383 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include "shaderDiskCache.h"
+#include "shaderHash.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+/**
+ * The version of the cache file layout. Bump this when the structs below change.
+ */
+#define SHADER_DISK_CACHE_FORMAT_VERSION 1
+
+#define SHADER_DISK_CACHE_MAGIC "GLSLTC\0\0"
+#define SHADER_DISK_RECORD_MAGIC 0x52435354u
+
+#define SHADER_DISK_CACHE_FILENAME "shaderCache.bin"
+
+/**
+ * The amount of stored translated source that is kept in memory at least
+ * before the file is mapped again to cover it.
+ */
+#define SHADER_DISK_CACHE_REMAP_SIZE (1024 * 1024)
+
+struct DiskCacheHeader {
+	char magic[8];
+	uint32_t formatVersion;
+	uint32_t rulesVersion;
+};
+
+struct DiskRecordHeader {
+	uint32_t magic;
+	uint32_t shaderType;
+	uint64_t hash;
+	uint64_t length;
+	uint64_t configuration;
+	uint64_t size;
+	uint64_t checksum;
+
+	/**
+	 * The hash of all of the fields above.
+	 */
+	uint64_t headerChecksum;
+};
+
+/**
+ * Records are padded so that every record header is 8 byte aligned.
+ */
+static inline size_t padRecordSize(size_t size) {
+	return (size + 7) & ~static_cast<size_t>(7);
+}
+
+static inline uint64_t getHeaderChecksum(const DiskRecordHeader &header) {
+	return shaderHash64(&header, offsetof(DiskRecordHeader, headerChecksum));
+}
+
+ShaderDiskCache::ShaderDiskCache() :
+	mMapping(new ShaderMappedFile()),
+	mAppendFile(nullptr),
+	mValidSize(0),
+	mMappingUsed(false),
+	mStoredSize(0),
+	mHits(0),
+	mMisses(0) {
+}
+
+ShaderDiskCache::~ShaderDiskCache() {
+	close();
+}
+
+bool ShaderDiskCache::open(const std::string &path) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mAppendFile) {
+		fclose(mAppendFile);
+		mAppendFile = nullptr;
+	}
+	mPath = path;
+	clearStored();
+	return load();
+}
+
+void ShaderDiskCache::close() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mAppendFile) {
+		fclose(mAppendFile);
+		mAppendFile = nullptr;
+	}
+	mMapping->close();
+	mRecords.clear();
+	clearStored();
+}
+
+bool ShaderDiskCache::find(const Key &key, std::string_view &translated) {
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto stored = mStored.find(key);
+	if (stored != mStored.end()) {
+		stored->second.used = true;
+		translated = *stored->second.translated;
+		mHits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	auto it = mRecords.find(key);
+	if (it == mRecords.end()) {
+		mMisses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Record &record = it->second;
+	const char *data = mMapping->getData() + record.offset;
+	if (!record.verified) {
+		if (shaderHash64(data, record.size) != record.checksum) {
+			// Torn or corrupt record, compact() will drop it from the file.
+			mRecords.erase(it);
+			mMisses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		record.verified = true;
+	}
+
+	mMappingUsed = true;
+	translated = std::string_view(data, record.size);
+	mHits.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool ShaderDiskCache::store(const Key &key, std::string_view translated) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mMapping->isOpen())
+		return false;
+
+	if (!mAppendFile) {
+		mAppendFile = fopen(mPath.c_str(), "ab");
+		if (!mAppendFile)
+			return false;
+	}
+
+	// The whole record goes out with one write so that the process dying
+	// can at worst leave a partial record at the very end of the file.
+	std::string record;
+	appendRecord(record, key, translated);
+	if (fwrite(record.data(), 1, record.size(), mAppendFile) != record.size() || fflush(mAppendFile) != 0) {
+		// Cut the partial record off again so later records are not lost
+		// behind it the next time the file is loaded.
+		fclose(mAppendFile);
+		mAppendFile = nullptr;
+		std::error_code error;
+		std::filesystem::resize_file(mPath, mValidSize, error);
+		return false;
+	}
+	size_t offset = mValidSize + sizeof(DiskRecordHeader);
+	mValidSize += record.size();
+
+	mRecords.erase(key);
+	Stored &stored = mStored[key];
+	if (stored.translated) {
+		mStoredSize -= stored.translated->length();
+		// Views handed out for an earlier store of the same key stay valid,
+		// so the string they point into is kept until the cache is compacted.
+		if (stored.used)
+			mKeptStrings.push_back(std::move(stored.translated));
+	}
+	stored.translated.reset(new std::string(translated));
+	stored.offset = offset;
+	stored.used = false;
+	mStoredSize += translated.length();
+
+	if (mStoredSize >= SHADER_DISK_CACHE_REMAP_SIZE && mStoredSize >= mMapping->getSize())
+		remap();
+	return true;
+}
+
+bool ShaderDiskCache::compact() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mMapping->isOpen())
+		return false;
+
+	DiskCacheHeader header;
+	memcpy(header.magic, SHADER_DISK_CACHE_MAGIC, sizeof(header.magic));
+	header.formatVersion = SHADER_DISK_CACHE_FORMAT_VERSION;
+	header.rulesVersion = SHADER_TRANSLATOR_RULES_VERSION;
+
+	std::string file(reinterpret_cast<const char *>(&header), sizeof(header));
+	for (const auto &it : mRecords) {
+		const Record &record = it.second;
+		std::string_view translated(mMapping->getData() + record.offset, record.size);
+		if (record.verified || shaderHash64(translated.data(), translated.length()) == record.checksum)
+			appendRecord(file, it.first, translated);
+	}
+	for (const auto &it : mStored)
+		appendRecord(file, it.first, *it.second.translated);
+
+	// The file can not be replaced while it is still open on some platforms.
+	if (mAppendFile) {
+		fclose(mAppendFile);
+		mAppendFile = nullptr;
+	}
+	mMapping->close();
+	mRecords.clear();
+	clearStored();
+
+	bool written = shaderWriteFileAtomic(mPath, file.data(), file.size());
+	return load() && written;
+}
+
+std::string ShaderDiskCache::getDefaultPath() {
+	std::error_code error;
+	std::filesystem::path exe;
+#ifdef _WIN32
+	char buffer[MAX_PATH];
+	DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+	if (length > 0 && length < MAX_PATH)
+		exe = std::string(buffer, length);
+#elif defined(__APPLE__)
+	char buffer[4096];
+	uint32_t size = sizeof(buffer);
+	if (_NSGetExecutablePath(buffer, &size) == 0)
+		exe = buffer;
+#else
+	exe = std::filesystem::read_symlink("/proc/self/exe", error);
+#endif
+	if (exe.empty())
+		return SHADER_DISK_CACHE_FILENAME;
+	return (exe.parent_path() / SHADER_DISK_CACHE_FILENAME).string();
+}
+
+size_t ShaderDiskCache::getEntryCount() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRecords.size() + mStored.size();
+}
+
+bool ShaderDiskCache::load() {
+	mRecords.clear();
+	if (!mMapping->open(mPath) || mMapping->getSize() < sizeof(DiskCacheHeader)) {
+		if (!reset() || !mMapping->open(mPath))
+			return false;
+	}
+
+	// Throw away files written by another version of the library.
+	DiskCacheHeader header;
+	memcpy(&header, mMapping->getData(), sizeof(header));
+	if (memcmp(header.magic, SHADER_DISK_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.formatVersion != SHADER_DISK_CACHE_FORMAT_VERSION ||
+		header.rulesVersion != SHADER_TRANSLATOR_RULES_VERSION) {
+		mMapping->close();
+		if (!reset() || !mMapping->open(mPath))
+			return false;
+	}
+
+	// Index the records. Only the record headers are read, the translated
+	// source is not touched until it is asked for.
+	const char *data = mMapping->getData();
+	size_t size = mMapping->getSize();
+	size_t offset = sizeof(DiskCacheHeader);
+	while (offset + sizeof(DiskRecordHeader) <= size) {
+		DiskRecordHeader record;
+		memcpy(&record, data + offset, sizeof(record));
+		if (record.magic != SHADER_DISK_RECORD_MAGIC || record.headerChecksum != getHeaderChecksum(record))
+			break;
+
+		size_t payload = offset + sizeof(DiskRecordHeader);
+		if (record.size > size - payload)
+			break;
+
+		Key key;
+		key.hash = record.hash;
+		key.length = record.length;
+		key.configuration = record.configuration;
+		key.shaderType = static_cast<ShaderTranslator::ShaderType>(record.shaderType);
+
+		// Later records replace earlier ones.
+		mRecords[key] = { payload, static_cast<size_t>(record.size), record.checksum, false };
+		offset = payload + padRecordSize(static_cast<size_t>(record.size));
+	}
+
+	// Cut off a partially written record so new records are appended right
+	// after the last good one.
+	mValidSize = offset;
+	if (offset < size) {
+		mMapping->close();
+		std::error_code error;
+		std::filesystem::resize_file(mPath, offset, error);
+		if (error || !mMapping->open(mPath)) {
+			mRecords.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+void ShaderDiskCache::remap() {
+	// Everything that was stored has been handed to the operating system, so
+	// a new mapping of the file sees it.
+	std::unique_ptr<ShaderMappedFile> mapping(new ShaderMappedFile());
+	if (!mapping->open(mPath) || mapping->getSize() < mValidSize)
+		return;
+
+	// Views into the old mapping stay valid until the cache is compacted.
+	if (mMappingUsed)
+		mKeptMappings.push_back(std::move(mMapping));
+	mMapping = std::move(mapping);
+	mMappingUsed = false;
+
+	for (auto &it : mStored) {
+		Stored &stored = it.second;
+		mRecords[it.first] = { stored.offset, stored.translated->length(), shaderHash64(stored.translated->data(), stored.translated->length()), true };
+		if (stored.used)
+			mKeptStrings.push_back(std::move(stored.translated));
+	}
+	mStored.clear();
+	mStoredSize = 0;
+}
+
+void ShaderDiskCache::clearStored() {
+	mStored.clear();
+	mStoredSize = 0;
+	mKeptStrings.clear();
+	mKeptMappings.clear();
+	mMappingUsed = false;
+}
+
+bool ShaderDiskCache::reset() {
+	mMapping->close();
+
+	DiskCacheHeader header;
+	memcpy(header.magic, SHADER_DISK_CACHE_MAGIC, sizeof(header.magic));
+	header.formatVersion = SHADER_DISK_CACHE_FORMAT_VERSION;
+	header.rulesVersion = SHADER_TRANSLATOR_RULES_VERSION;
+	return shaderWriteFileAtomic(mPath, &header, sizeof(header));
+}
+
+void ShaderDiskCache::appendRecord(std::string &buffer, const Key &key, std::string_view translated) {
+	DiskRecordHeader record;
+	memset(&record, 0, sizeof(record));
+	record.magic = SHADER_DISK_RECORD_MAGIC;
+	record.shaderType = static_cast<uint32_t>(key.shaderType);
+	record.hash = key.hash;
+	record.length = key.length;
+	record.configuration = key.configuration;
+	record.size = translated.length();
+	record.checksum = shaderHash64(translated.data(), translated.length());
+	record.headerChecksum = getHeaderChecksum(record);
+
+	buffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+	buffer.append(translated);
+	buffer.append(padRecordSize(translated.length()) - translated.length(), '\0');
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderDiskCache_h
+#define shaderDiskCache_h
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "shaderFile.h"
+#include "shaderTranslationCache.h"
+
+/**
+ * A cache of translated shaders that persists between runs. The cache file
+ * is memory mapped, and a hit hands out the translated source straight from
+ * the mapping without parsing or copying it.
+ *
+ * The file starts with a header holding the file format version and the
+ * rewrite rules version, and a file written by a different version is
+ * thrown away. After the header, records are only ever appended. Each record
+ * has a checksum of its header and of its translated source, so a record
+ * that was only partially written when the process died is detected and
+ * dropped. Records are handed to the operating system as they are stored
+ * but not synced to the disk, so after a power loss the records that did
+ * not reach the disk are dropped the same way. Replaced records stay in the
+ * file until compact() is called. Only one process should write to a cache
+ * file at a time.
+ */
+class ShaderDiskCache {
+public:
+	typedef ShaderTranslationCache::Key Key;
+
+	ShaderDiskCache();
+	~ShaderDiskCache();
+
+	ShaderDiskCache(const ShaderDiskCache &) = delete;
+	ShaderDiskCache &operator=(const ShaderDiskCache &) = delete;
+
+	/**
+	 * Opens a cache file, creating it if it does not exist.
+	 * @param path The path of the cache file.
+	 * @return true if the cache is ready to use, false otherwise.
+	 */
+	bool open(const std::string &path);
+
+	/**
+	 * Closes the cache file.
+	 */
+	void close();
+
+	/**
+	 * Looks up a translated shader.
+	 * @param key The key of the shader.
+	 * @param translated Set to the translated source if the shader is cached.
+	 *  It stays valid until the cache is compacted, closed or opened again,
+	 *  even if the shader is stored again.
+	 * @return true if the shader is cached, false otherwise.
+	 */
+	bool find(const Key &key, std::string_view &translated);
+
+	/**
+	 * Appends a translated shader to the cache file.
+	 * @param key The key of the shader.
+	 * @param translated The translated source.
+	 * @return true if the shader was written, false otherwise.
+	 */
+	bool store(const Key &key, std::string_view translated);
+
+	/**
+	 * Rewrites the cache file with only the latest valid record of every
+	 * shader. The new file replaces the old one atomically.
+	 * @return true if the cache was compacted, false otherwise.
+	 */
+	bool compact();
+
+	/**
+	 * Get's the path of the cache file that lives next to the executable.
+	 * @return the default cache path.
+	 */
+	static std::string getDefaultPath();
+
+	size_t getEntryCount() const;
+
+	uint64_t getHitCount() const {
+		return mHits.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getMissCount() const {
+		return mMisses.load(std::memory_order_relaxed);
+	}
+
+private:
+	/**
+	 * A translated shader inside of the mapping.
+	 */
+	struct Record {
+		size_t offset;
+		size_t size;
+		uint64_t checksum;
+
+		/**
+		 * Set once the checksum of the translated source was checked. It is
+		 * checked on first use, so opening the cache does not read every page.
+		 */
+		bool verified;
+	};
+
+	/**
+	 * A shader stored since the file was mapped.
+	 */
+	struct Stored {
+		std::unique_ptr<const std::string> translated;
+
+		/**
+		 * Where the translated source starts in the file.
+		 */
+		size_t offset;
+
+		/**
+		 * Set once find() handed out a view of the translated source.
+		 */
+		bool used;
+	};
+
+	/**
+	 * Maps the cache file and indexes its records. The mutex must be held.
+	 * @return true if the file was mapped, false otherwise.
+	 */
+	bool load();
+
+	/**
+	 * Maps the file again so that it covers the stored shaders, which are
+	 * then served from the mapping. The mutex must be held.
+	 */
+	void remap();
+
+	/**
+	 * Forgets the stored shaders and everything kept alive for old views.
+	 * The mutex must be held.
+	 */
+	void clearStored();
+
+	/**
+	 * Writes a new, empty cache file. The mutex must be held.
+	 * @return true if the file was written, false otherwise.
+	 */
+	bool reset();
+
+	/**
+	 * Appends the record of a shader to a buffer.
+	 */
+	static void appendRecord(std::string &buffer, const Key &key, std::string_view translated);
+
+	mutable std::mutex mMutex;
+
+	std::string mPath;
+	std::unique_ptr<ShaderMappedFile> mMapping;
+	FILE *mAppendFile;
+
+	/**
+	 * The size of the file up to the end of the last good record.
+	 */
+	size_t mValidSize;
+
+	/**
+	 * The records in the mapping.
+	 */
+	std::unordered_map<Key, Record, Key::Hasher> mRecords;
+
+	/**
+	 * Set once find() handed out a view into the current mapping.
+	 */
+	bool mMappingUsed;
+
+	/**
+	 * The shaders stored since the file was mapped. They are served from
+	 * memory until they add up to SHADER_DISK_CACHE_REMAP_SIZE or the size
+	 * of the mapping, whichever is bigger, and the file is mapped again.
+	 */
+	std::unordered_map<Key, Stored, Key::Hasher> mStored;
+	size_t mStoredSize;
+
+	/**
+	 * The strings and mappings that views returned by find() may still
+	 * point into, after their shader was stored again or mapped again.
+	 */
+	std::vector<std::unique_ptr<const std::string>> mKeptStrings;
+	std::vector<std::unique_ptr<ShaderMappedFile>> mKeptMappings;
+
+	std::atomic<uint64_t> mHits;
+	std::atomic<uint64_t> mMisses;
+};
+
+#endif /* shaderDiskCache_h */
\ No newline at end of file
@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include "shaderFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ShaderMappedFile::ShaderMappedFile() :
+	mData(nullptr),
+	mSize(0),
+	mOpen(false)
+#ifdef _WIN32
+	, mFile(INVALID_HANDLE_VALUE),
+	mMapping(nullptr)
+#endif
+{
+}
+
+ShaderMappedFile::~ShaderMappedFile() {
+	close();
+}
+
+#ifdef _WIN32
+
+bool ShaderMappedFile::open(const std::string &path) {
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mSize = static_cast<size_t>(size.QuadPart);
+	mOpen = true;
+	if (mSize == 0)
+		return true;
+
+	mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping)
+		mData = static_cast<const char *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mData) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ShaderMappedFile::close() {
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+	mSize = 0;
+	mOpen = false;
+}
+
+#else
+
+bool ShaderMappedFile::open(const std::string &path) {
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	mSize = static_cast<size_t>(st.st_size);
+	if (mSize > 0) {
+		void *data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			mSize = 0;
+			return false;
+		}
+		mData = static_cast<const char *>(data);
+	}
+
+	// The mapping keeps the file alive, the descriptor is not needed anymore.
+	::close(fd);
+	mOpen = true;
+	return true;
+}
+
+void ShaderMappedFile::close() {
+	if (mData)
+		munmap(const_cast<char *>(mData), mSize);
+	mData = nullptr;
+	mSize = 0;
+	mOpen = false;
+}
+
+#endif
+
+bool shaderSyncFile(FILE *file) {
+	if (fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool shaderWriteFileAtomic(const std::string &path, const void *data, size_t size) {
+	// The temporary file has to be on the same file system for the rename to
+	// be atomic, so it goes right next to the real one. The process id and a
+	// counter keep writers in other processes and threads off each other's
+	// temporary file.
+	static std::atomic<unsigned> counter(0);
+#ifdef _WIN32
+	unsigned long pid = GetCurrentProcessId();
+#else
+	unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+	std::string temp = path + "." + std::to_string(pid) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+	FILE *file = fopen(temp.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool ok = (size == 0 || fwrite(data, 1, size, file) == size) && shaderSyncFile(file);
+	ok = (fclose(file) == 0) && ok;
+
+	std::error_code error;
+	if (ok)
+		std::filesystem::rename(temp, path, error);
+	if (!ok || error) {
+		std::filesystem::remove(temp, error);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderFile_h
+#define shaderFile_h
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+/**
+ * A read only view of a whole file, mapped into memory.
+ */
+class ShaderMappedFile {
+public:
+	ShaderMappedFile();
+	~ShaderMappedFile();
+
+	ShaderMappedFile(const ShaderMappedFile &) = delete;
+	ShaderMappedFile &operator=(const ShaderMappedFile &) = delete;
+
+	/**
+	 * Maps a file, closing any file that was mapped before.
+	 * @param path The path of the file.
+	 * @return true if the file was mapped, false if it could not be opened.
+	 * @note Empty files map successfully with a null data pointer.
+	 */
+	bool open(const std::string &path);
+
+	/**
+	 * Unmaps the file.
+	 */
+	void close();
+
+	bool isOpen() const {
+		return mOpen;
+	}
+
+	const char *getData() const {
+		return mData;
+	}
+
+	size_t getSize() const {
+		return mSize;
+	}
+
+private:
+	const char *mData;
+	size_t mSize;
+	bool mOpen;
+
+#ifdef _WIN32
+	void *mFile;
+	void *mMapping;
+#endif
+};
+
+/**
+ * Writes a file so that readers only ever see the old or the new contents.
+ * The data goes to a temporary file next to 'path', is flushed to disk, and
+ * is then renamed over 'path'. The temporary file name is unique to the
+ * process and call, so concurrent writers of the same path do not clobber
+ * each other; the last rename wins.
+ * @param path The path of the file.
+ * @param data The new contents.
+ * @param size The size of the new contents in bytes.
+ * @return true if the file was written, false otherwise.
+ */
+bool shaderWriteFileAtomic(const std::string &path, const void *data, size_t size);
+
+/**
+ * Flushes a stdio file all the way to the disk.
+ * @param file The file to flush.
+ * @return true if the file was flushed, false otherwise.
+ */
+bool shaderSyncFile(FILE *file);
+
+#endif /* shaderFile_h */
\ No newline at end of file
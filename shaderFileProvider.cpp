@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <filesystem>
+#include "shaderFile.h"
+#include "shaderFileProvider.h"
+
+void ShaderMemoryFileProvider::setFile(const std::string &name, std::string source) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFiles[name] = std::move(source);
+}
+
+void ShaderMemoryFileProvider::removeFile(const std::string &name) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFiles.erase(name);
+}
+
+bool ShaderMemoryFileProvider::readFile(const std::string &name, std::string &source) const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mFiles.find(name);
+	if (it == mFiles.end())
+		return false;
+	source = it->second;
+	return true;
+}
+
+ShaderDirectoryFileProvider::ShaderDirectoryFileProvider(std::string root) :
+	mRoot(std::move(root)) {
+	if (!mRoot.empty() && mRoot.back() != '/' && mRoot.back() != '\\')
+		mRoot += '/';
+}
+
+bool ShaderDirectoryFileProvider::readFile(const std::string &name, std::string &source) const {
+	// Names come from the shaders, so they are not allowed to leave the root.
+	std::filesystem::path path = std::filesystem::path(name).lexically_normal();
+	if (path.empty() || path.has_root_path() || *path.begin() == "..")
+		return false;
+
+	ShaderMappedFile file;
+	if (!file.open(mRoot + path.generic_string()))
+		return false;
+	source.assign(file.getData() ? file.getData() : "", file.getSize());
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderFileProvider_h
+#define shaderFileProvider_h
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Supplies the files that shaders #include. Files are looked up by the name
+ * written in the #include, so the provider decides what a name means.
+ * Providers can be called from several threads at once.
+ */
+class ShaderFileProvider {
+public:
+	virtual ~ShaderFileProvider() {}
+
+	/**
+	 * Reads a file.
+	 * @param name The name of the file.
+	 * @param source Receives the contents of the file.
+	 * @return true if the file was read, false if it does not exist.
+	 */
+	virtual bool readFile(const std::string &name, std::string &source) const = 0;
+};
+
+/**
+ * A file provider that keeps its files in memory, for tools that generate
+ * shader code and for tests.
+ */
+class ShaderMemoryFileProvider : public ShaderFileProvider {
+public:
+	/**
+	 * Adds a file, or replaces its contents.
+	 * @param name The name of the file.
+	 * @param source The contents of the file.
+	 */
+	void setFile(const std::string &name, std::string source);
+
+	/**
+	 * Removes a file.
+	 * @param name The name of the file.
+	 */
+	void removeFile(const std::string &name);
+
+	bool readFile(const std::string &name, std::string &source) const override;
+
+private:
+	mutable std::mutex mMutex;
+	std::unordered_map<std::string, std::string> mFiles;
+};
+
+/**
+ * A file provider that reads files below a directory on disk. Names that
+ * are absolute or lead out of the directory with ".." are not read.
+ */
+class ShaderDirectoryFileProvider : public ShaderFileProvider {
+public:
+	/**
+	 * Creates a directory file provider.
+	 * @param root The directory that names are relative to.
+	 */
+	explicit ShaderDirectoryFileProvider(std::string root);
+
+	bool readFile(const std::string &name, std::string &source) const override;
+
+private:
+	std::string mRoot;
+};
+
+#endif /* shaderFileProvider_h */
\ No newline at end of file
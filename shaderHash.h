@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderHash_h
+#define shaderHash_h
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hashes a block of memory with the 64 bit xxHash algorithm (XXH64).
+ * @param data The memory to hash.
+ * @param length The length of the memory in bytes.
+ * @param seed The seed of the hash, used to hash different kinds of keys apart.
+ * @return the 64 bit hash of the memory.
+ */
+uint64_t shaderHash64(const void *data, size_t length, uint64_t seed = 0);
+
+/**
+ * Mixes a value into an existing hash.
+ * @param hash The hash to mix into.
+ * @param value The value to mix in.
+ * @return the combined hash.
+ */
+inline uint64_t shaderHashCombine(uint64_t hash, uint64_t value) {
+	hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+#endif /* shaderHash_h */
\ No newline at end of file
@@ -0,0 +1,400 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <filesystem>
+#include "shaderIncludeTranslator.h"
+#include "shaderMinifier.h"
+
+/**
+ * Counts the line breaks in a token.
+ */
+static uint32_t countLines(std::string_view text) {
+	return static_cast<uint32_t>(std::count(text.begin(), text.end(), '\n'));
+}
+
+/**
+ * Reads the file name of an #include directive.
+ * @param context The context that holds the tokens of the file.
+ * @param first The first token after the #.
+ * @param end The token after the directive.
+ * @param name Receives the file name.
+ * @param angled Set if the name is in angle brackets.
+ * @return true if the directive is an #include, false otherwise.
+ */
+static bool parseInclude(const ShaderTranslationContext &context, size_t first, size_t end, std::string &name, bool &angled) {
+	const ShaderTokenList &tokens = context.getTokens();
+	size_t i = first;
+	while (i < end && (tokens[i].kind == ShaderToken::WHITESPACE || tokens[i].kind == ShaderToken::COMMENT))
+		i++;
+	if (i == end || context.getTokenText(tokens[i]) != "include")
+		return false;
+
+	// The name is everything between the quotes or angle brackets.
+	const ShaderToken &last = tokens[end - 1];
+	size_t start = tokens[i].offset + tokens[i].length;
+	std::string_view rest = context.getSource().substr(start, last.offset + last.length - start);
+	size_t open = rest.find_first_not_of(" \t");
+	if (open == std::string_view::npos || (rest[open] != '"' && rest[open] != '<'))
+		return false;
+	size_t close = rest.find(rest[open] == '"' ? '"' : '>', open + 1);
+	if (close == std::string_view::npos || close == open + 1)
+		return false;
+
+	name.assign(rest.substr(open + 1, close - open - 1));
+	angled = rest[open] == '<';
+	return true;
+}
+
+/**
+ * Turns an included name into the name of a file, with the '.' and '..'
+ * parts folded away.
+ * @param directory The directory the name is relative to, empty for the root.
+ * @param name The name written in the #include.
+ * @param file Receives the name of the file.
+ * @return false if the name leads out of the root.
+ */
+static bool resolveName(const std::filesystem::path &directory, const std::string &name, std::string &file) {
+	std::filesystem::path path = (directory / std::filesystem::path(name).relative_path()).lexically_normal();
+	if (path.empty() || *path.begin() == "..")
+		return false;
+	file = path.generic_string();
+	return true;
+}
+
+ShaderIncludeTranslator::ShaderIncludeTranslator(const ShaderFileProvider &provider) :
+	mProvider(provider),
+	mModuleTranslations(0) {
+}
+
+std::shared_ptr<const ShaderIncludedShader> ShaderIncludeTranslator::translate(const ShaderTranslator &translator, const std::string &name, ShaderTranslator::ShaderType shaderType) {
+	ShaderKey key = { name, translator.getConfigurationHash(), shaderType };
+	auto cached = mShaders.find(key);
+	if (cached != mShaders.end())
+		return cached->second;
+
+	auto shader = std::make_shared<ShaderIncludedShader>();
+	Build build = { &translator, shaderType, shader.get(), {}, {}, 0 };
+	std::shared_ptr<const Module> module = loadModule(build, name);
+	if (!module) {
+		mLoaded.clear();
+		return nullptr;
+	}
+
+	// Every file starts at line 1 of its own source string.
+	shader->source.assign(translator.getHeader(shaderType));
+	shader->source += "#line 0 0\n";
+	build.stack.push_back(getSourceString(build, name));
+	build.spliced.insert(build.stack.back());
+	mReflection.clear(shaderType);
+	splice(build, *module);
+	mLoaded.clear();
+	if (translator.isMinifying())
+		mContext.getMinifier().minify(shader->source, translator.isMinifyNameMap());
+	if (translator.isReflecting()) {
+		translator.reflectHeader(shaderType, mReflection);
+		mReflection.write(shader->source);
+	}
+
+	// Remember which files the shader was built from. Missing files count
+	// too, since adding them changes the shader.
+	for (const std::string &file : shader->files)
+		mDependents[file].insert(name);
+	for (const std::string &file : shader->missing)
+		mDependents[file].insert(name);
+
+	mShaders.emplace(std::move(key), shader);
+	return shader;
+}
+
+std::vector<std::string> ShaderIncludeTranslator::invalidate(const std::string &name) {
+	// Translated files are cached by their contents, so they never go out of
+	// date. They are dropped only to free the memory.
+	auto modules = mFileModules.find(name);
+	if (modules != mFileModules.end()) {
+		for (const ShaderTranslationCache::Key &key : modules->second)
+			mModules.erase(key);
+		mFileModules.erase(modules);
+	}
+
+	std::vector<std::string> shaders;
+	auto dependents = mDependents.find(name);
+	if (dependents == mDependents.end())
+		return shaders;
+
+	std::unordered_set<std::string> names = std::move(dependents->second);
+	mDependents.erase(dependents);
+	for (auto it = mShaders.begin(); it != mShaders.end(); ) {
+		if (!names.count(it->first.name)) {
+			++it;
+			continue;
+		}
+
+		// Unlink the shader from the other files it was built from.
+		const ShaderIncludedShader &shader = *it->second;
+		for (const auto *files : { &shader.files, &shader.missing }) {
+			for (const std::string &file : *files) {
+				auto other = mDependents.find(file);
+				if (other == mDependents.end())
+					continue;
+				other->second.erase(it->first.name);
+				if (other->second.empty())
+					mDependents.erase(other);
+			}
+		}
+		it = mShaders.erase(it);
+	}
+
+	shaders.assign(names.begin(), names.end());
+	std::sort(shaders.begin(), shaders.end());
+	return shaders;
+}
+
+std::vector<std::string> ShaderIncludeTranslator::getDependents(const std::string &name) const {
+	std::vector<std::string> shaders;
+	auto dependents = mDependents.find(name);
+	if (dependents != mDependents.end())
+		shaders.assign(dependents->second.begin(), dependents->second.end());
+	std::sort(shaders.begin(), shaders.end());
+	return shaders;
+}
+
+void ShaderIncludeTranslator::clear() {
+	mModules.clear();
+	mShaders.clear();
+	mDependents.clear();
+	mFileModules.clear();
+}
+
+std::shared_ptr<const ShaderIncludeTranslator::Module> ShaderIncludeTranslator::loadModule(Build &build, const std::string &name) {
+	// A file that is included several times is only read once per shader.
+	auto loaded = mLoaded.find(name);
+	if (loaded != mLoaded.end())
+		return loaded->second;
+
+	std::shared_ptr<const Module> module;
+	if (mProvider.readFile(name, mFileSource)) {
+		ShaderTranslationCache::Key key = ShaderTranslationCache::makeKey(*build.translator, mFileSource, build.shaderType);
+		auto cached = mModules.find(key);
+		if (cached != mModules.end()) {
+			module = cached->second;
+		} else {
+			module = translateModule(build, mFileSource);
+			mModules.emplace(key, module);
+			mFileModules[name].push_back(key);
+		}
+	}
+
+	mLoaded.emplace(name, module);
+	return module;
+}
+
+std::shared_ptr<const ShaderIncludeTranslator::Module> ShaderIncludeTranslator::loadInclude(Build &build, const Include &include, std::string &name) {
+	// Quoted names are looked up next to the including file first. Every
+	// place that is looked at without finding the file is recorded, since
+	// adding the file there changes the shader.
+	// Names that lead out of the root are not looked up at all.
+	std::vector<std::string> &missing = build.shader->missing;
+	std::shared_ptr<const Module> module;
+	if (!include.angled) {
+		const std::string &including = build.shader->files[build.stack.back()];
+		if (resolveName(std::filesystem::path(including).parent_path(), include.name, name)) {
+			module = loadModule(build, name);
+			if (module)
+				return module;
+			if (std::find(missing.begin(), missing.end(), name) == missing.end())
+				missing.push_back(name);
+		}
+	}
+
+	if (!resolveName(std::filesystem::path(), include.name, name))
+		return nullptr;
+	module = loadModule(build, name);
+	if (!module && std::find(missing.begin(), missing.end(), name) == missing.end())
+		missing.push_back(name);
+	return module;
+}
+
+std::shared_ptr<const ShaderIncludeTranslator::Module> ShaderIncludeTranslator::translateModule(Build &build, std::string_view source) {
+	// Files too large to tokenize are left out as if they could not be read.
+	if (!mContext.tokenize(source))
+		return nullptr;
+
+	mModuleTranslations++;
+	auto module = std::make_shared<Module>();
+	module->code.reserve(source.length());
+
+	const ShaderTokenList &tokens = mContext.getTokens();
+	const ShaderRewriteTable &table = build.translator->getRewriteTable(build.shaderType);
+	ShaderReflection *reflection = nullptr;
+	if (build.translator->isReflecting() || build.translator->isExplicitLocations()) {
+		reflection = &mContext.getReflection();
+		reflection->clear(build.shaderType);
+	}
+
+	// Directives are only recognized when the # is the first thing on a line.
+	bool lineStart = true;
+	uint32_t line = 1;
+	size_t count = tokens.size();
+	for (size_t i = 0; i < count; i++) {
+		const ShaderToken &token = tokens[i];
+		std::string_view text = mContext.getTokenText(token);
+		if (token.kind == ShaderToken::WHITESPACE || token.kind == ShaderToken::COMMENT) {
+			uint32_t lines = countLines(text);
+			line += lines;
+			if (lines)
+				lineStart = true;
+			module->code.append(text);
+			continue;
+		}
+
+		if (lineStart && token.kind == ShaderToken::PUNCTUATION && text == "#") {
+			// The directive runs up to the line break that ends it. Block
+			// comments spanning lines are part of it.
+			size_t end = i + 1;
+			uint32_t endLine = line;
+			for (; end < count; end++) {
+				const ShaderToken &part = tokens[end];
+				if (part.kind == ShaderToken::WHITESPACE && countLines(mContext.getTokenText(part)))
+					break;
+				if (part.kind == ShaderToken::COMMENT)
+					endLine += countLines(mContext.getTokenText(part));
+			}
+
+			std::string name;
+			bool angled = false;
+			if (parseInclude(mContext, i + 1, end, name, angled)) {
+				const ShaderToken &last = tokens[end - 1];
+				size_t length = last.offset + last.length - token.offset;
+				module->includes.push_back({ module->code.length(), length, std::move(name), endLine, angled });
+				module->code.append(source.substr(token.offset, length));
+				line = endLine;
+				lineStart = false;
+				i = end - 1;
+				continue;
+			}
+		}
+
+		lineStart = false;
+		std::string_view replacement;
+		if (token.kind == ShaderToken::IDENTIFIER) {
+			replacement = table.rewrite(text, mContext.getNextCharacter(i));
+			size_t first = reflection ? reflection->getVariableCount() : 0;
+			if (reflection && reflection->readDeclaration(mContext, i) == 1 &&
+				reflection->getVariable(first).storage == ShaderReflectionVariable::ATTRIBUTE) {
+				// Locations depend on the files spliced in before this one,
+				// so they are only placed when the shader is spliced together.
+				size_t length = replacement.empty() ? text.length() : replacement.length();
+				module->attributes.push_back({ module->code.length(), length, first });
+			}
+		}
+		module->code.append(replacement.empty() ? text : replacement);
+	}
+
+	if (reflection)
+		module->variables.assign(reflection->getVariables(), reflection->getVariables() + reflection->getVariableCount());
+	return module;
+}
+
+void ShaderIncludeTranslator::splice(Build &build, const Module &module) {
+	std::string &output = build.shader->source;
+	size_t pos = 0;
+
+	// A file that is spliced in twice only declares its variables once.
+	for (const ShaderReflectionVariable &variable : module.variables) {
+		if (!mReflection.find(variable.name))
+			mReflection.add(variable.storage, variable.type, variable.name, variable.arraySize, variable.location);
+	}
+	size_t attribute = 0;
+	for (const Include &include : module.includes) {
+		appendCode(build, module, include.offset, pos, attribute);
+		pos = include.offset + include.length;
+
+		std::string name;
+		std::shared_ptr<const Module> included = loadInclude(build, include, name);
+		if (!included) {
+			// Leave the #include for the driver to report.
+			output.append(module.code, include.offset, include.length);
+			continue;
+		}
+
+		// A file that was spliced in before, or that ends up including
+		// itself, is left out like #pragma once would.
+		size_t number = getSourceString(build, name);
+		if (!build.spliced.insert(number).second)
+			continue;
+
+		size_t parent = build.stack.back();
+		output += "#line 0 ";
+		output += std::to_string(number);
+		output += '\n';
+		build.stack.push_back(number);
+		splice(build, *included);
+		build.stack.pop_back();
+
+		// Go back to the line after the #include in the including file.
+		if (output.back() != '\n')
+			output += '\n';
+		output += "#line ";
+		output += std::to_string(include.line);
+		output += ' ';
+		output += std::to_string(parent);
+	}
+	appendCode(build, module, module.code.length(), pos, attribute);
+}
+
+void ShaderIncludeTranslator::appendCode(Build &build, const Module &module, size_t end, size_t &pos, size_t &attribute) {
+	std::string &output = build.shader->source;
+	for (; attribute < module.attributes.size() && module.attributes[attribute].offset < end; attribute++) {
+		const Attribute &placed = module.attributes[attribute];
+		ShaderReflectionVariable *variable = mReflection.find(module.variables[placed.variable].name);
+		if (build.shaderType != ShaderTranslator::VERTEX || !variable || variable->location >= 0)
+			continue;
+
+		std::string_view qualifier = build.translator->placeAttribute(*variable, build.location);
+		if (qualifier.empty())
+			continue;
+
+		output.append(module.code, pos, placed.offset - pos);
+		output.append(qualifier);
+		pos = placed.offset + placed.length;
+	}
+	output.append(module.code, pos, end - pos);
+	pos = end;
+}
+
+size_t ShaderIncludeTranslator::getSourceString(Build &build, const std::string &name) {
+	std::vector<std::string> &files = build.shader->files;
+	auto it = std::find(files.begin(), files.end(), name);
+	if (it != files.end())
+		return it - files.begin();
+	files.push_back(name);
+	return files.size() - 1;
+}
\ No newline at end of file
@@ -0,0 +1,328 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderIncludeTranslator_h
+#define shaderIncludeTranslator_h
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "shaderFileProvider.h"
+#include "shaderReflection.h"
+#include "shaderTranslationCache.h"
+#include "shaderTranslationContext.h"
+#include "shaderTranslator.h"
+
+/**
+ * A shader translated together with everything it includes.
+ */
+struct ShaderIncludedShader {
+	/**
+	 * The translated source, with the included files spliced in.
+	 */
+	std::string source;
+
+	/**
+	 * The files the source was built from. The index of a file is the source
+	 * string number the #line markers give it, so files[0] is the shader.
+	 */
+	std::vector<std::string> files;
+
+	/**
+	 * The names an include was looked for at that the provider could not
+	 * read, since adding a file there changes the shader. An #include that
+	 * is not found at any of them is left in the source.
+	 */
+	std::vector<std::string> missing;
+};
+
+/**
+ * Translates shaders that #include shared code. Files are read through a
+ * ShaderFileProvider and every file is translated on its own, once per
+ * translator configuration and shader type, and cached by a hash of its
+ * contents. The translated files are then spliced together, with #line
+ * markers that give every file its own source string number so compile
+ * errors point at the right file and line.
+ *
+ * Names are paths with '/' between directories. #include "file" is looked
+ * up next to the file that includes it first, and then from the provider's
+ * root, while #include <file> is only looked up from the root. Names that
+ * lead out of the root with ".." are not looked up at all. Every file
+ * is spliced in once per shader, where it is first included, as if it had
+ * #pragma once, so a file that two others include does not need include
+ * guards.
+ *
+ * Translated shaders are remembered along with the files they were built
+ * from. When a file changes, invalidate() forgets only the shaders that
+ * include it, directly or through another file.
+ * Example usage:
+ *
+ * ShaderMemoryFileProvider files;
+ * files.setFile("lighting.glsl", lightingSource);
+ * files.setFile("mesh.frag", "#include \"lighting.glsl\"\nvoid main() { ... }");
+ * ShaderIncludeTranslator includes(files);
+ * auto shader = includes.translate(translator, "mesh.frag", ShaderTranslator::FRAGMENT);
+ *
+ * @note The translator's preprocessing is not applied to included shaders,
+ *       their conditionals are left to the driver. Minifying is applied to
+ *       the spliced shader, which loses the line numbers of its files.
+ *       Reflection lists the variables of every file in the order the files
+ *       are spliced, and attributes are placed at explicit locations in the
+ *       order they are spliced. An include translator is not meant to be
+ *       shared between threads.
+ */
+class ShaderIncludeTranslator {
+public:
+	/**
+	 * Creates an include translator.
+	 * @param provider The provider that files are read from. It must outlive
+	 *  the include translator.
+	 */
+	explicit ShaderIncludeTranslator(const ShaderFileProvider &provider);
+
+	/**
+	 * Translates a shader and the files it includes, or returns the shader
+	 * from before if none of its files were invalidated since.
+	 * @param translator The translator that supplies the header and rewrite rules.
+	 * @param name The name of the shader's file.
+	 * @param shaderType The type of shader that is being translated.
+	 * @return the translated shader, or null if the shader's file could not be read.
+	 */
+	std::shared_ptr<const ShaderIncludedShader> translate(const ShaderTranslator &translator, const std::string &name, ShaderTranslator::ShaderType shaderType);
+
+	/**
+	 * Forgets everything that was built from a file, because it changed.
+	 * @param name The name of the file.
+	 * @return the names of the shaders that were built from the file.
+	 */
+	std::vector<std::string> invalidate(const std::string &name);
+
+	/**
+	 * Get's the shaders that were built from a file and are still remembered.
+	 * @param name The name of the file.
+	 * @return the names of the shaders.
+	 */
+	std::vector<std::string> getDependents(const std::string &name) const;
+
+	/**
+	 * Forgets every shader and every translated file.
+	 */
+	void clear();
+
+	/**
+	 * Get's the number of files that were translated, rather than found in
+	 * the cache, since the include translator was created.
+	 * @return the number of files.
+	 */
+	size_t getModuleTranslationCount() const {
+		return mModuleTranslations;
+	}
+
+private:
+	/**
+	 * An #include in a translated file.
+	 */
+	struct Include {
+		/**
+		 * Where the #include directive is in the translated code.
+		 */
+		size_t offset;
+		size_t length;
+
+		std::string name;
+
+		/**
+		 * The line the directive ends on.
+		 */
+		uint32_t line;
+
+		/**
+		 * If the name is in angle brackets, which skips the directory of the
+		 * including file.
+		 */
+		bool angled;
+	};
+
+	/**
+	 * An attribute qualifier in a translated file, which is replaced when
+	 * the attribute is placed at an explicit location.
+	 */
+	struct Attribute {
+		/**
+		 * Where the translated qualifier is in the translated code.
+		 */
+		size_t offset;
+		size_t length;
+
+		/**
+		 * The index of the attribute in the file's variables.
+		 */
+		size_t variable;
+	};
+
+	/**
+	 * A file translated on its own, without the header.
+	 */
+	struct Module {
+		std::string code;
+		std::vector<Include> includes;
+		std::vector<Attribute> attributes;
+
+		/**
+		 * The attributes, varyings and uniforms the file declares, when the
+		 * translator reflects.
+		 */
+		std::vector<ShaderReflectionVariable> variables;
+	};
+
+	struct ShaderKey {
+		std::string name;
+		uint64_t configuration;
+		ShaderTranslator::ShaderType shaderType;
+
+		bool operator==(const ShaderKey &other) const {
+			return name == other.name && configuration == other.configuration && shaderType == other.shaderType;
+		}
+
+		struct Hasher {
+			size_t operator()(const ShaderKey &key) const {
+				return std::hash<std::string>()(key.name) ^ static_cast<size_t>(key.configuration ^ (static_cast<uint64_t>(key.shaderType) << 32));
+			}
+		};
+	};
+
+	/**
+	 * What the current translate() call works with.
+	 */
+	struct Build {
+		const ShaderTranslator *translator;
+		ShaderTranslator::ShaderType shaderType;
+		ShaderIncludedShader *shader;
+
+		/**
+		 * The files that are being spliced in, innermost last.
+		 */
+		std::vector<size_t> stack;
+
+		/**
+		 * The source string numbers of the files that were spliced in so far.
+		 */
+		std::unordered_set<size_t> spliced;
+
+		/**
+		 * The next free attribute location.
+		 */
+		uint32_t location;
+	};
+
+	/**
+	 * Reads a file and finds its translation, translating it if needed.
+	 * @param build The current translation.
+	 * @param name The name of the file.
+	 * @return the translated file, or null if it could not be read.
+	 */
+	std::shared_ptr<const Module> loadModule(Build &build, const std::string &name);
+
+	/**
+	 * Finds the file an #include names and reads it.
+	 * @param build The current translation.
+	 * @param include The #include, in the file that is being spliced in.
+	 * @param name Receives the name of the file. The places that were
+	 *  looked at without finding it are added to the shader's missing files.
+	 * @return the translated file, or null if it could not be read.
+	 */
+	std::shared_ptr<const Module> loadInclude(Build &build, const Include &include, std::string &name);
+
+	/**
+	 * Translates a file on its own.
+	 * @param build The current translation.
+	 * @param source The contents of the file.
+	 * @return the translated file, or null if it is too large to tokenize.
+	 */
+	std::shared_ptr<const Module> translateModule(Build &build, std::string_view source);
+
+	/**
+	 * Appends a translated file to the shader, splicing in what it includes.
+	 * @param build The current translation.
+	 * @param module The translated file.
+	 */
+	void splice(Build &build, const Module &module);
+
+	/**
+	 * Appends the code of a translated file up to an offset, placing the
+	 * attributes on the way at explicit locations.
+	 * @param build The current translation.
+	 * @param module The translated file.
+	 * @param end Where to stop.
+	 * @param pos How much of the code has been appended, which is moved to 'end'.
+	 * @param attribute The next attribute of the file, which is moved past
+	 *  the ones that were placed.
+	 */
+	void appendCode(Build &build, const Module &module, size_t end, size_t &pos, size_t &attribute);
+
+	/**
+	 * Get's the source string number of a file in the current shader.
+	 * @param build The current translation.
+	 * @param name The name of the file.
+	 * @return the source string number.
+	 */
+	size_t getSourceString(Build &build, const std::string &name);
+
+	const ShaderFileProvider &mProvider;
+	ShaderTranslationContext mContext;
+
+	std::unordered_map<ShaderTranslationCache::Key, std::shared_ptr<const Module>, ShaderTranslationCache::Key::Hasher> mModules;
+	std::unordered_map<ShaderKey, std::shared_ptr<const ShaderIncludedShader>, ShaderKey::Hasher> mShaders;
+
+	/**
+	 * The include graph, turned around: the shaders built from every file,
+	 * and the cached translations of every file.
+	 */
+	std::unordered_map<std::string, std::unordered_set<std::string>> mDependents;
+	std::unordered_map<std::string, std::vector<ShaderTranslationCache::Key>> mFileModules;
+
+	/**
+	 * The files read by the current translate() call.
+	 */
+	std::unordered_map<std::string, std::shared_ptr<const Module>> mLoaded;
+	std::string mFileSource;
+
+	/**
+	 * The reflection of the current translate() call. Files are reflected
+	 * into the context's own.
+	 */
+	ShaderReflection mReflection;
+
+	size_t mModuleTranslations;
+};
+
+#endif /* shaderIncludeTranslator_h */
\ No newline at end of file
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "shaderIncrementalTranslator.h"
+
+/**
+ * Replaces the elements [first, end) of a vector with 'count' elements,
+ * without reallocating when the size stays the same.
+ */
+template <typename T>
+static void spliceRange(std::vector<T> &vec, size_t first, size_t end, const T *data, size_t count) {
+	size_t old = end - first;
+	if (count > old)
+		vec.insert(vec.begin() + end, count - old, T());
+	else if (count < old)
+		vec.erase(vec.begin() + first + count, vec.begin() + end);
+	std::copy(data, data + count, vec.begin() + first);
+}
+
+ShaderIncrementalTranslator::ShaderIncrementalTranslator(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType) :
+	mTranslator(translator),
+	mShaderType(shaderType),
+	mRetokenized(0) {
+	translateAll();
+}
+
+const std::string &ShaderIncrementalTranslator::translate(std::string_view source) {
+	mSource.assign(source);
+	translateAll();
+	return mOutput;
+}
+
+std::string_view ShaderIncrementalTranslator::rewrite(const ShaderToken &token) const {
+	std::string_view text(mSource.data() + token.offset, token.length);
+	if (token.kind != ShaderToken::IDENTIFIER)
+		return text;
+
+	size_t end = token.offset + token.length;
+	char next = end < mSource.length() ? mSource[end] : '\0';
+	std::string_view replacement = mTranslator.rewriteToken(mShaderType, text, next);
+	return replacement.empty() ? text : replacement;
+}
+
+void ShaderIncrementalTranslator::translateAll() {
+	if (mTranslator.needsTokenList()) {
+		mOutput = mTranslator.translate(mContext, mSource, mShaderType);
+		mRetokenized = mContext.getTokens().size();
+		mTokens.clear();
+		mOutputOffsets.clear();
+		return;
+	}
+
+	mTokens.clear();
+	mOutputOffsets.clear();
+	mOutput.assign(mTranslator.getHeader(mShaderType));
+	for (size_t pos = 0; pos < mSource.length();) {
+		ShaderToken token = ShaderTranslationContext::readToken(mSource, pos);
+		mTokens.push_back(token);
+		mOutputOffsets.push_back(mOutput.length());
+		mOutput.append(rewrite(token));
+		pos += token.length;
+	}
+	mRetokenized = mTokens.size();
+}
+
+const std::string &ShaderIncrementalTranslator::edit(size_t offset, size_t length, std::string_view text) {
+	offset = std::min(offset, mSource.length());
+	length = std::min(length, mSource.length() - offset);
+
+	if (mTranslator.needsTokenList() || mTokens.empty()) {
+		mSource.replace(offset, length, text);
+		translateAll();
+		return mOutput;
+	}
+
+	// A token only depends on its own characters and the one after it, so
+	// the first token that can change is the first one that reaches the edit.
+	// The rewrite of the token before it looks at a character before the
+	// edit, so it stays the same as well.
+	size_t first = std::lower_bound(mTokens.begin(), mTokens.end(), offset, [](const ShaderToken &token, size_t pos) {
+		return token.offset + token.length < pos;
+	}) - mTokens.begin();
+
+	mSource.replace(offset, length, text);
+	size_t oldEnd = offset + length;
+	size_t newEnd = offset + text.length();
+
+	// Relex until a token starts past the edit where an old token started,
+	// at which point every token after it is the same as before.
+	size_t end = first;
+	size_t pos = mTokens[first].offset;
+	mNewTokens.clear();
+	while (pos < mSource.length()) {
+		if (pos >= newEnd) {
+			size_t oldPos = pos - newEnd + oldEnd;
+			while (end < mTokens.size() && mTokens[end].offset < oldPos)
+				end++;
+			if (end < mTokens.size() && mTokens[end].offset == oldPos)
+				break;
+		}
+		ShaderToken token = ShaderTranslationContext::readToken(mSource, pos);
+		mNewTokens.push_back(token);
+		pos += token.length;
+	}
+	if (pos >= mSource.length())
+		end = mTokens.size();
+
+	// Rebuild the output of the relexed tokens.
+	size_t outStart = mOutputOffsets[first];
+	size_t outEnd = end < mTokens.size() ? mOutputOffsets[end] : mOutput.length();
+	mPatch.clear();
+	mNewOffsets.clear();
+	for (const ShaderToken &token : mNewTokens) {
+		mNewOffsets.push_back(outStart + mPatch.length());
+		mPatch.append(rewrite(token));
+	}
+	mOutput.replace(outStart, outEnd - outStart, mPatch);
+
+	// Splice the relexed tokens in and move the ones after them.
+	spliceRange(mTokens, first, end, mNewTokens.data(), mNewTokens.size());
+	spliceRange(mOutputOffsets, first, end, mNewOffsets.data(), mNewOffsets.size());
+	size_t sourceDelta = newEnd - oldEnd;
+	size_t outputDelta = mPatch.length() - (outEnd - outStart);
+	for (size_t i = first + mNewTokens.size(); i < mTokens.size(); i++) {
+		mTokens[i].offset += static_cast<uint32_t>(sourceDelta);
+		mOutputOffsets[i] += outputDelta;
+	}
+
+	mRetokenized = mNewTokens.size();
+	return mOutput;
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderIncrementalTranslator_h
+#define shaderIncrementalTranslator_h
+
+#include <string>
+#include <vector>
+#include "shaderTranslator.h"
+#include "shaderTranslationContext.h"
+
+/**
+ * Keeps a shader and its translation in memory so an editor or a file
+ * watcher can retranslate it after every change. An edit only relexes the
+ * tokens whose characters changed, plus the tokens after them until the new
+ * token boundaries line up with the old ones again, and only their part of
+ * the output is rebuilt. The output is always the same as a full translate().
+ * Example usage:
+ *
+ * ShaderTranslatorGL33 translator;
+ * ShaderIncrementalTranslator shader(translator, ShaderTranslator::FRAGMENT);
+ * shader.translate(source);
+ * const std::string &output = shader.edit(offset, length, "texture2D");
+ *
+ * @note Shaders are translated in full on every edit while the translator
+ *       is preprocessing, since a changed #if can change any part of it,
+ *       while it is minifying, since a changed name can rename others, and
+ *       while it is reflecting or placing explicit locations, since a
+ *       changed declaration can move the locations after it.
+ */
+class ShaderIncrementalTranslator {
+public:
+	/**
+	 * Creates an incremental translator with an empty shader.
+	 * @param translator The translator that supplies the header and rewrite
+	 *  rules. It must outlive the incremental translator.
+	 * @param shaderType The type of shader that is being translated.
+	 */
+	ShaderIncrementalTranslator(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType);
+
+	/**
+	 * Replaces the whole shader and translates it.
+	 * @param source The shader source. It is copied.
+	 * @return the translated shader source.
+	 */
+	const std::string &translate(std::string_view source);
+
+	/**
+	 * Replaces a range of the shader source and updates the translation.
+	 * The range is clamped to the source.
+	 * @param offset Where the replaced range starts in the source.
+	 * @param length The length of the replaced range in bytes.
+	 * @param text The text that takes the place of the range.
+	 * @return the translated shader source.
+	 */
+	const std::string &edit(size_t offset, size_t length, std::string_view text);
+
+	/**
+	 * Get's the current shader source, with every edit applied.
+	 * @return the shader source.
+	 */
+	const std::string &getSource() const {
+		return mSource;
+	}
+
+	/**
+	 * Get's the translation of the current shader source.
+	 * @return the translated shader source.
+	 */
+	const std::string &getOutput() const {
+		return mOutput;
+	}
+
+	/**
+	 * Get's the number of tokens that were read by the last translate() or
+	 * edit(), which shows how much of the shader had to be looked at again.
+	 * @return the number of tokens.
+	 */
+	size_t getRetokenizedCount() const {
+		return mRetokenized;
+	}
+
+private:
+	/**
+	 * Translates the current source from scratch.
+	 */
+	void translateAll();
+
+	/**
+	 * Decides how a token is written to the output.
+	 * @param token The token.
+	 * @return the text of the token in the output.
+	 */
+	std::string_view rewrite(const ShaderToken &token) const;
+
+	const ShaderTranslator &mTranslator;
+	ShaderTranslator::ShaderType mShaderType;
+	std::string mSource;
+	std::string mOutput;
+	ShaderTokenList mTokens;
+
+	/**
+	 * Where the output of every token starts in mOutput.
+	 */
+	std::vector<size_t> mOutputOffsets;
+
+	/**
+	 * The tokens and output offsets of the range that is being relexed.
+	 */
+	ShaderTokenList mNewTokens;
+	std::vector<size_t> mNewOffsets;
+
+	/**
+	 * The output of the range that is being relexed.
+	 */
+	std::string mPatch;
+
+	/**
+	 * Used for full translations while the translator needs the whole token
+	 * list.
+	 */
+	ShaderTranslationContext mContext;
+
+	size_t mRetokenized;
+};
+
+#endif /* shaderIncrementalTranslator_h */
\ No newline at end of file
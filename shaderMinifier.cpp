@@ -0,0 +1,516 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "shaderMinifier.h"
+
+/**
+ * The builtin types. Sampler and image types are matched by prefix.
+ */
+static const std::string_view SHADER_TYPES[] = {
+	"bool", "bvec2", "bvec3", "bvec4", "dmat2", "dmat2x2", "dmat2x3", "dmat2x4",
+	"dmat3", "dmat3x2", "dmat3x3", "dmat3x4", "dmat4", "dmat4x2", "dmat4x3",
+	"dmat4x4", "double", "dvec2", "dvec3", "dvec4", "float", "int", "ivec2",
+	"ivec3", "ivec4", "mat2", "mat2x2", "mat2x3", "mat2x4", "mat3", "mat3x2",
+	"mat3x3", "mat3x4", "mat4", "mat4x2", "mat4x3", "mat4x4", "uint", "uvec2",
+	"uvec3", "uvec4", "vec2", "vec3", "vec4", "void"
+};
+
+static const std::string_view SHADER_QUALIFIERS[] = {
+	"attribute", "buffer", "centroid", "coherent", "const", "flat", "highp",
+	"in", "inout", "invariant", "lowp", "mediump", "noperspective", "out",
+	"patch", "precise", "readonly", "restrict", "sample", "shared", "smooth",
+	"uniform", "varying", "volatile", "writeonly"
+};
+
+/**
+ * The qualifiers that make a global visible outside of the shader.
+ */
+static const std::string_view SHADER_INTERFACE_QUALIFIERS[] = {
+	"attribute", "buffer", "in", "out", "patch", "shared", "uniform", "varying"
+};
+
+static const std::string_view SHADER_KEYWORDS[] = {
+	"asm", "break", "case", "class", "continue", "default", "discard", "do",
+	"else", "enum", "extern", "external", "false", "filter", "fixed", "for",
+	"goto", "half", "if", "inline", "input", "interface", "layout", "long",
+	"namespace", "noinline", "output", "precision", "public", "return",
+	"short", "sizeof", "static", "struct", "subroutine", "switch", "template",
+	"this", "true", "typedef", "union", "unsigned", "using", "while"
+};
+
+static const std::string_view SHADER_BUILTIN_FUNCTIONS[] = {
+	"EmitVertex", "EndPrimitive", "abs", "acos", "acosh", "all", "any", "asin",
+	"asinh", "atan", "atanh", "ceil", "clamp", "cos", "cosh", "cross", "dFdx",
+	"dFdy", "degrees", "determinant", "distance", "dot", "equal", "exp",
+	"exp2", "faceforward", "floatBitsToInt", "floatBitsToUint", "floor",
+	"fract", "ftransform", "fwidth", "greaterThan", "greaterThanEqual",
+	"intBitsToFloat", "inverse", "inversesqrt", "isinf", "isnan", "length",
+	"lessThan", "lessThanEqual", "log", "log2", "matrixCompMult", "max", "min",
+	"mix", "mod", "modf", "noise1", "noise2", "noise3", "noise4", "normalize",
+	"not", "notEqual", "outerProduct", "pow", "radians", "reflect", "refract",
+	"round", "roundEven", "shadow1D", "shadow1DLod", "shadow1DProj",
+	"shadow1DProjLod", "shadow2D", "shadow2DLod", "shadow2DProj",
+	"shadow2DProjLod", "sign", "sin", "sinh", "smoothstep", "sqrt", "step",
+	"tan", "tanh", "texelFetch", "texelFetchOffset", "texture", "texture1D",
+	"texture1DLod", "texture1DProj", "texture1DProjLod", "texture2D",
+	"texture2DLod", "texture2DProj", "texture2DProjLod", "texture3D",
+	"texture3DLod", "texture3DProj", "texture3DProjLod", "textureCube",
+	"textureCubeLod", "textureGrad", "textureGradOffset", "textureLod",
+	"textureLodOffset", "textureOffset", "textureProj", "textureProjGrad",
+	"textureProjGradOffset", "textureProjLod", "textureProjLodOffset",
+	"textureProjOffset", "textureSize", "transpose", "trunc",
+	"uintBitsToFloat"
+};
+
+/**
+ * The pairs of punctuation that read as a different token, or start a
+ * comment, when nothing separates them.
+ */
+static const std::string_view SHADER_JOINED_PUNCTUATION[] = {
+	"!=", "##", "%=", "&&", "&=", "*=", "++", "+=", "--", "-=", "/*", "//",
+	"/=", "<<", "<=", "==", ">=", ">>", "^=", "^^", "|=", "||"
+};
+
+/**
+ * The characters of short names. Names never start with a digit.
+ */
+static const char SHADER_NAME_CHARACTERS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+#define SHADER_NAME_FIRST_CHARACTERS 52
+#define SHADER_NAME_CHARACTER_COUNT 62
+
+template <size_t N>
+static bool contains(const std::string_view (&list)[N], std::string_view name) {
+	return std::binary_search(list, list + N, name);
+}
+
+static bool startsWith(std::string_view text, std::string_view prefix) {
+	return text.substr(0, prefix.length()) == prefix;
+}
+
+static bool isBuiltinType(std::string_view name) {
+	return contains(SHADER_TYPES, name) || startsWith(name, "sampler") || startsWith(name, "isampler") ||
+		startsWith(name, "usampler") || startsWith(name, "image") || startsWith(name, "iimage") || startsWith(name, "uimage");
+}
+
+/**
+ * Determines if a name is a word of the language, which is never renamed
+ * and never given out as a short name.
+ */
+static bool isReserved(std::string_view name) {
+	return isBuiltinType(name) || contains(SHADER_QUALIFIERS, name) || contains(SHADER_KEYWORDS, name) ||
+		contains(SHADER_BUILTIN_FUNCTIONS, name) || startsWith(name, "gl_") || name.find("__") != std::string_view::npos;
+}
+
+/**
+ * Makes the short name with the given number: a to Z, then aa, ab and so on.
+ */
+static void makeShortName(size_t number, std::string &name) {
+	name.assign(1, SHADER_NAME_CHARACTERS[number % SHADER_NAME_FIRST_CHARACTERS]);
+	number /= SHADER_NAME_FIRST_CHARACTERS;
+	while (number) {
+		number--;
+		name.push_back(SHADER_NAME_CHARACTERS[number % SHADER_NAME_CHARACTER_COUNT]);
+		number /= SHADER_NAME_CHARACTER_COUNT;
+	}
+}
+
+static bool isWord(ShaderToken::Kind kind) {
+	return kind == ShaderToken::IDENTIFIER || kind == ShaderToken::NUMBER;
+}
+
+/**
+ * Determines if two tokens that had whitespace or a comment between them
+ * still need a space once it is gone.
+ */
+static bool needsSpace(ShaderToken::Kind prevKind, char prev, ShaderToken::Kind kind, char next) {
+	if (isWord(prevKind) && isWord(kind))
+		return true;
+
+	// 1 .5 is not 1.5
+	if ((prevKind == ShaderToken::NUMBER && next == '.') || (prev == '.' && isWord(kind)))
+		return true;
+
+	if (prevKind == ShaderToken::PUNCTUATION && kind == ShaderToken::PUNCTUATION) {
+		const char pair[2] = { prev, next };
+		return contains(SHADER_JOINED_PUNCTUATION, std::string_view(pair, 2));
+	}
+	return false;
+}
+
+void ShaderMinifier::minify(std::string &shader, bool nameMap) {
+	mSource.assign(shader);
+	if (!mContext.tokenize(mSource))
+		return;
+	mNames.clear();
+	mNameMap.clear();
+
+	findCode();
+	findDeclarations();
+	assignNames();
+	write(shader, nameMap);
+}
+
+void ShaderMinifier::findCode() {
+	const ShaderTokenList &tokens = mContext.getTokens();
+	size_t count = tokens.size();
+	mDirective.assign(count, 0);
+	mCode.clear();
+
+	// Directives are only recognized when the # is the first thing on a
+	// line, and run up to the end of the line unless it ends in a backslash.
+	bool lineStart = true;
+	bool directive = false;
+	for (size_t i = 0; i < count; i++) {
+		const ShaderToken &token = tokens[i];
+		bool newline = (token.kind == ShaderToken::WHITESPACE || token.kind == ShaderToken::COMMENT) &&
+			memchr(mSource.data() + token.offset, '\n', token.length);
+		if (directive && token.kind == ShaderToken::WHITESPACE && newline) {
+			const ShaderToken &prev = tokens[i - 1];
+			directive = prev.kind == ShaderToken::PUNCTUATION && mSource[prev.offset] == '\\';
+		} else if (lineStart && token.kind == ShaderToken::PUNCTUATION && mSource[token.offset] == '#') {
+			directive = true;
+		}
+		mDirective[i] = directive;
+
+		if (newline)
+			lineStart = true;
+		else if (token.kind != ShaderToken::WHITESPACE && token.kind != ShaderToken::COMMENT)
+			lineStart = false;
+
+		if (token.kind == ShaderToken::IDENTIFIER) {
+			auto added = mNames.try_emplace(mContext.getTokenText(token));
+			Name &name = added.first->second;
+			if (added.second)
+				name.first = static_cast<uint32_t>(i);
+			name.uses++;
+
+			// The preprocessor is not understood, so its names stay as they are.
+			if (directive)
+				name.kept = true;
+		}
+
+		if (!directive && token.kind != ShaderToken::WHITESPACE && token.kind != ShaderToken::COMMENT)
+			mCode.push_back(i);
+	}
+
+	// Members and swizzles are looked up in the type of what comes before
+	// the dot, so they keep their names.
+	for (size_t k = 0; k + 1 < mCode.size(); k++) {
+		if (getCode(k) == "." && tokens[mCode[k + 1]].kind == ShaderToken::IDENTIFIER)
+			getName(k + 1).kept = true;
+	}
+}
+
+void ShaderMinifier::findDeclarations() {
+	mBraces.clear();
+	bool statementStart = true;
+	bool functionBody = false;
+	size_t count = mCode.size();
+	for (size_t k = 0; k < count; ) {
+		if (statementStart) {
+			statementStart = false;
+			size_t next = readDeclaration(k, functionBody);
+			if (next != k) {
+				k = next;
+				continue;
+			}
+		}
+
+		std::string_view text = getCode(k);
+		if (text == "{") {
+			mBraces.push_back(functionBody || (!mBraces.empty() && mBraces.back()));
+			functionBody = false;
+			statementStart = true;
+		} else if (text == "}") {
+			if (!mBraces.empty())
+				mBraces.pop_back();
+			statementStart = true;
+		} else if (text == ";") {
+			functionBody = false;
+			statementStart = true;
+		} else if (text == "(" && k > 0 && getCode(k - 1) == "for") {
+			statementStart = true;
+		}
+		k++;
+	}
+}
+
+size_t ShaderMinifier::readDeclaration(size_t index, bool &functionBody) {
+	bool global = mBraces.empty();
+	bool member = !global && !mBraces.back();
+	bool interface = false;
+	size_t i = index;
+	for (;;) {
+		std::string_view text = getCode(i);
+		if (text == "layout" && getCode(i + 1) == "(") {
+			i = skipGroup(i + 1);
+		} else if (contains(SHADER_QUALIFIERS, text)) {
+			interface |= contains(SHADER_INTERFACE_QUALIFIERS, text);
+			i++;
+		} else {
+			break;
+		}
+	}
+
+	// A struct name becomes a type. The members are read when the main
+	// loop gets to the brace.
+	if (getCode(i) == "struct") {
+		if (!isName(i + 1))
+			return i + 1;
+		Name &name = getName(i + 1);
+		name.kept = true;
+		name.type = true;
+		return i + 2;
+	}
+
+	if (!isTypeName(i)) {
+		// The name of an interface block, such as uniform Lights { ... }.
+		if (interface && isName(i) && getCode(i + 1) == "{") {
+			getName(i).kept = true;
+			return i + 1;
+		}
+		return index;
+	}
+
+	i++;
+	if (getCode(i) == "[")
+		i = skipGroup(i);
+
+	bool kept = (global && interface) || member;
+	for (;;) {
+		if (!isName(i))
+			return i;
+
+		Name &name = getName(i);
+		if (global && getCode(i + 1) == "(") {
+			// A function. main is called by the driver.
+			if (getCode(i) == "main")
+				name.kept = true;
+			else
+				name.declared = true;
+			i = readParameters(i + 1);
+			functionBody = getCode(i) == "{";
+			return i;
+		}
+
+		if (kept)
+			name.kept = true;
+		else
+			name.declared = true;
+
+		i = skipDeclarator(i + 1);
+		if (getCode(i) != ",")
+			return i;
+		i++;
+	}
+}
+
+size_t ShaderMinifier::readParameters(size_t index) {
+	size_t count = mCode.size();
+	size_t i = index + 1;
+	while (i < count && getCode(i) != ")") {
+		while (contains(SHADER_QUALIFIERS, getCode(i)))
+			i++;
+		if (isTypeName(i)) {
+			i++;
+			if (getCode(i) == "[")
+				i = skipGroup(i);
+			if (isName(i))
+				getName(i).declared = true;
+		}
+
+		i = skipDeclarator(i);
+		if (getCode(i) == ",")
+			i++;
+		else if (getCode(i) != ")")
+			return i;
+	}
+	return (i < count) ? i + 1 : i;
+}
+
+size_t ShaderMinifier::skipDeclarator(size_t index) const {
+	size_t count = mCode.size();
+	size_t depth = 0;
+	for (size_t i = index; i < count; i++) {
+		std::string_view text = getCode(i);
+		if (text == "(" || text == "[") {
+			depth++;
+		} else if (text == ")" || text == "]") {
+			if (depth == 0)
+				return i;
+			depth--;
+		} else if (text == "{" || text == "}" || ((text == "," || text == ";") && depth == 0)) {
+			return i;
+		}
+	}
+	return count;
+}
+
+size_t ShaderMinifier::skipGroup(size_t index) const {
+	size_t count = mCode.size();
+	size_t depth = 0;
+	for (size_t i = index; i < count; i++) {
+		std::string_view text = getCode(i);
+		if (text == "(" || text == "[") {
+			depth++;
+		} else if (text == ")" || text == "]") {
+			if (--depth == 0)
+				return i + 1;
+		} else if (text == "{" || text == "}" || text == ";") {
+			return i;
+		}
+	}
+	return count;
+}
+
+void ShaderMinifier::assignNames() {
+	mRenamed.clear();
+	for (auto &entry : mNames) {
+		Name &name = entry.second;
+		if (name.declared && !name.kept && !isReserved(entry.first))
+			mRenamed.push_back({ entry.first, &name });
+	}
+
+	// The most used names get the shortest names. Ties go in the order the
+	// names first appear, so the output does not depend on the hash map.
+	std::sort(mRenamed.begin(), mRenamed.end(), [](const auto &a, const auto &b) {
+		if (a.second->uses != b.second->uses)
+			return a.second->uses > b.second->uses;
+		return a.second->first < b.second->first;
+	});
+
+	size_t number = 0;
+	std::string shortName;
+	makeShortName(number, shortName);
+	for (auto &renamed : mRenamed) {
+		while (mNames.count(shortName) || isReserved(shortName))
+			makeShortName(++number, shortName);
+
+		// A name that is already short stays as it is.
+		if (shortName.length() >= renamed.first.length())
+			continue;
+		renamed.second->shortName = shortName;
+		mNameMap.push_back({ std::string(renamed.first), shortName });
+		makeShortName(++number, shortName);
+	}
+}
+
+void ShaderMinifier::write(std::string &shader, bool nameMap) {
+	const ShaderTokenList &tokens = mContext.getTokens();
+	shader.clear();
+
+	// Whether whitespace or a comment was dropped since the last token.
+	bool space = false;
+	bool directive = false;
+	ShaderToken::Kind prevKind = ShaderToken::WHITESPACE;
+	char prev = '\0';
+	for (size_t i = 0; i < tokens.size(); i++) {
+		const ShaderToken &token = tokens[i];
+		if (mDirective[i] != directive) {
+			// Directives have to be on lines of their own.
+			if (!shader.empty() && shader.back() != '\n')
+				shader.push_back('\n');
+			directive = mDirective[i];
+			space = false;
+			prevKind = ShaderToken::WHITESPACE;
+		}
+
+		if (token.kind == ShaderToken::WHITESPACE || token.kind == ShaderToken::COMMENT) {
+			// The only newline left inside a directive is a line continuation.
+			if (directive && token.kind == ShaderToken::WHITESPACE && prev == '\\' &&
+				memchr(mSource.data() + token.offset, '\n', token.length)) {
+				shader.push_back('\n');
+				prevKind = ShaderToken::WHITESPACE;
+				prev = '\0';
+			} else {
+				space = true;
+			}
+			continue;
+		}
+
+		std::string_view text = mContext.getTokenText(token);
+		if (token.kind == ShaderToken::IDENTIFIER) {
+			const Name &name = mNames.find(text)->second;
+			if (!name.shortName.empty())
+				text = name.shortName;
+		}
+
+		// Spaces inside directives can matter, as in #define F (x), so one
+		// is kept wherever there was any.
+		if (space && prevKind != ShaderToken::WHITESPACE && (directive || needsSpace(prevKind, prev, token.kind, text.front())))
+			shader.push_back(' ');
+		shader.append(text);
+		space = false;
+		prevKind = token.kind;
+		prev = text.back();
+	}
+
+	if (!shader.empty() && shader.back() != '\n')
+		shader.push_back('\n');
+
+	if (nameMap) {
+		for (const ShaderMinifiedName &name : mNameMap) {
+			shader += "// ";
+			shader += name.shortName;
+			shader += " = ";
+			shader += name.name;
+			shader += '\n';
+		}
+	}
+}
+
+std::string_view ShaderMinifier::getCode(size_t index) const {
+	if (index >= mCode.size())
+		return std::string_view();
+	return mContext.getTokenText(mContext.getTokens()[mCode[index]]);
+}
+
+bool ShaderMinifier::isName(size_t index) const {
+	if (index >= mCode.size() || mContext.getTokens()[mCode[index]].kind != ShaderToken::IDENTIFIER)
+		return false;
+	std::string_view text = getCode(index);
+	return !isBuiltinType(text) && !contains(SHADER_QUALIFIERS, text) && !contains(SHADER_KEYWORDS, text);
+}
+
+bool ShaderMinifier::isTypeName(size_t index) const {
+	if (index >= mCode.size() || mContext.getTokens()[mCode[index]].kind != ShaderToken::IDENTIFIER)
+		return false;
+	std::string_view text = getCode(index);
+	if (isBuiltinType(text))
+		return true;
+	auto name = mNames.find(text);
+	return name != mNames.end() && name->second.type;
+}
+
+ShaderMinifier::Name &ShaderMinifier::getName(size_t index) {
+	return mNames.find(getCode(index))->second;
+}
\ No newline at end of file
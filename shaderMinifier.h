@@ -0,0 +1,195 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderMinifier_h
+#define shaderMinifier_h
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "shaderTranslationContext.h"
+
+/**
+ * A name the minifier shortened, for the debug name map.
+ */
+struct ShaderMinifiedName {
+	std::string name;
+	std::string shortName;
+};
+
+/**
+ * Shrinks translated shaders so that they are quicker to upload and for the
+ * driver to parse. Comments are stripped, whitespace is cut down to what
+ * keeps the tokens apart and the preprocessor directives on lines of their
+ * own, and local variables, parameters, functions and plain globals are given
+ * the shortest free names, the most used names first.
+ *
+ * Everything the application or the driver looks up by name keeps its name:
+ * uniforms, attributes, varyings, in and out variables (which covers
+ * GEN_OUTPUT_FINAL_COLOR), main, gl_ names, builtins, the members of structs
+ * and blocks, and every name that is used by a preprocessor directive. A
+ * name is replaced wherever it is spelled, so scopes do not have to be
+ * tracked, and a name that is kept anywhere is kept everywhere.
+ *
+ * @note The line numbers of a minified shader no longer match its source,
+ *       and a stage that is linked from several shader objects must not be
+ *       minified, since the functions they share would be renamed apart.
+ *       A minifier is not meant to be shared between threads.
+ */
+class ShaderMinifier {
+public:
+	/**
+	 * Minifies a shader in place.
+	 * @param shader The shader source, which receives the minified source.
+	 * @param nameMap Set to append the names that were shortened to the
+	 *  shader as comments, one "// short = name" line each, for debugging.
+	 * @note Shaders of 4 GB or more are left as they are.
+	 */
+	void minify(std::string &shader, bool nameMap = false);
+
+	/**
+	 * Get's the names that were shortened in the last shader, the most used
+	 * first.
+	 * @return the list of names.
+	 */
+	const std::vector<ShaderMinifiedName> &getNameMap() const {
+		return mNameMap;
+	}
+
+private:
+	/**
+	 * What is known about a name that is spelled in the shader.
+	 */
+	struct Name {
+		uint32_t uses = 0;
+		uint32_t first = 0;
+
+		// Declared as something that may be renamed.
+		bool declared = false;
+
+		// Visible from outside the shader, or used in a way that is not
+		// understood, so it must not be renamed.
+		bool kept = false;
+
+		// The name of a struct, so it starts declarations.
+		bool type = false;
+
+		std::string shortName;
+	};
+
+	/**
+	 * Marks the tokens that belong to preprocessor directives, and lists the
+	 * tokens of the code in between that are neither whitespace nor comments.
+	 */
+	void findCode();
+
+	/**
+	 * Finds the declarations in the code, which decides the names that may
+	 * be renamed and the ones that are kept.
+	 */
+	void findDeclarations();
+
+	/**
+	 * Reads a declaration if one starts at a code token.
+	 * @param index The index into the code tokens.
+	 * @param functionBody Set if the declaration is a function definition,
+	 *  whose body follows.
+	 * @return the code token after the declaration, or 'index' if there is
+	 *  no declaration.
+	 */
+	size_t readDeclaration(size_t index, bool &functionBody);
+
+	/**
+	 * Reads the parameter list of a function.
+	 * @param index The index of the opening parenthesis.
+	 * @return the code token after the closing parenthesis.
+	 */
+	size_t readParameters(size_t index);
+
+	/**
+	 * Skips the rest of a declarator, such as its array size and initializer.
+	 * @return the index of the ',', ';', ')', '{' or '}' that ends it.
+	 */
+	size_t skipDeclarator(size_t index) const;
+
+	/**
+	 * Skips a group in parentheses or brackets.
+	 * @param index The index of the opening parenthesis or bracket.
+	 * @return the code token after the group.
+	 */
+	size_t skipGroup(size_t index) const;
+
+	/**
+	 * Gives the names that may be renamed their short names.
+	 */
+	void assignNames();
+
+	/**
+	 * Writes the minified shader.
+	 */
+	void write(std::string &shader, bool nameMap);
+
+	std::string_view getCode(size_t index) const;
+	bool isName(size_t index) const;
+	bool isTypeName(size_t index) const;
+	Name &getName(size_t index);
+
+	/**
+	 * A copy of the shader that is minified, which the tokens point into.
+	 */
+	std::string mSource;
+
+	ShaderTranslationContext mContext;
+
+	/**
+	 * Set for every token that is part of a preprocessor directive.
+	 */
+	std::vector<uint8_t> mDirective;
+
+	/**
+	 * The indices of the tokens outside of directives that are neither
+	 * whitespace nor comments.
+	 */
+	std::vector<size_t> mCode;
+
+	/**
+	 * For every open brace, set if it holds code rather than the members
+	 * of a struct or block.
+	 */
+	std::vector<uint8_t> mBraces;
+
+	std::unordered_map<std::string_view, Name> mNames;
+	std::vector<std::pair<std::string_view, Name *>> mRenamed;
+	std::vector<ShaderMinifiedName> mNameMap;
+};
+
+#endif /* shaderMinifier_h */
\ No newline at end of file
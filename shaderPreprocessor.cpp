@@ -0,0 +1,715 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "shaderHash.h"
+#include "shaderPreprocessor.h"
+#include "shaderScanner.h"
+
+/**
+ * The longest #line directive the preprocessor writes.
+ */
+#define SHADER_LINE_DIRECTIVE_SIZE 24
+
+/**
+ * Parses a preprocessor integer: decimal, octal or hex with an optional
+ * unsigned suffix. Integers that do not fit in an int64_t are not parsed,
+ * which leaves their condition to the driver.
+ */
+static bool parseInteger(std::string_view text, int64_t &value) {
+	while (!text.empty() && SHADER_CHAR_TABLE.is(text.front(), SHADER_CHAR_SPACE))
+		text.remove_prefix(1);
+	while (!text.empty() && SHADER_CHAR_TABLE.is(text.back(), SHADER_CHAR_SPACE))
+		text.remove_suffix(1);
+	if (!text.empty() && (text.back() == 'u' || text.back() == 'U'))
+		text.remove_suffix(1);
+	if (text.empty())
+		return false;
+
+	int base = 10;
+	if (text.length() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+		base = 16;
+		text.remove_prefix(2);
+	} else if (text.length() > 1 && text[0] == '0') {
+		base = 8;
+		text.remove_prefix(1);
+	}
+
+	uint64_t result = 0;
+	for (char c : text) {
+		int digit;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return false;
+		if (digit >= base || result > (static_cast<uint64_t>(INT64_MAX) - digit) / base)
+			return false;
+		result = result * base + digit;
+	}
+	value = static_cast<int64_t>(result);
+	return true;
+}
+
+/**
+ * Counts the line breaks in a token.
+ */
+static uint32_t countLines(std::string_view source, const ShaderToken &token) {
+	const char *text = source.data() + token.offset;
+	return static_cast<uint32_t>(std::count(text, text + token.length, '\n'));
+}
+
+//------------------------------------------------------------------------------
+// ShaderDefineSet
+//------------------------------------------------------------------------------
+
+void ShaderDefineSet::define(std::string_view name, std::string_view value) {
+	set(name, value, true);
+}
+
+void ShaderDefineSet::undefine(std::string_view name) {
+	set(name, std::string_view(), false);
+}
+
+void ShaderDefineSet::set(std::string_view name, std::string_view value, bool defined) {
+	auto it = std::lower_bound(mDefines.begin(), mDefines.end(), name, [](const ShaderDefine &define, std::string_view key) {
+		return define.name < key;
+	});
+	if (it != mDefines.end() && it->name == name) {
+		it->value = std::string(value);
+		it->defined = defined;
+		return;
+	}
+	mDefines.insert(it, { std::string(name), std::string(value), defined });
+}
+
+const ShaderDefine *ShaderDefineSet::find(std::string_view name) const {
+	auto it = std::lower_bound(mDefines.begin(), mDefines.end(), name, [](const ShaderDefine &define, std::string_view key) {
+		return define.name < key;
+	});
+	if (it != mDefines.end() && it->name == name)
+		return &(*it);
+	return nullptr;
+}
+
+uint64_t ShaderDefineSet::getHash() const {
+	uint64_t hash = shaderHash64(nullptr, 0, mDefines.size());
+	for (const auto &define : mDefines) {
+		hash = shaderHashCombine(hash, shaderHash64(define.name.data(), define.name.length()));
+		hash = shaderHashCombine(hash, shaderHash64(define.value.data(), define.value.length(), define.defined));
+	}
+	return hash;
+}
+
+//------------------------------------------------------------------------------
+// ShaderPreprocessor
+//------------------------------------------------------------------------------
+
+bool ShaderPreprocessor::run(std::string_view source, const ShaderTokenList &tokens, std::string_view header, const ShaderDefineSet &builtins, const ShaderDefineSet &defines) {
+	scan(source, tokens, defines);
+	return resolve(header, builtins, defines);
+}
+
+void ShaderPreprocessor::scan(std::string_view source, const ShaderTokenList &tokens, const ShaderDefineSet &names) {
+	mSource = source;
+	mTokens = &tokens;
+	mDirectives.clear();
+	mReferences.clear();
+
+	// Directives are only recognized when the # is the first thing on a line.
+	bool lineStart = true;
+	uint32_t line = 1;
+	size_t count = tokens.size();
+	for (size_t i = 0; i < count; ) {
+		const ShaderToken &token = tokens[i];
+		if (lineStart && token.kind == ShaderToken::PUNCTUATION && source[token.offset] == '#') {
+			Directive directive = { i, findDirectiveEnd(i), line, line };
+			for (; i < directive.end; i++) {
+				const ShaderToken &part = tokens[i];
+				if (part.kind == ShaderToken::WHITESPACE || part.kind == ShaderToken::COMMENT)
+					line += countLines(source, part);
+				else if (part.kind == ShaderToken::IDENTIFIER && !names.isEmpty() && names.find(getText(i)))
+					mReferences.push_back({ i, getText(i) });
+			}
+			directive.endLine = line;
+			mDirectives.push_back(directive);
+			lineStart = false;
+			continue;
+		}
+
+		if (token.kind == ShaderToken::WHITESPACE || token.kind == ShaderToken::COMMENT) {
+			uint32_t lines = countLines(source, token);
+			line += lines;
+			if (lines)
+				lineStart = true;
+		} else {
+			lineStart = false;
+			if (token.kind == ShaderToken::IDENTIFIER && !names.isEmpty() && names.find(getText(i)))
+				mReferences.push_back({ i, getText(i) });
+		}
+		i++;
+	}
+}
+
+bool ShaderPreprocessor::resolve(std::string_view header, const ShaderDefineSet &builtins, const ShaderDefineSet &defines) {
+	mState = KNOWN_TRUE;
+	mDroppedDepth = 0;
+	mDropStart = 0;
+	mNextReference = 0;
+	mMacros.clear();
+	mConditionals.clear();
+	mPending.clear();
+
+	for (const auto &define : builtins.getDefines())
+		setMacro(define.name, define.value, define.defined ? KNOWN_TRUE : KNOWN_FALSE);
+	for (const auto &define : defines.getDefines()) {
+		setMacro(define.name, define.value, define.defined ? KNOWN_TRUE : KNOWN_FALSE);
+		findMacro(define.name)->caller = true;
+	}
+
+	bool valid = true;
+	for (size_t i = 0; i < mDirectives.size() && valid; i++) {
+		// The code in front of the directive only uses macros if it is kept.
+		const Directive &directive = mDirectives[i];
+		if (mState != KNOWN_FALSE)
+			markReferenced(0, directive.first);
+		skipReferences(directive.first);
+
+		valid = handleDirective(i);
+		skipReferences(directive.end);
+	}
+
+	// Every conditional has to be closed.
+	if (!mConditionals.empty())
+		valid = false;
+	if (valid)
+		markReferenced(0, SIZE_MAX);
+
+	finish(header, defines, valid);
+	return valid;
+}
+
+size_t ShaderPreprocessor::findDirectiveEnd(size_t first) const {
+	// A directive runs up to the end of its line, unless the line ends in a
+	// backslash. Block comments spanning lines are part of the directive.
+	const ShaderTokenList &tokens = *mTokens;
+	size_t i = first + 1;
+	for (; i < tokens.size(); i++) {
+		const ShaderToken &token = tokens[i];
+		if (token.kind != ShaderToken::WHITESPACE || !memchr(mSource.data() + token.offset, '\n', token.length))
+			continue;
+
+		const ShaderToken &prev = tokens[i - 1];
+		if (prev.kind == ShaderToken::PUNCTUATION && mSource[prev.offset] == '\\')
+			continue;
+		break;
+	}
+	return i;
+}
+
+size_t ShaderPreprocessor::skipBlank(size_t index, size_t end) const {
+	const ShaderTokenList &tokens = *mTokens;
+	while (index < end) {
+		const ShaderToken &token = tokens[index];
+		if (token.kind != ShaderToken::WHITESPACE && token.kind != ShaderToken::COMMENT &&
+			!(token.kind == ShaderToken::PUNCTUATION && mSource[token.offset] == '\\'))
+			break;
+		index++;
+	}
+	return index;
+}
+
+bool ShaderPreprocessor::handleDirective(size_t index) {
+	const ShaderTokenList &tokens = *mTokens;
+	size_t first = mDirectives[index].first;
+	size_t end = mDirectives[index].end;
+	size_t name = skipBlank(first + 1, end);
+	std::string_view directive;
+	if (name < end && tokens[name].kind == ShaderToken::IDENTIFIER)
+		directive = getText(name);
+	size_t args = (name < end) ? name + 1 : end;
+
+	bool elif = (directive == "elif");
+	if (directive == "if" || directive == "ifdef" || directive == "ifndef" || elif || directive == "else") {
+		bool opens = !elif && directive != "else";
+
+		// Conditionals inside of a dropped block are dropped with it.
+		if (mState == KNOWN_FALSE && (opens || mDroppedDepth > 0)) {
+			if (opens)
+				mDroppedDepth++;
+			return true;
+		}
+
+		if (!opens) {
+			if (mConditionals.empty())
+				return false;
+			if (mState == KNOWN_FALSE)
+				drop(mDropStart, index, false, mConditionals.back());
+		}
+
+		State condition = KNOWN_FALSE;
+		if (!opens && mConditionals.back().taken) {
+			// A branch before this one is always compiled.
+		} else if (directive == "else") {
+			condition = KNOWN_TRUE;
+		} else if (directive == "if" || elif) {
+			mSyntaxError = false;
+			size_t pos = args;
+			Value value = evaluateOr(pos, end);
+			if (skipBlank(pos, end) != end)
+				mSyntaxError = true;
+			if (mSyntaxError || !value.known)
+				condition = UNKNOWN;
+			else
+				condition = value.value ? KNOWN_TRUE : KNOWN_FALSE;
+		} else {
+			size_t macro = skipBlank(args, end);
+			if (macro == end || tokens[macro].kind != ShaderToken::IDENTIFIER)
+				return false;
+			condition = evaluateDefined(macro);
+			if (directive == "ifndef" && condition != UNKNOWN)
+				condition = (condition == KNOWN_TRUE) ? KNOWN_FALSE : KNOWN_TRUE;
+		}
+
+		if (opens)
+			mConditionals.push_back({ mState, false, false });
+		enterBranch(condition, index, name, elif);
+		return true;
+	}
+
+	if (directive == "endif") {
+		if (mState == KNOWN_FALSE && mDroppedDepth > 0) {
+			mDroppedDepth--;
+			return true;
+		}
+		if (mConditionals.empty())
+			return false;
+		if (mState == KNOWN_FALSE)
+			drop(mDropStart, index, false, mConditionals.back());
+
+		// The #endif is only needed if the driver still decides on a branch.
+		Conditional conditional = mConditionals.back();
+		mConditionals.pop_back();
+		if (!conditional.kept)
+			drop(index, index, true, conditional);
+		mState = conditional.parent;
+		return true;
+	}
+
+	if (mState == KNOWN_FALSE)
+		return true;
+
+	if (directive == "define" || directive == "undef") {
+		size_t macro = skipBlank(args, end);
+		if (macro < end && tokens[macro].kind == ShaderToken::IDENTIFIER) {
+			if (mState == UNKNOWN) {
+				// Whether this line is compiled is up to the driver.
+				setMacro(getText(macro), std::string_view(), UNKNOWN);
+			} else if (directive == "undef") {
+				setMacro(getText(macro), std::string_view(), KNOWN_FALSE);
+			} else {
+				// The value is the rest of the line. A function like macro's
+				// value starts with its parameters, so it never evaluates.
+				std::string_view value;
+				size_t valueStart = skipBlank(macro + 1, end);
+				if (macro + 1 < end && getText(macro + 1) == "(")
+					valueStart = macro + 1;
+				if (valueStart < end) {
+					size_t valueEnd = valueStart;
+					for (size_t i = valueStart; i < end; i++) {
+						if (skipBlank(i, i + 1) == i)
+							valueEnd = i;
+					}
+					size_t offset = tokens[valueStart].offset;
+					value = mSource.substr(offset, tokens[valueEnd].offset + tokens[valueEnd].length - offset);
+				}
+				setMacro(getText(macro), value, KNOWN_TRUE);
+			}
+		}
+	}
+
+	markReferenced(args, end);
+	return true;
+}
+
+void ShaderPreprocessor::enterBranch(State condition, size_t index, size_t name, bool elif) {
+	Conditional &conditional = mConditionals.back();
+	if (conditional.taken || condition == KNOWN_FALSE) {
+		// The branch is never compiled, drop it along with its directive.
+		mState = KNOWN_FALSE;
+		mDropStart = index;
+		mDroppedDepth = 0;
+		return;
+	}
+
+	if (condition == KNOWN_TRUE) {
+		conditional.taken = true;
+		if (conditional.kept) {
+			// A branch before this one is left to the driver, which makes
+			// this one the #else of that branch.
+			if (elif)
+				replace(name, mDirectives[index].end, "else");
+			mState = UNKNOWN;
+		} else {
+			drop(index, index, true, conditional);
+			mState = conditional.parent;
+		}
+		return;
+	}
+
+	// Leave the branch to the driver. If the branches before it were
+	// dropped, it now opens the conditional.
+	if (!conditional.kept && elif)
+		replace(name, name + 1, "if");
+	conditional.kept = true;
+	mState = UNKNOWN;
+	markReferenced(name + 1, mDirectives[index].end);
+}
+
+ShaderPreprocessor::Macro *ShaderPreprocessor::findMacro(std::string_view name) {
+	for (auto &macro : mMacros) {
+		if (macro.name == name)
+			return &macro;
+	}
+	return nullptr;
+}
+
+void ShaderPreprocessor::setMacro(std::string_view name, std::string_view value, State state) {
+	Macro *macro = findMacro(name);
+	if (macro) {
+		macro->value = value;
+		macro->state = state;
+	} else {
+		mMacros.push_back({ name, value, state, false, false });
+	}
+}
+
+void ShaderPreprocessor::markReferenced(size_t first, size_t end) {
+	for (size_t i = mNextReference; i < mReferences.size() && mReferences[i].token < end; i++) {
+		if (mReferences[i].token < first)
+			continue;
+
+		Macro *macro = findMacro(mReferences[i].name);
+		if (macro && macro->caller)
+			macro->referenced = true;
+	}
+}
+
+void ShaderPreprocessor::skipReferences(size_t end) {
+	while (mNextReference < mReferences.size() && mReferences[mNextReference].token < end)
+		mNextReference++;
+}
+
+void ShaderPreprocessor::drop(size_t from, size_t to, bool inclusive, const Conditional &conditional) {
+	const ShaderTokenList &tokens = *mTokens;
+	const Directive &start = mDirectives[from];
+	const Directive &stop = mDirectives[to];
+
+	// Once a branch of the conditional is kept, the dropped tokens end up in
+	// that branch, and otherwise they are only skipped with the code around
+	// the conditional.
+	Edit edit;
+	edit.token = start.first;
+	edit.drop = true;
+	edit.skippable = conditional.kept || conditional.parent == UNKNOWN;
+	edit.line = start.line;
+
+	size_t end;
+	if (inclusive) {
+		end = stop.end;
+		edit.endLine = stop.endLine;
+		edit.newline = true;
+	} else {
+		// Keep the line break in front of the directive that follows the
+		// dropped tokens, so that it stays on a line of its own.
+		end = stop.first;
+		edit.endLine = stop.line;
+		edit.newline = false;
+		if (end - 1 > edit.token && tokens[end - 1].kind == ShaderToken::WHITESPACE) {
+			uint32_t lines = countLines(mSource, tokens[end - 1]);
+			edit.endLine -= lines;
+			edit.newline = lines > 0;
+			end--;
+		}
+	}
+	edit.count = end - edit.token;
+
+	// Neighbouring dropped ranges become one edit, also when only the line
+	// break between two dropped directives separates them.
+	if (!mPending.empty()) {
+		Edit &last = mPending.back();
+		size_t lastEnd = last.token + last.count;
+		if (last.drop && lastEnd + 1 == edit.token && tokens[lastEnd].kind == ShaderToken::WHITESPACE)
+			lastEnd = edit.token;
+		if (last.drop && lastEnd == edit.token) {
+			last.count = end - last.token;
+			last.endLine = edit.endLine;
+			last.newline = edit.newline;
+			last.skippable = last.skippable || edit.skippable;
+			return;
+		}
+	}
+	mPending.push_back(edit);
+}
+
+void ShaderPreprocessor::replace(size_t first, size_t end, std::string_view text) {
+	Edit edit = Edit();
+	edit.token = first;
+	edit.count = end - first;
+	edit.text = text;
+	mPending.push_back(edit);
+}
+
+void ShaderPreprocessor::finish(std::string_view header, const ShaderDefineSet &defines, bool valid) {
+	mEdits.clear();
+	mText.clear();
+
+	// A malformed shader is left for the driver to report, so it keeps every
+	// caller define.
+	if (!valid) {
+		mPending.clear();
+		for (auto &macro : mMacros)
+			macro.referenced = macro.referenced || macro.caller;
+	}
+
+	// Reserve everything up front, the header and edits are views into mText.
+	size_t size = header.length() + sizeof("#line 0\n") + mPending.size() * SHADER_LINE_DIRECTIVE_SIZE;
+	for (const auto &edit : mPending) {
+		if (edit.drop && edit.skippable)
+			size += edit.endLine - edit.line;
+	}
+	for (const auto &define : defines.getDefines())
+		size += define.name.length() + define.value.length() + sizeof("#define  \n");
+	mText.reserve(size);
+
+	mText.append(header);
+	for (const auto &define : defines.getDefines()) {
+		const Macro *macro = findMacro(define.name);
+		if (!define.defined || !macro || !macro->referenced)
+			continue;
+		mText.append("#define ");
+		mText.append(define.name);
+		if (!define.value.empty()) {
+			mText.append(" ");
+			mText.append(define.value);
+		}
+		mText.append("\n");
+	}
+
+	// GLSL before 4.20 numbers the line after #line n as n + 1.
+	mText.append("#line 0\n");
+	mHeader = std::string_view(mText);
+
+	for (auto edit : mPending) {
+		// Dropped tokens on a single line leave an empty line behind, which
+		// keeps the numbering without a directive. Otherwise the directive
+		// needs a line of its own, which the source usually already has.
+		if (edit.drop && edit.endLine > edit.line && edit.skippable) {
+			size_t offset = mText.length();
+			mText.append(edit.endLine - edit.line, '\n');
+			edit.text = std::string_view(mText).substr(offset);
+		} else if (edit.drop && edit.endLine > edit.line) {
+			char directive[SHADER_LINE_DIRECTIVE_SIZE];
+			int length = edit.newline ?
+				snprintf(directive, sizeof(directive), "#line %u", edit.endLine) :
+				snprintf(directive, sizeof(directive), "#line %u\n", edit.endLine - 1);
+			size_t offset = mText.length();
+			mText.append(directive, length);
+			edit.text = std::string_view(mText).substr(offset, length);
+		}
+		mEdits.push_back({ edit.token, edit.count, edit.text });
+	}
+}
+
+ShaderPreprocessor::State ShaderPreprocessor::evaluateDefined(size_t name) {
+	const Macro *macro = findMacro(getText(name));
+	return macro ? macro->state : UNKNOWN;
+}
+
+bool ShaderPreprocessor::isOperator(size_t index, size_t end, const char *op) const {
+	index = skipBlank(index, end);
+	size_t length = strlen(op);
+	if (index + length > end)
+		return false;
+
+	// Operators are single character tokens with nothing in between.
+	for (size_t i = 0; i < length; i++) {
+		const ShaderToken &token = (*mTokens)[index + i];
+		if (token.kind != ShaderToken::PUNCTUATION || mSource[token.offset] != op[i])
+			return false;
+		if (i > 0 && token.offset != (*mTokens)[index + i - 1].offset + 1)
+			return false;
+	}
+	return true;
+}
+
+ShaderPreprocessor::Value ShaderPreprocessor::evaluateOr(size_t &index, size_t end) {
+	Value left = evaluateAnd(index, end);
+	while (isOperator(index, end, "||")) {
+		index = skipBlank(index, end) + 2;
+		Value right = evaluateAnd(index, end);
+
+		// One true side is enough, even if the other one is unknown.
+		if ((left.known && left.value) || (right.known && right.value))
+			left = { true, 1 };
+		else if (left.known && right.known)
+			left = { true, 0 };
+		else
+			left = { false, 0 };
+	}
+	return left;
+}
+
+ShaderPreprocessor::Value ShaderPreprocessor::evaluateAnd(size_t &index, size_t end) {
+	Value left = evaluateCompare(index, end);
+	while (isOperator(index, end, "&&")) {
+		index = skipBlank(index, end) + 2;
+		Value right = evaluateCompare(index, end);
+
+		// One false side is enough, even if the other one is unknown.
+		if ((left.known && !left.value) || (right.known && !right.value))
+			left = { true, 0 };
+		else if (left.known && right.known)
+			left = { true, 1 };
+		else
+			left = { false, 0 };
+	}
+	return left;
+}
+
+ShaderPreprocessor::Value ShaderPreprocessor::evaluateCompare(size_t &index, size_t end) {
+	static const char *const operators[] = { "==", "!=", "<=", ">=", "<", ">" };
+
+	Value left = evaluateUnary(index, end);
+	for (size_t op = 0; op < sizeof(operators) / sizeof(operators[0]); op++) {
+		if (!isOperator(index, end, operators[op]))
+			continue;
+
+		index = skipBlank(index, end) + strlen(operators[op]);
+		Value right = evaluateUnary(index, end);
+		if (!left.known || !right.known)
+			return { false, 0 };
+
+		bool result;
+		switch (op) {
+		case 0: result = left.value == right.value; break;
+		case 1: result = left.value != right.value; break;
+		case 2: result = left.value <= right.value; break;
+		case 3: result = left.value >= right.value; break;
+		case 4: result = left.value < right.value; break;
+		default: result = left.value > right.value; break;
+		}
+		return { true, result };
+	}
+	return left;
+}
+
+ShaderPreprocessor::Value ShaderPreprocessor::evaluateUnary(size_t &index, size_t end) {
+	const ShaderTokenList &tokens = *mTokens;
+	index = skipBlank(index, end);
+	if (index >= end) {
+		mSyntaxError = true;
+		return { false, 0 };
+	}
+
+	const ShaderToken &token = tokens[index];
+	std::string_view text = getText(index);
+	index++;
+
+	if (token.kind == ShaderToken::PUNCTUATION) {
+		if (text[0] == '!' || text[0] == '-') {
+			Value value = evaluateUnary(index, end);
+			if (value.known)
+				value.value = (text[0] == '!') ? !value.value : -value.value;
+			return value;
+		}
+		if (text[0] == '(') {
+			Value value = evaluateOr(index, end);
+			index = skipBlank(index, end);
+			if (index < end && getText(index) == ")")
+				index++;
+			else
+				mSyntaxError = true;
+			return value;
+		}
+		mSyntaxError = true;
+		return { false, 0 };
+	}
+
+	if (token.kind == ShaderToken::NUMBER) {
+		int64_t value;
+		if (parseInteger(text, value))
+			return { true, value };
+		return { false, 0 };
+	}
+
+	if (token.kind != ShaderToken::IDENTIFIER) {
+		mSyntaxError = true;
+		return { false, 0 };
+	}
+
+	if (text == "defined") {
+		// defined NAME or defined(NAME)
+		size_t name = skipBlank(index, end);
+		bool parens = name < end && getText(name) == "(";
+		if (parens)
+			name = skipBlank(name + 1, end);
+		if (name >= end || tokens[name].kind != ShaderToken::IDENTIFIER) {
+			mSyntaxError = true;
+			return { false, 0 };
+		}
+		index = name + 1;
+		if (parens) {
+			index = skipBlank(index, end);
+			if (index >= end || getText(index) != ")") {
+				mSyntaxError = true;
+				return { false, 0 };
+			}
+			index++;
+		}
+
+		State state = evaluateDefined(name);
+		if (state == UNKNOWN)
+			return { false, 0 };
+		return { true, state == KNOWN_TRUE };
+	}
+
+	// A macro only has a known value if it is defined to a plain integer.
+	const Macro *macro = findMacro(text);
+	int64_t value;
+	if (macro && macro->state == KNOWN_TRUE && parseInteger(macro->value, value))
+		return { true, value };
+	return { false, 0 };
+}
\ No newline at end of file
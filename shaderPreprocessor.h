@@ -0,0 +1,346 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderPreprocessor_h
+#define shaderPreprocessor_h
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "shaderTranslationContext.h"
+
+/**
+ * A macro that is known to be defined, with its value, or known not to be.
+ */
+struct ShaderDefine {
+	std::string name;
+	std::string value;
+	bool defined;
+};
+
+/**
+ * A set of macros the preprocessor knows about. The set is kept sorted by
+ * name so that the same defines always give the same hash, no matter in
+ * which order they were added.
+ */
+class ShaderDefineSet {
+public:
+	/**
+	 * Defines a macro, replacing an earlier define or undefine of it.
+	 * @param name The name of the macro.
+	 * @param value The value of the macro, which may be empty.
+	 */
+	void define(std::string_view name, std::string_view value = std::string_view());
+
+	/**
+	 * Marks a macro as known to be undefined, so that #ifdef blocks testing
+	 * it can be dropped.
+	 * @param name The name of the macro.
+	 */
+	void undefine(std::string_view name);
+
+	/**
+	 * Forgets every macro.
+	 */
+	void clear() {
+		mDefines.clear();
+	}
+
+	/**
+	 * Finds a macro.
+	 * @param name The name of the macro.
+	 * @return the macro, or null if nothing is known about it.
+	 */
+	const ShaderDefine *find(std::string_view name) const;
+
+	const std::vector<ShaderDefine> &getDefines() const {
+		return mDefines;
+	}
+
+	bool isEmpty() const {
+		return mDefines.empty();
+	}
+
+	/**
+	 * Get's a hash of every macro, for telling translator configurations apart.
+	 * @return the hash of the set.
+	 */
+	uint64_t getHash() const;
+
+private:
+	void set(std::string_view name, std::string_view value, bool defined);
+
+	/**
+	 * The macros, sorted by name.
+	 */
+	std::vector<ShaderDefine> mDefines;
+};
+
+/**
+ * Resolves the #ifdef, #ifndef, #if, #elif, #else and #endif blocks of a
+ * tokenized shader as far as the known macros allow, so that branches that
+ * can never be compiled are dropped before the shader reaches the driver.
+ *
+ * Conditions are evaluated to true, false or unknown. Only macros the
+ * preprocessor knows about (from the backend, the caller, or #define and
+ * #undef lines earlier in the shader) are resolved; a condition that depends
+ * on anything else is kept in the output for the driver to decide, together
+ * with its #endif. Every dropped block that spans lines is replaced with a
+ * #line directive, so line numbers in driver errors still match the source.
+ * Inside of the conditionals that are kept the driver may skip that
+ * directive, so there the block is replaced with its line breaks instead.
+ *
+ * The preprocessor only decides on edits to the token list, it does not
+ * change the source. The translator applies the edits while it rewrites
+ * tokens. Work is split in a scan, which walks the tokens once, and a
+ * resolve, which only looks at the directives the scan found. A shader can
+ * be resolved against many sets of macros after a single scan.
+ */
+class ShaderPreprocessor {
+public:
+	/**
+	 * Scans and resolves a tokenized shader in one go.
+	 * @param source The shader source.
+	 * @param tokens The tokens of the source.
+	 * @param header The header of the language the shader is translated to.
+	 * @param builtins The macros defined by the language.
+	 * @param defines The macros defined by the caller. These take precedence
+	 *  over the builtins.
+	 * @return false if the conditionals of the shader are malformed, in which
+	 *  case the shader is left as it is.
+	 */
+	bool run(std::string_view source, const ShaderTokenList &tokens, std::string_view header, const ShaderDefineSet &builtins, const ShaderDefineSet &defines);
+
+	/**
+	 * Finds the directives of a tokenized shader, and every use of the macros
+	 * that may later be given to resolve() as caller defines.
+	 * @param source The shader source. It must stay alive while resolving.
+	 * @param tokens The tokens of the source.
+	 * @param names The caller macros whose uses are tracked.
+	 */
+	void scan(std::string_view source, const ShaderTokenList &tokens, const ShaderDefineSet &names);
+
+	/**
+	 * Works out the edits for the last scanned shader. Only the directives
+	 * are looked at, so this costs nothing for code between them.
+	 * @param header The header of the language the shader is translated to.
+	 * @param builtins The macros defined by the language.
+	 * @param defines The macros defined by the caller. Only the ones given to
+	 *  scan() are written to the header.
+	 * @return false if the conditionals of the shader are malformed, in which
+	 *  case the shader is left as it is.
+	 */
+	bool resolve(std::string_view header, const ShaderDefineSet &builtins, const ShaderDefineSet &defines);
+
+	/**
+	 * Get's the edits of the last resolve, in token order. Each edit replaces
+	 * a range of tokens with a text.
+	 * @return the list of edits.
+	 */
+	const ShaderReplacementList &getEdits() const {
+		return mEdits;
+	}
+
+	/**
+	 * Get's the header to emit in front of the shader: the language header,
+	 * the caller defines the shader still uses, and a #line directive that
+	 * makes the first line of the source line 1 again.
+	 * @return the header text, valid until the next resolve.
+	 */
+	std::string_view getHeader() const {
+		return mHeader;
+	}
+
+private:
+	/**
+	 * What is known about the code in a block or about a macro.
+	 */
+	enum State : uint8_t {
+		// The code is always compiled, or the macro is known to be defined.
+		KNOWN_TRUE,
+		// The code is never compiled, or the macro is known to be undefined.
+		KNOWN_FALSE,
+		// Depends on something only the driver knows.
+		UNKNOWN
+	};
+
+	/**
+	 * A directive line found by the scan.
+	 */
+	struct Directive {
+		// The # token and the token after the last one of the directive.
+		size_t first;
+		size_t end;
+
+		// The line of the # and the line the directive ends on.
+		uint32_t line;
+		uint32_t endLine;
+	};
+
+	/**
+	 * A use of a caller macro found by the scan.
+	 */
+	struct Reference {
+		size_t token;
+		std::string_view name;
+	};
+
+	struct Macro {
+		std::string_view name;
+		std::string_view value;
+		State state;
+
+		/**
+		 * Set if the macro was defined by the caller, which means it has to
+		 * be defined in the output if the shader still uses it.
+		 */
+		bool caller;
+		bool referenced;
+	};
+
+	struct Conditional {
+		/**
+		 * The state of the code around the conditional.
+		 */
+		State parent;
+
+		/**
+		 * Set once a branch is known to be taken. Every later branch is dropped.
+		 */
+		bool taken;
+
+		/**
+		 * Set once a branch is kept for the driver to decide, which means the
+		 * directives of the conditional have to be kept too.
+		 */
+		bool kept;
+	};
+
+	/**
+	 * The result of evaluating an #if expression.
+	 */
+	struct Value {
+		bool known;
+		int64_t value;
+	};
+
+	/**
+	 * An edit that is not turned into text yet.
+	 */
+	struct Edit {
+		size_t token;
+		size_t count;
+		std::string_view text;
+
+		// Set for dropped tokens, which get a #line directive when they span lines.
+		// In a branch the driver decides on they get their line breaks instead.
+		bool drop;
+
+		// Set if a line break follows the dropped tokens.
+		bool newline;
+
+		// Set if the dropped tokens are in a branch the driver decides on.
+		bool skippable;
+
+		uint32_t line;
+		uint32_t endLine;
+	};
+
+	size_t findDirectiveEnd(size_t first) const;
+	size_t skipBlank(size_t index, size_t end) const;
+	bool handleDirective(size_t directive);
+	void enterBranch(State condition, size_t directive, size_t name, bool elif);
+	void setMacro(std::string_view name, std::string_view value, State state);
+	Macro *findMacro(std::string_view name);
+	void markReferenced(size_t first, size_t end);
+	void skipReferences(size_t end);
+	void drop(size_t from, size_t to, bool inclusive, const Conditional &conditional);
+	void replace(size_t first, size_t end, std::string_view text);
+	void finish(std::string_view header, const ShaderDefineSet &defines, bool valid);
+
+	State evaluateDefined(size_t name);
+	Value evaluateOr(size_t &index, size_t end);
+	Value evaluateAnd(size_t &index, size_t end);
+	Value evaluateCompare(size_t &index, size_t end);
+	Value evaluateUnary(size_t &index, size_t end);
+	bool isOperator(size_t index, size_t end, const char *op) const;
+
+	std::string_view getText(size_t token) const {
+		return mSource.substr((*mTokens)[token].offset, (*mTokens)[token].length);
+	}
+
+	std::string_view mSource;
+	const ShaderTokenList *mTokens = nullptr;
+
+	/**
+	 * The directives and macro uses of the last scanned shader.
+	 */
+	std::vector<Directive> mDirectives;
+	std::vector<Reference> mReferences;
+
+	/**
+	 * The first macro use that has not been looked at by resolve().
+	 */
+	size_t mNextReference = 0;
+
+	/**
+	 * The state of the code at the current directive.
+	 */
+	State mState = KNOWN_TRUE;
+
+	/**
+	 * The number of conditionals nested inside of a dropped block.
+	 */
+	size_t mDroppedDepth = 0;
+
+	/**
+	 * The directive that starts the block that is being dropped.
+	 */
+	size_t mDropStart = 0;
+
+	/**
+	 * Set when an #if expression could not be parsed.
+	 */
+	bool mSyntaxError = false;
+
+	std::vector<Macro> mMacros;
+	std::vector<Conditional> mConditionals;
+	std::vector<Edit> mPending;
+	ShaderReplacementList mEdits;
+
+	/**
+	 * Holds the text of the header and of the #line directives.
+	 */
+	std::string mText;
+	std::string_view mHeader;
+};
+
+#endif /* shaderPreprocessor_h */
\ No newline at end of file
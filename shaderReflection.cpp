@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <charconv>
+#include "shaderReflection.h"
+
+/**
+ * The words storages and stages are written as, in enum order.
+ */
+static const std::string_view STORAGE_NAMES[] = { "attribute", "varying", "uniform", "out" };
+static const std::string_view STAGE_NAMES[] = { "vertex", "fragment" };
+
+/**
+ * What the lines of a reflection start with.
+ */
+static const std::string_view REFLECTION_PREFIX = "// reflection ";
+static const std::string_view VARIABLE_PREFIX = "// ";
+
+/**
+ * Reads an integer the way GLSL writes it, in decimal, octal or hex with an
+ * optional unsigned suffix.
+ */
+static bool parseInteger(std::string_view text, int32_t &value) {
+	int base = 10;
+	if (text.length() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+		base = 16;
+		text.remove_prefix(2);
+	} else if (text.length() > 1 && text[0] == '0') {
+		base = 8;
+	}
+	if (!text.empty() && (text.back() == 'u' || text.back() == 'U'))
+		text.remove_suffix(1);
+
+	auto result = std::from_chars(text.data(), text.data() + text.length(), value, base);
+	return result.ec == std::errc() && result.ptr == text.data() + text.length();
+}
+
+/**
+ * Splits the next space separated field off of a line.
+ */
+static std::string_view nextField(std::string_view &line) {
+	size_t end = line.find(' ');
+	std::string_view field = line.substr(0, end);
+	line.remove_prefix((end == std::string_view::npos) ? line.length() : end + 1);
+	return field;
+}
+
+uint32_t ShaderReflectionVariable::getLocationCount() const {
+	// Matrices take one location per column, and matNxM has N columns.
+	uint32_t count = 1;
+	if (type.length() >= 4 && type.compare(0, 3, "mat") == 0 && type[3] >= '2' && type[3] <= '4')
+		count = type[3] - '0';
+	return (arraySize > 0) ? count * arraySize : count;
+}
+
+ShaderReflection::ShaderReflection() :
+	mStage(ShaderTranslator::VERTEX),
+	mCount(0) {
+}
+
+void ShaderReflection::clear(ShaderTranslator::ShaderType stage) {
+	mStage = stage;
+	mCount = 0;
+}
+
+ShaderReflectionVariable &ShaderReflection::add(ShaderReflectionVariable::Storage storage, std::string_view type, std::string_view name, int32_t arraySize, int32_t location) {
+	if (mCount == mVariables.size())
+		mVariables.emplace_back();
+
+	ShaderReflectionVariable &variable = mVariables[mCount++];
+	variable.storage = storage;
+	variable.type.assign(type);
+	variable.name.assign(name);
+	variable.arraySize = arraySize;
+	variable.location = location;
+	return variable;
+}
+
+size_t ShaderReflection::skipSpace(const ShaderTranslationContext &context, size_t index) const {
+	const ShaderTokenList &tokens = context.getTokens();
+	while (index < tokens.size() && (tokens[index].kind == ShaderToken::WHITESPACE || tokens[index].kind == ShaderToken::COMMENT))
+		index++;
+	return index;
+}
+
+size_t ShaderReflection::readDeclaration(const ShaderTranslationContext &context, size_t index) {
+	const ShaderTokenList &tokens = context.getTokens();
+	std::string_view qualifier = context.getTokenText(tokens[index]);
+	ShaderReflectionVariable::Storage storage;
+	if (qualifier == "attribute")
+		storage = ShaderReflectionVariable::ATTRIBUTE;
+	else if (qualifier == "varying")
+		storage = ShaderReflectionVariable::VARYING;
+	else if (qualifier == "uniform")
+		storage = ShaderReflectionVariable::UNIFORM;
+	else
+		return 0;
+
+	auto isPunctuation = [&](size_t i, char c) {
+		return i < tokens.size() && tokens[i].kind == ShaderToken::PUNCTUATION && context.getSource()[tokens[i].offset] == c;
+	};
+	auto isIdentifier = [&](size_t i) {
+		return i < tokens.size() && tokens[i].kind == ShaderToken::IDENTIFIER;
+	};
+
+	// Precision qualifiers sit between the storage qualifier and the type.
+	size_t i = skipSpace(context, index + 1);
+	while (isIdentifier(i)) {
+		std::string_view text = context.getTokenText(tokens[i]);
+		if (text != "lowp" && text != "mediump" && text != "highp")
+			break;
+		i = skipSpace(context, i + 1);
+	}
+	if (!isIdentifier(i))
+		return 0;
+
+	std::string_view type = context.getTokenText(tokens[i]);
+	i = skipSpace(context, i + 1);
+	if (type == "struct") {
+		// A struct declared in place, as in uniform struct Light { ... } light;
+		if (isIdentifier(i)) {
+			type = context.getTokenText(tokens[i]);
+			i = skipSpace(context, i + 1);
+		}
+		if (isPunctuation(i, '{')) {
+			while (i < tokens.size() && !isPunctuation(i, '}'))
+				i++;
+			i = skipSpace(context, i + 1);
+		}
+	}
+
+	size_t count = 0;
+	while (isIdentifier(i)) {
+		std::string_view name = context.getTokenText(tokens[i]);
+		i = skipSpace(context, i + 1);
+
+		int32_t arraySize = 0;
+		if (isPunctuation(i, '[')) {
+			arraySize = -1;
+			size_t size = skipSpace(context, i + 1);
+			if (size < tokens.size() && tokens[size].kind == ShaderToken::NUMBER && isPunctuation(skipSpace(context, size + 1), ']')) {
+				if (!parseInteger(context.getTokenText(tokens[size]), arraySize) || arraySize <= 0)
+					arraySize = -1;
+			}
+			while (i < tokens.size() && !isPunctuation(i, ']') && !isPunctuation(i, ';'))
+				i++;
+			if (isPunctuation(i, ']'))
+				i = skipSpace(context, i + 1);
+		}
+		add(storage, type, name, arraySize);
+		count++;
+
+		// Skip the initializer of a uniform, whose calls have commas of their own.
+		size_t depth = 0;
+		while (i < tokens.size() && !isPunctuation(i, ';') && !isPunctuation(i, '{') && !(depth == 0 && isPunctuation(i, ','))) {
+			if (isPunctuation(i, '('))
+				depth++;
+			else if (isPunctuation(i, ')') && depth)
+				depth--;
+			i++;
+		}
+		if (!isPunctuation(i, ','))
+			break;
+		i = skipSpace(context, i + 1);
+	}
+	return count;
+}
+
+void ShaderReflection::write(std::string &shader) const {
+	if (!shader.empty() && shader.back() != '\n')
+		shader.push_back('\n');
+
+	char number[16];
+	shader += REFLECTION_PREFIX;
+	shader += STAGE_NAMES[mStage];
+	shader += ' ';
+	shader.append(number, std::to_chars(number, number + sizeof(number), mCount).ptr);
+	shader += '\n';
+	for (size_t i = 0; i < mCount; i++) {
+		const ShaderReflectionVariable &variable = mVariables[i];
+		shader += VARIABLE_PREFIX;
+		shader += getStorageName(variable.storage);
+		shader += ' ';
+		shader += variable.type;
+		shader += ' ';
+		shader += variable.name;
+		shader += ' ';
+		shader.append(number, std::to_chars(number, number + sizeof(number), variable.arraySize).ptr);
+		shader += ' ';
+		shader.append(number, std::to_chars(number, number + sizeof(number), variable.location).ptr);
+		shader += '\n';
+	}
+}
+
+bool ShaderReflection::read(std::string_view shader) {
+	clear(ShaderTranslator::VERTEX);
+
+	// The reflection is the last thing in the shader, so its first line is
+	// the last one that starts with the prefix.
+	size_t start = shader.length();
+	do {
+		start = shader.rfind(REFLECTION_PREFIX, start == 0 ? 0 : start - 1);
+	} while (start != std::string_view::npos && start != 0 && shader[start - 1] != '\n');
+	if (start == std::string_view::npos)
+		return false;
+
+	std::string_view rest = shader.substr(start);
+	auto nextLine = [&rest]() {
+		size_t end = rest.find('\n');
+		std::string_view line = rest.substr(0, end);
+		rest.remove_prefix((end == std::string_view::npos) ? rest.length() : end + 1);
+		return line;
+	};
+
+	std::string_view line = nextLine().substr(REFLECTION_PREFIX.length());
+	std::string_view stage = nextField(line);
+	int32_t count;
+	if (stage == STAGE_NAMES[ShaderTranslator::VERTEX])
+		mStage = ShaderTranslator::VERTEX;
+	else if (stage == STAGE_NAMES[ShaderTranslator::FRAGMENT])
+		mStage = ShaderTranslator::FRAGMENT;
+	else
+		return false;
+	if (!parseInteger(nextField(line), count) || count < 0 || !line.empty())
+		return false;
+
+	for (int32_t i = 0; i < count; i++) {
+		line = nextLine();
+		if (line.compare(0, VARIABLE_PREFIX.length(), VARIABLE_PREFIX) != 0) {
+			clear(mStage);
+			return false;
+		}
+		line.remove_prefix(VARIABLE_PREFIX.length());
+
+		std::string_view storageName = nextField(line);
+		size_t storage = 0;
+		while (storage < ShaderReflectionVariable::OUTPUT && STORAGE_NAMES[storage] != storageName)
+			storage++;
+		std::string_view type = nextField(line);
+		std::string_view name = nextField(line);
+		int32_t arraySize;
+		int32_t location;
+		if (STORAGE_NAMES[storage] != storageName || type.empty() || name.empty() ||
+			!parseInteger(nextField(line), arraySize) || !parseInteger(nextField(line), location) || !line.empty()) {
+			clear(mStage);
+			return false;
+		}
+		add(static_cast<ShaderReflectionVariable::Storage>(storage), type, name, arraySize, location);
+	}
+
+	// Nothing else may follow, or this was not the shader's own reflection.
+	if (!rest.empty()) {
+		clear(mStage);
+		return false;
+	}
+	return true;
+}
+
+const ShaderReflectionVariable *ShaderReflection::find(std::string_view name) const {
+	for (size_t i = 0; i < mCount; i++) {
+		if (mVariables[i].name == name)
+			return &mVariables[i];
+	}
+	return nullptr;
+}
+
+ShaderReflectionVariable *ShaderReflection::find(std::string_view name) {
+	for (size_t i = 0; i < mCount; i++) {
+		if (mVariables[i].name == name)
+			return &mVariables[i];
+	}
+	return nullptr;
+}
+
+std::string_view ShaderReflection::getStorageName(ShaderReflectionVariable::Storage storage) {
+	return STORAGE_NAMES[storage];
+}
\ No newline at end of file
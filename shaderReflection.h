@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderReflection_h
+#define shaderReflection_h
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "shaderTranslator.h"
+
+/**
+ * A variable of a shader's interface with the application: a vertex
+ * attribute, a varying, a uniform or a fragment output.
+ */
+struct ShaderReflectionVariable {
+	/**
+	 * How the variable is declared.
+	 */
+	enum Storage : uint8_t {
+		ATTRIBUTE,
+		VARYING,
+		UNIFORM,
+		OUTPUT
+	};
+
+	Storage storage;
+
+	/**
+	 * The name of the type, such as vec4, sampler2D or the name of a struct.
+	 */
+	std::string type;
+	std::string name;
+
+	/**
+	 * The number of elements, 0 if the variable is not an array, or -1 if
+	 * the size is not a plain number, such as a macro.
+	 */
+	int32_t arraySize;
+
+	/**
+	 * The location the translator placed the variable at, or -1 if it is
+	 * left to the linker.
+	 */
+	int32_t location;
+
+	/**
+	 * Get's the number of locations the variable takes up, which is one per
+	 * matrix column and array element.
+	 * @return the number of locations.
+	 */
+	uint32_t getLocationCount() const;
+};
+
+/**
+ * The interface of a translated shader: the attributes, varyings and
+ * uniforms it declares and the outputs the backend adds to it, so that an
+ * engine can bind them without querying the linked program. The translator
+ * fills one in while it rewrites the tokens when reflection is on, see
+ * ShaderTranslator::setReflection().
+ *
+ * A reflection is written to the end of the translated shader as comments,
+ * which is what lets it be cached along with the shader by any cache that
+ * stores the translated source. read() takes it back out:
+ *
+ * // reflection vertex 2
+ * // attribute vec3 position 0 0
+ * // uniform vec4 lights 4 -1
+ *
+ * The first line has the stage and the number of variables, and every
+ * variable has the storage, type, name, array size and location.
+ */
+class ShaderReflection {
+public:
+	ShaderReflection();
+
+	/**
+	 * Forgets the variables of the last shader, keeping their memory.
+	 * @param stage The type of shader that is reflected next.
+	 */
+	void clear(ShaderTranslator::ShaderType stage);
+
+	/**
+	 * Adds a variable.
+	 * @param storage How the variable is declared.
+	 * @param type The name of the type.
+	 * @param name The name of the variable.
+	 * @param arraySize The number of elements, 0 or -1, see ShaderReflectionVariable.
+	 * @param location The location of the variable, or -1.
+	 * @return the variable.
+	 */
+	ShaderReflectionVariable &add(ShaderReflectionVariable::Storage storage, std::string_view type, std::string_view name, int32_t arraySize = 0, int32_t location = -1);
+
+	/**
+	 * Reads the declaration that starts at a token, if the token is one of
+	 * the attribute, varying or uniform qualifiers. Every variable of the
+	 * declaration is added.
+	 * @param context The context that holds the tokens.
+	 * @param index The token of the qualifier.
+	 * @return the number of variables added.
+	 */
+	size_t readDeclaration(const ShaderTranslationContext &context, size_t index);
+
+	/**
+	 * Writes the reflection to the end of a shader as comments.
+	 * @param shader The translated shader.
+	 */
+	void write(std::string &shader) const;
+
+	/**
+	 * Reads the reflection back from the end of a shader that write() was
+	 * used on, for example one that came out of a cache.
+	 * @param shader The translated shader.
+	 * @return true if the shader ends with a reflection.
+	 */
+	bool read(std::string_view shader);
+
+	/**
+	 * Get's the type of shader that was reflected.
+	 * @return the stage of the variables.
+	 */
+	ShaderTranslator::ShaderType getStage() const {
+		return mStage;
+	}
+
+	size_t getVariableCount() const {
+		return mCount;
+	}
+
+	const ShaderReflectionVariable *getVariables() const {
+		return mVariables.data();
+	}
+
+	ShaderReflectionVariable &getVariable(size_t index) {
+		return mVariables[index];
+	}
+
+	const ShaderReflectionVariable &getVariable(size_t index) const {
+		return mVariables[index];
+	}
+
+	/**
+	 * Finds a variable by name.
+	 * @param name The name of the variable.
+	 * @return the variable, or null if the shader does not declare it.
+	 */
+	const ShaderReflectionVariable *find(std::string_view name) const;
+	ShaderReflectionVariable *find(std::string_view name);
+
+	/**
+	 * Get's the word a storage is written as, which is how it is declared
+	 * in GLSL 120, or out for outputs.
+	 * @param storage The storage.
+	 * @return the name of the storage.
+	 */
+	static std::string_view getStorageName(ShaderReflectionVariable::Storage storage);
+
+private:
+	/**
+	 * Skips whitespace and comments.
+	 * @return the index of the next token that is neither, or the token count.
+	 */
+	size_t skipSpace(const ShaderTranslationContext &context, size_t index) const;
+
+	ShaderTranslator::ShaderType mStage;
+
+	/**
+	 * The variables. Only the first mCount are in use, the rest are kept
+	 * so that their strings do not have to be allocated again.
+	 */
+	std::vector<ShaderReflectionVariable> mVariables;
+	size_t mCount;
+};
+
+#endif /* shaderReflection_h */
\ No newline at end of file
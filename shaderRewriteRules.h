@@ -0,0 +1,268 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderRewriteRules_h
+#define shaderRewriteRules_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * The name of the output variable that replaces gl_FragColor in GLSL 330.
+ */
+#define SHADER_GL33_FRAG_OUTPUT "GEN_OUTPUT_FINAL_COLOR"
+
+/**
+ * The text every translated shader starts with, per backend and shader type.
+ * GL33 fragment shaders with explicit locations place the output at 0.
+ */
+constexpr std::string_view SHADER_GL21_HEADER = "#version 120\n#define GL21\n\n";
+constexpr std::string_view SHADER_GL33_VERTEX_HEADER = "#version 330 core\n#define GL33\n\n";
+constexpr std::string_view SHADER_GL33_FRAGMENT_HEADER = "#version 330 core\n#define GL33\n\nout vec4 " SHADER_GL33_FRAG_OUTPUT ";\n\n";
+constexpr std::string_view SHADER_GL33_FRAGMENT_LOCATION_HEADER = "#version 330 core\n#define GL33\n\nlayout(location = 0) out vec4 " SHADER_GL33_FRAG_OUTPUT ";\n\n";
+
+/**
+ * The number of hash slots in a rewrite table. It has to be a power of two
+ * and should be at least twice the number of rules in the biggest table.
+ */
+#define SHADER_REWRITE_SLOTS 128
+
+/**
+ * A single rewrite rule: an identifier and what it is replaced with.
+ */
+struct ShaderRewriteRule {
+	/**
+	 * What a rule rewrites, so that rewrites can be counted by kind no
+	 * matter which table they came from.
+	 */
+	enum Kind : uint8_t {
+		ATTRIBUTE,
+		VARYING,
+		TEXTURE,
+		FRAG_COLOR
+	};
+
+	std::string_view keyword;
+	std::string_view replacement;
+
+	/**
+	 * Set if the identifier is only rewritten when it is called as a function,
+	 * meaning the next token is '('.
+	 */
+	bool requiresCall;
+
+	Kind kind;
+};
+
+/**
+ * A table of rewrite rules for one backend and shader type. The table is
+ * built at compile time together with a perfect hash over its keywords, so
+ * looking up a token costs one hash, one probe and one string compare, no
+ * matter how many rules the table has.
+ */
+class ShaderRewriteTable {
+public:
+	/**
+	 * Builds the table, searching for a hash seed that puts every keyword in
+	 * its own slot.
+	 * @param rules The rules. They must have static storage duration.
+	 */
+	template <size_t N>
+	constexpr ShaderRewriteTable(const ShaderRewriteRule (&rules)[N]) :
+		mRules(rules),
+		mCount(N),
+		mSeed(0),
+		mMinLength(SIZE_MAX),
+		mMaxLength(0),
+		mSlots() {
+		static_assert(N * 2 <= SHADER_REWRITE_SLOTS, "Too many rewrite rules for SHADER_REWRITE_SLOTS.");
+		for (size_t i = 0; i < N; i++) {
+			if (rules[i].keyword.length() < mMinLength)
+				mMinLength = rules[i].keyword.length();
+			if (rules[i].keyword.length() > mMaxLength)
+				mMaxLength = rules[i].keyword.length();
+		}
+
+		for (uint32_t seed = 1; ; seed++) {
+			if (tryBuild(seed)) {
+				mSeed = seed;
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Creates an empty table, for languages that do not rewrite anything.
+	 */
+	constexpr ShaderRewriteTable() :
+		mRules(nullptr),
+		mCount(0),
+		mSeed(0),
+		mMinLength(SIZE_MAX),
+		mMaxLength(0),
+		mSlots() {
+	}
+
+	/**
+	 * Finds the rule for an identifier.
+	 * @param token The text of the identifier.
+	 * @return the rule, or null if there is no rule for the identifier.
+	 */
+	constexpr const ShaderRewriteRule *find(std::string_view token) const {
+		if (token.length() < mMinLength || token.length() > mMaxLength)
+			return nullptr;
+
+		uint8_t slot = mSlots[hash(token, mSeed) & (SHADER_REWRITE_SLOTS - 1)];
+		if (slot == 0 || mRules[slot - 1].keyword != token)
+			return nullptr;
+		return &mRules[slot - 1];
+	}
+
+	/**
+	 * Decides how an identifier is rewritten.
+	 * @param token The text of the identifier.
+	 * @param next The first character of the token that follows, or 0.
+	 * @return the replacement text, or an empty view if the token is kept.
+	 */
+	constexpr std::string_view rewrite(std::string_view token, char next) const {
+		const ShaderRewriteRule *rule = match(token, next);
+		return rule ? rule->replacement : std::string_view();
+	}
+
+	/**
+	 * Finds the rule that rewrites an identifier in this position.
+	 * @param token The text of the identifier.
+	 * @param next The first character of the token that follows, or 0.
+	 * @return the rule, or null if the token is kept.
+	 */
+	constexpr const ShaderRewriteRule *match(std::string_view token, char next) const {
+		const ShaderRewriteRule *rule = find(token);
+		if (!rule || (rule->requiresCall && next != '('))
+			return nullptr;
+		return rule;
+	}
+
+	constexpr size_t getRuleCount() const {
+		return mCount;
+	}
+
+	constexpr const ShaderRewriteRule &getRule(size_t index) const {
+		return mRules[index];
+	}
+
+	/**
+	 * The seeded FNV-1a hash used to place keywords in slots.
+	 */
+	static constexpr uint32_t hash(std::string_view token, uint32_t seed) {
+		uint32_t h = 2166136261u ^ seed;
+		for (char c : token) {
+			h ^= static_cast<uint8_t>(c);
+			h *= 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+
+private:
+	constexpr bool tryBuild(uint32_t seed) {
+		for (size_t i = 0; i < SHADER_REWRITE_SLOTS; i++)
+			mSlots[i] = 0;
+		for (size_t i = 0; i < mCount; i++) {
+			uint32_t slot = hash(mRules[i].keyword, seed) & (SHADER_REWRITE_SLOTS - 1);
+			if (mSlots[slot] != 0)
+				return false;
+			mSlots[slot] = static_cast<uint8_t>(i + 1);
+		}
+		return true;
+	}
+
+	const ShaderRewriteRule *mRules;
+	size_t mCount;
+	uint32_t mSeed;
+	size_t mMinLength;
+	size_t mMaxLength;
+
+	/**
+	 * The rule index + 1 of every slot, 0 for an empty slot.
+	 */
+	uint8_t mSlots[SHADER_REWRITE_SLOTS];
+};
+
+// The texture lookup functions of GLSL 120. GLSL 330 overloads them by
+// sampler type, so only the projection and lod variants keep their own name.
+#define SHADER_GL33_TEXTURE_RULES \
+	{ "texture1D",         "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture2D",         "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture3D",         "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "textureCube",       "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow1D",          "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow2D",          "texture",        true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture1DProj",     "textureProj",    true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture2DProj",     "textureProj",    true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture3DProj",     "textureProj",    true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow1DProj",      "textureProj",    true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow2DProj",      "textureProj",    true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture1DLod",      "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture2DLod",      "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture3DLod",      "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "textureCubeLod",    "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow1DLod",       "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow2DLod",       "textureLod",     true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture1DProjLod",  "textureProjLod", true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture2DProjLod",  "textureProjLod", true, ShaderRewriteRule::TEXTURE }, \
+	{ "texture3DProjLod",  "textureProjLod", true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow1DProjLod",   "textureProjLod", true, ShaderRewriteRule::TEXTURE }, \
+	{ "shadow2DProjLod",   "textureProjLod", true, ShaderRewriteRule::TEXTURE }
+
+inline constexpr ShaderRewriteRule SHADER_GL33_VERTEX_RULES[] = {
+	// In GLSL core profile, attribute is changed to the in keyword.
+	{ "attribute", "in", false, ShaderRewriteRule::ATTRIBUTE },
+
+	// In vertex shaders, varying turns to out.
+	{ "varying", "out", false, ShaderRewriteRule::VARYING },
+
+	SHADER_GL33_TEXTURE_RULES
+};
+
+inline constexpr ShaderRewriteRule SHADER_GL33_FRAGMENT_RULES[] = {
+	// In fragment shaders, varying turns to in.
+	{ "varying", "in", false, ShaderRewriteRule::VARYING },
+
+	// The built in color output is replaced by a declared output variable.
+	{ "gl_FragColor", SHADER_GL33_FRAG_OUTPUT, false, ShaderRewriteRule::FRAG_COLOR },
+
+	SHADER_GL33_TEXTURE_RULES
+};
+
+inline constexpr ShaderRewriteTable SHADER_EMPTY_REWRITE_TABLE;
+inline constexpr ShaderRewriteTable SHADER_GL33_VERTEX_TABLE(SHADER_GL33_VERTEX_RULES);
+inline constexpr ShaderRewriteTable SHADER_GL33_FRAGMENT_TABLE(SHADER_GL33_FRAGMENT_RULES);
+
+#endif /* shaderRewriteRules_h */
\ No newline at end of file
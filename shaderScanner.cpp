@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SHADER_SCANNER_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define SHADER_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SHADER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SHADER_TARGET_AVX2
+#endif
+
+static size_t findWordEndScalar(const char *str, size_t pos, size_t len) {
+	while (pos < len && SHADER_CHAR_TABLE.is(str[pos], SHADER_CHAR_WORD))
+		pos++;
+	return pos;
+}
+
+static size_t findSpaceEndScalar(const char *str, size_t pos, size_t len) {
+	while (pos < len && SHADER_CHAR_TABLE.is(str[pos], SHADER_CHAR_SPACE))
+		pos++;
+	return pos;
+}
+
+#ifdef SHADER_SCANNER_SSE2
+
+static inline unsigned countTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+/**
+ * Sets each byte of the result if lo <= x <= hi, comparing unsigned.
+ */
+static inline __m128i inRange16(__m128i x, char lo, char hi) {
+	__m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), offset);
+}
+
+static inline uint32_t wordMask16(__m128i x) {
+	__m128i letter = inRange16(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+	__m128i digit = inRange16(x, '0', '9');
+	__m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)));
+}
+
+static inline uint32_t spaceMask16(__m128i x) {
+	__m128i space = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+	__m128i control = inRange16(x, '\t', '\r');
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(space, control)));
+}
+
+static size_t findWordEndSSE2(const char *str, size_t pos, size_t len) {
+	while (pos + 16 <= len) {
+		uint32_t mask = ~wordMask16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(str + pos))) & 0xFFFF;
+		if (mask != 0)
+			return pos + countTrailingZeros(mask);
+		pos += 16;
+	}
+	return findWordEndScalar(str, pos, len);
+}
+
+static size_t findSpaceEndSSE2(const char *str, size_t pos, size_t len) {
+	while (pos + 16 <= len) {
+		uint32_t mask = ~spaceMask16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(str + pos))) & 0xFFFF;
+		if (mask != 0)
+			return pos + countTrailingZeros(mask);
+		pos += 16;
+	}
+	return findSpaceEndScalar(str, pos, len);
+}
+
+#endif
+
+#ifdef SHADER_SCANNER_AVX2
+
+// The AVX2 scanner classifies bytes with two 16 entry tables, one indexed by
+// the low nibble and one by the high nibble. A byte belongs to a class when
+// the AND of both lookups is non zero. Each bit covers one rectangle of the
+// ASCII table:
+//   0x01 digits      high 3       low 0-9
+//   0x02 letters     high 4 and 6 low 1-15
+//   0x04 letters     high 5 and 7 low 0-10
+//   0x08 underscore  high 5       low 15
+//   0x10 \t \n \v \f \r high 0    low 9-13
+//   0x20 space       high 2       low 0
+// Bytes of 0x80 and above have no bits in the high table, matching the scalar
+// table.
+#define AVX2_WORD_BITS  0x0F
+#define AVX2_SPACE_BITS 0x30
+
+SHADER_TARGET_AVX2 static inline __m256i classify32(__m256i x) {
+	const __m256i lowTable = _mm256_setr_epi8(
+		0x25, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x17, 0x16, 0x12, 0x12, 0x12, 0x02, 0x0A,
+		0x25, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x17, 0x16, 0x12, 0x12, 0x12, 0x02, 0x0A);
+	const __m256i highTable = _mm256_setr_epi8(
+		0x10, 0x00, 0x20, 0x01, 0x02, 0x0C, 0x02, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x10, 0x00, 0x20, 0x01, 0x02, 0x0C, 0x02, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+	__m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(x, nibble));
+	__m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+	return _mm256_and_si256(low, high);
+}
+
+SHADER_TARGET_AVX2 static inline uint32_t notInClassMask32(__m256i x, char bits) {
+	__m256i cls = _mm256_and_si256(classify32(x), _mm256_set1_epi8(bits));
+	return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(cls, _mm256_setzero_si256())));
+}
+
+SHADER_TARGET_AVX2 static size_t findWordEndAVX2(const char *str, size_t pos, size_t len) {
+	while (pos + 32 <= len) {
+		uint32_t mask = notInClassMask32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + pos)), AVX2_WORD_BITS);
+		if (mask != 0)
+			return pos + countTrailingZeros(mask);
+		pos += 32;
+	}
+	return findWordEndSSE2(str, pos, len);
+}
+
+SHADER_TARGET_AVX2 static size_t findSpaceEndAVX2(const char *str, size_t pos, size_t len) {
+	while (pos + 32 <= len) {
+		uint32_t mask = notInClassMask32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + pos)), AVX2_SPACE_BITS);
+		if (mask != 0)
+			return pos + countTrailingZeros(mask);
+		pos += 32;
+	}
+	return findSpaceEndSSE2(str, pos, len);
+}
+
+static bool cpuSupportsAVX2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// The OS has to save the AVX registers as well.
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+// Start out with the scalar scanner so that shaders tokenized during static
+// initialization still work, then switch to the best one the processor has.
+ShaderScanner::Functions ShaderScanner::sFunctions = { ShaderScanner::SCALAR, findWordEndScalar, findSpaceEndScalar };
+static const ShaderScanner::Implementation sSelectedImplementation = ShaderScanner::setImplementation(ShaderScanner::AVX2);
+
+ShaderScanner::Implementation ShaderScanner::getImplementation() {
+	return sFunctions.implementation;
+}
+
+ShaderScanner::Implementation ShaderScanner::setImplementation(Implementation implementation) {
+	Implementation best = getBestImplementation();
+	if (implementation > best)
+		implementation = best;
+	sFunctions = getFunctions(implementation);
+	return implementation;
+}
+
+ShaderScanner::Implementation ShaderScanner::getBestImplementation() {
+#ifdef SHADER_SCANNER_AVX2
+	static const bool avx2 = cpuSupportsAVX2();
+	if (avx2)
+		return AVX2;
+#endif
+#ifdef SHADER_SCANNER_SSE2
+	return SSE2;
+#else
+	return SCALAR;
+#endif
+}
+
+ShaderScanner::Functions ShaderScanner::getFunctions(Implementation implementation) {
+	switch (implementation) {
+#ifdef SHADER_SCANNER_AVX2
+	case AVX2:
+		return { AVX2, findWordEndAVX2, findSpaceEndAVX2 };
+#endif
+#ifdef SHADER_SCANNER_SSE2
+	case SSE2:
+		return { SSE2, findWordEndSSE2, findSpaceEndSSE2 };
+#endif
+	default:
+		return { SCALAR, findWordEndScalar, findSpaceEndScalar };
+	}
+}
\ No newline at end of file
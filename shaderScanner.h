@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderScanner_h
+#define shaderScanner_h
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Character class bits used by the tokenizer.
+ */
+#define SHADER_CHAR_WORD  0x01
+#define SHADER_CHAR_DIGIT 0x02
+#define SHADER_CHAR_SPACE 0x04
+
+/**
+ * A table with the character class bits of every byte. The classes are
+ * plain ASCII and do not depend on the C locale: word characters are
+ * [A-Za-z0-9_], digits are [0-9], and spaces are the six characters that
+ * isspace accepts in the "C" locale.
+ */
+struct ShaderCharTable {
+	uint8_t classes[256];
+
+	constexpr ShaderCharTable() : classes() {
+		for (int c = 0; c < 256; c++) {
+			uint8_t bits = 0;
+			if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+				bits |= SHADER_CHAR_WORD;
+			if (c >= '0' && c <= '9')
+				bits |= SHADER_CHAR_WORD | SHADER_CHAR_DIGIT;
+			if (c == ' ' || (c >= '\t' && c <= '\r'))
+				bits |= SHADER_CHAR_SPACE;
+			classes[c] = bits;
+		}
+	}
+
+	constexpr bool is(char c, uint8_t bits) const {
+		return (classes[static_cast<unsigned char>(c)] & bits) != 0;
+	}
+};
+
+constexpr ShaderCharTable SHADER_CHAR_TABLE;
+
+/**
+ * Finds the ends of runs of word characters and whitespace for the tokenizer.
+ * On x86 the runs are scanned 16 bytes at a time with SSE2, or 32 bytes at a
+ * time with AVX2 when the processor supports it. Everywhere else the scalar
+ * table is used. Every implementation returns exactly the same positions.
+ */
+class ShaderScanner {
+public:
+	/**
+	 * Enum of the scanner implementations.
+	 */
+	enum Implementation {
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	/**
+	 * Finds the end of the run of word characters starting at 'pos'.
+	 * @param str The source being scanned.
+	 * @param pos The position to start scanning at.
+	 * @param len The length of the source.
+	 * @return the position of the first non word character, or 'len'.
+	 */
+	static inline size_t findWordEnd(const char *str, size_t pos, size_t len) {
+		return sFunctions.findWordEnd(str, pos, len);
+	}
+
+	/**
+	 * Finds the end of the run of whitespace starting at 'pos'.
+	 * @param str The source being scanned.
+	 * @param pos The position to start scanning at.
+	 * @param len The length of the source.
+	 * @return the position of the first non whitespace character, or 'len'.
+	 */
+	static inline size_t findSpaceEnd(const char *str, size_t pos, size_t len) {
+		return sFunctions.findSpaceEnd(str, pos, len);
+	}
+
+	/**
+	 * Get's the implementation that is currently in use.
+	 * @return the implementation in use.
+	 */
+	static Implementation getImplementation();
+
+	/**
+	 * Changes the implementation, which is useful for comparing them.
+	 * @param implementation The implementation to use. If the processor does
+	 *  not support it, the best supported implementation below it is used.
+	 * @return the implementation that is now in use.
+	 * @note This is not thread safe and should only be called while no
+	 *       shaders are being tokenized.
+	 */
+	static Implementation setImplementation(Implementation implementation);
+
+	/**
+	 * Get's the best implementation the processor supports.
+	 * @return the best supported implementation.
+	 */
+	static Implementation getBestImplementation();
+
+private:
+	typedef size_t (*FindRunEndFn)(const char *str, size_t pos, size_t len);
+
+	struct Functions {
+		Implementation implementation;
+		FindRunEndFn findWordEnd;
+		FindRunEndFn findSpaceEnd;
+	};
+
+	static Functions getFunctions(Implementation implementation);
+
+	static Functions sFunctions;
+};
+
+#endif /* shaderScanner_h */
\ No newline at end of file
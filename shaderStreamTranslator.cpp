@@ -0,0 +1,188 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderStreamTranslator.h"
+
+/**
+ * The amount of translated text that is queued before it is handed to the sink.
+ */
+#define STREAM_OUTPUT_BUFFER_SIZE 4096
+
+/**
+ * The size of the chunks read from an input stream.
+ */
+#define STREAM_INPUT_CHUNK_SIZE 65536
+
+ShaderStreamTranslator::ShaderStreamTranslator(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType, Sink sink) :
+	mTranslator(translator),
+	mShaderType(shaderType),
+	mTable(translator.getRewriteTable(shaderType)),
+	mSink(sink),
+	mState(NORMAL),
+	mCommentStar(false),
+	mStarted(false) {
+	mOutput.reserve(STREAM_OUTPUT_BUFFER_SIZE);
+}
+
+void ShaderStreamTranslator::feed(const char *data, size_t length) {
+	if (!mStarted) {
+		std::string_view header = mTranslator.getHeader(mShaderType);
+		write(header.data(), header.length());
+		mStarted = true;
+	}
+
+	// Everything except words is passed straight through, so only remember
+	// where the current run of untouched text and the current word started.
+	size_t copyStart = 0;
+	size_t wordStart = 0;
+	size_t i = 0;
+	while (i < length) {
+		char c = data[i];
+		switch (mState) {
+		case NORMAL:
+			if (ShaderTranslator::isWordcharacter(c)) {
+				write(data + copyStart, i - copyStart);
+				wordStart = i;
+				mState = WORD;
+			} else if (c == '/') {
+				mState = SLASH;
+			}
+			i++;
+			break;
+
+		case WORD:
+			if (ShaderTranslator::isWordcharacter(c)) {
+				i++;
+			} else {
+				// The word is complete, and 'c' is all the lookahead the rules need.
+				mWord.append(data + wordStart, i - wordStart);
+				finishWord(c);
+				copyStart = i;
+				mState = NORMAL;
+			}
+			break;
+
+		case SLASH:
+			// Check to see if the slash starts a comment. If not, look at this
+			// character again as normal source.
+			if (c == '/') {
+				mState = LINE_COMMENT;
+				i++;
+			} else if (c == '*') {
+				mState = BLOCK_COMMENT;
+				mCommentStar = false;
+				i++;
+			} else {
+				mState = NORMAL;
+			}
+			break;
+
+		case LINE_COMMENT:
+			if (c == '\n')
+				mState = NORMAL;
+			i++;
+			break;
+
+		case BLOCK_COMMENT:
+			if (mCommentStar && c == '/')
+				mState = NORMAL;
+			mCommentStar = (c == '*');
+			i++;
+			break;
+		}
+	}
+
+	// Keep the partial word for the next chunk, everything else can go out.
+	if (mState == WORD)
+		mWord.append(data + wordStart, length - wordStart);
+	else
+		write(data + copyStart, length - copyStart);
+	flush();
+}
+
+void ShaderStreamTranslator::finish() {
+	if (!mStarted)
+		feed(nullptr, 0);
+
+	if (mState == WORD)
+		finishWord('\0');
+	flush();
+
+	// Get ready for the next shader.
+	mState = NORMAL;
+	mCommentStar = false;
+	mStarted = false;
+}
+
+void ShaderStreamTranslator::translate(const ShaderTranslator &translator, std::istream &in, std::ostream &out, ShaderTranslator::ShaderType shaderType) {
+	ShaderStreamTranslator stream(translator, shaderType, [&out](const char *data, size_t length) {
+		out.write(data, length);
+	});
+
+	std::vector<char> chunk(STREAM_INPUT_CHUNK_SIZE);
+	while (in) {
+		in.read(chunk.data(), chunk.size());
+		stream.feed(chunk.data(), static_cast<size_t>(in.gcount()));
+	}
+	stream.finish();
+}
+
+void ShaderStreamTranslator::finishWord(char next) {
+	// Numbers are never rewritten.
+	std::string_view rep;
+	if (!SHADER_CHAR_TABLE.is(mWord[0], SHADER_CHAR_DIGIT))
+		rep = mTable.rewrite(mWord, next);
+
+	if (rep.empty())
+		write(mWord.data(), mWord.length());
+	else
+		write(rep.data(), rep.length());
+	mWord.clear();
+}
+
+void ShaderStreamTranslator::write(const char *data, size_t length) {
+	if (mOutput.length() + length > STREAM_OUTPUT_BUFFER_SIZE) {
+		flush();
+
+		// Big runs of untouched source skip the buffer entirely.
+		if (length > STREAM_OUTPUT_BUFFER_SIZE) {
+			mSink(data, length);
+			return;
+		}
+	}
+	mOutput.append(data, length);
+}
+
+void ShaderStreamTranslator::flush() {
+	if (!mOutput.empty()) {
+		mSink(mOutput.data(), mOutput.length());
+		mOutput.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderStreamTranslator_h
+#define shaderStreamTranslator_h
+
+#include <functional>
+#include "shaderTranslator.h"
+
+/**
+ * Translates a shader that arrives in chunks, without ever holding the whole
+ * source or the whole output in memory. Bytes are pushed in with feed() and
+ * the translated source is handed to a sink as soon as each token's rewrite
+ * is decided. The only data kept between chunks is the word currently being
+ * read, since a word can straddle the boundary between two chunks.
+ * Example usage:
+ *
+ * ShaderTranslatorGL33 translator;
+ * ShaderStreamTranslator stream(translator, ShaderTranslator::FRAGMENT, [](const char *data, size_t length) {
+ *    fwrite(data, 1, length, stdout);
+ * });
+ * while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+ *    stream.feed(buffer, length);
+ * stream.finish();
+ */
+class ShaderStreamTranslator {
+public:
+	/**
+	 * Receives translated shader source.
+	 */
+	typedef std::function<void(const char *data, size_t length)> Sink;
+
+	/**
+	 * Creates a stream translator.
+	 * @param translator The translator that supplies the header and rewrite
+	 *  rules. It must outlive the stream translator.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 * @param sink The function that receives the translated source.
+	 */
+	ShaderStreamTranslator(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType, Sink sink);
+
+	/**
+	 * Translates the next chunk of shader source.
+	 * @param data The chunk of source.
+	 * @param length The length of the chunk in bytes.
+	 */
+	void feed(const char *data, size_t length);
+
+	/**
+	 * Ends the shader, translating the last token and flushing the output.
+	 */
+	void finish();
+
+	/**
+	 * Translates a whole shader from an input stream to an output stream.
+	 * @param translator The translator that supplies the header and rewrite rules.
+	 * @param in The stream of shader source.
+	 * @param out The stream that receives the translated source.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 */
+	static void translate(const ShaderTranslator &translator, std::istream &in, std::ostream &out, ShaderTranslator::ShaderType shaderType);
+
+private:
+	/**
+	 * The state of the scanner between two characters.
+	 */
+	enum State {
+		NORMAL,
+		WORD,
+		SLASH,
+		LINE_COMMENT,
+		BLOCK_COMMENT
+	};
+
+	/**
+	 * Translates the word that was just read and writes it out.
+	 * @param next The first character after the word, or 0 at the end.
+	 */
+	void finishWord(char next);
+
+	/**
+	 * Queues translated text for the sink.
+	 * @param data The text.
+	 * @param length The length of the text in bytes.
+	 */
+	void write(const char *data, size_t length);
+
+	/**
+	 * Hands the queued text to the sink.
+	 */
+	void flush();
+
+	const ShaderTranslator &mTranslator;
+	ShaderTranslator::ShaderType mShaderType;
+	const ShaderRewriteTable &mTable;
+	Sink mSink;
+
+	State mState;
+
+	/**
+	 * Set when the last character of a block comment was a '*'.
+	 */
+	bool mCommentStar;
+
+	/**
+	 * Set once the header has been written.
+	 */
+	bool mStarted;
+
+	/**
+	 * The word currently being read.
+	 */
+	std::string mWord;
+
+	/**
+	 * Translated text waiting to be handed to the sink.
+	 */
+	std::string mOutput;
+};
+
+#endif /* shaderStreamTranslator_h */
\ No newline at end of file
@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderThreadPool.h"
+
+ShaderThreadPool::ShaderThreadPool(unsigned workerCount) :
+	mTask(nullptr),
+	mGeneration(0),
+	mActive(0),
+	mShutdown(false) {
+	if (workerCount == 0)
+		workerCount = std::thread::hardware_concurrency();
+	mWorkerCount = workerCount > 0 ? workerCount : 1;
+
+	for (unsigned i = 0; i < mWorkerCount; i++)
+		mQueues.emplace_back(new WorkQueue());
+
+	// Worker 0 is whichever thread calls parallelFor.
+	for (unsigned i = 1; i < mWorkerCount; i++)
+		mThreads.emplace_back(&ShaderThreadPool::workerMain, this, i);
+}
+
+ShaderThreadPool::~ShaderThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mStart.notify_all();
+	for (auto &thread : mThreads)
+		thread.join();
+}
+
+void ShaderThreadPool::parallelFor(size_t count, const Task &task) {
+	if (count == 0)
+		return;
+
+	std::lock_guard<std::mutex> run(mRunMutex);
+	if (mWorkerCount == 1 || count == 1) {
+		for (size_t i = 0; i < count; i++)
+			task(i, 0);
+		return;
+	}
+
+	// Give every worker a contiguous share to start with.
+	for (unsigned w = 0; w < mWorkerCount; w++) {
+		std::lock_guard<std::mutex> lock(mQueues[w]->mutex);
+		size_t begin = count * w / mWorkerCount;
+		size_t end = count * (w + 1) / mWorkerCount;
+		for (size_t i = begin; i < end; i++)
+			mQueues[w]->indices.push_back(i);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTask = &task;
+		mActive = mWorkerCount - 1;
+		mGeneration++;
+	}
+	mStart.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this] { return mActive == 0; });
+	mTask = nullptr;
+
+	// Hand a task's exception to the caller, as a plain loop would.
+	std::exception_ptr error = mError;
+	mError = nullptr;
+	lock.unlock();
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void ShaderThreadPool::workerMain(unsigned worker) {
+	uint64_t generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mStart.wait(lock, [this, generation] { return mShutdown || mGeneration != generation; });
+			if (mShutdown)
+				return;
+			generation = mGeneration;
+		}
+
+		work(worker);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (--mActive == 0)
+			mDone.notify_one();
+	}
+}
+
+void ShaderThreadPool::work(unsigned worker) {
+	// No new work is added while a batch runs, so once every queue is empty
+	// this worker is done.
+	size_t index;
+	while (pop(worker, index) || steal(worker, index)) {
+		try {
+			(*mTask)(index, worker);
+		} catch (...) {
+			fail(std::current_exception());
+		}
+	}
+}
+
+void ShaderThreadPool::fail(std::exception_ptr error) {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!mError)
+			mError = error;
+	}
+
+	for (auto &queue : mQueues) {
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->indices.clear();
+	}
+}
+
+bool ShaderThreadPool::pop(unsigned worker, size_t &index) {
+	WorkQueue &queue = *mQueues[worker];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.indices.empty())
+		return false;
+	index = queue.indices.front();
+	queue.indices.pop_front();
+	return true;
+}
+
+bool ShaderThreadPool::steal(unsigned worker, size_t &index) {
+	for (unsigned i = 1; i < mWorkerCount; i++) {
+		WorkQueue &queue = *mQueues[(worker + i) % mWorkerCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.indices.empty()) {
+			index = queue.indices.back();
+			queue.indices.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
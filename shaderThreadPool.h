@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderThreadPool_h
+#define shaderThreadPool_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A pool of worker threads that run a task over a range of indices. Every
+ * worker starts with its own share of the indices, and a worker that runs
+ * out steals from the others, so uneven tasks such as shaders of very
+ * different sizes still keep every core busy. The calling thread works as
+ * well, as worker 0.
+ */
+class ShaderThreadPool {
+public:
+	/**
+	 * The task run for every index.
+	 * @param index The index to work on.
+	 * @param worker The worker that is running the task, in [0, getWorkerCount()).
+	 */
+	typedef std::function<void(size_t index, unsigned worker)> Task;
+
+	/**
+	 * Creates a pool.
+	 * @param workerCount The number of workers, including the calling thread.
+	 *  0 uses one worker per hardware thread.
+	 */
+	explicit ShaderThreadPool(unsigned workerCount = 0);
+	~ShaderThreadPool();
+
+	ShaderThreadPool(const ShaderThreadPool &) = delete;
+	ShaderThreadPool &operator=(const ShaderThreadPool &) = delete;
+
+	/**
+	 * Runs 'task' for every index in [0, count) and waits for all of them.
+	 * If a task throws, the indices that have not started yet are skipped and
+	 * the first exception is rethrown here once every worker has stopped.
+	 * @param count The number of indices.
+	 * @param task The task to run.
+	 */
+	void parallelFor(size_t count, const Task &task);
+
+	unsigned getWorkerCount() const {
+		return mWorkerCount;
+	}
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<size_t> indices;
+	};
+
+	/**
+	 * The main loop of a worker thread.
+	 * @param worker The worker index of the thread.
+	 */
+	void workerMain(unsigned worker);
+
+	/**
+	 * Runs tasks until there is no work left in any queue.
+	 * @param worker The worker that is working.
+	 */
+	void work(unsigned worker);
+
+	/**
+	 * Keeps the first exception a task threw and drops the work that is left.
+	 * @param error The exception.
+	 */
+	void fail(std::exception_ptr error);
+
+	/**
+	 * Takes the next index from the worker's own queue.
+	 */
+	bool pop(unsigned worker, size_t &index);
+
+	/**
+	 * Takes an index from the back of another worker's queue.
+	 */
+	bool steal(unsigned worker, size_t &index);
+
+	unsigned mWorkerCount;
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	std::vector<std::thread> mThreads;
+
+	/**
+	 * Only one parallelFor can run at a time.
+	 */
+	std::mutex mRunMutex;
+
+	std::mutex mMutex;
+	std::condition_variable mStart;
+	std::condition_variable mDone;
+	const Task *mTask;
+
+	/**
+	 * The first exception a task of the running parallelFor threw.
+	 */
+	std::exception_ptr mError;
+	uint64_t mGeneration;
+	unsigned mActive;
+	bool mShutdown;
+};
+
+#endif /* shaderThreadPool_h */
\ No newline at end of file
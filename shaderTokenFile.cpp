@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <cstring>
+#include "shaderTokenFile.h"
+#include "shaderTranslator.h"
+
+#define SHADER_TOKEN_FILE_MAGIC "GLSLTK\0\0"
+
+/**
+ * The header at the start of a token file. It is followed by the source, the
+ * rewrite stream and the token stream, in that order.
+ */
+struct TokenFileHeader {
+	char magic[8];
+	uint32_t formatVersion;
+	uint32_t rulesVersion;
+	uint32_t sourceLength;
+	uint32_t tokenCount;
+	uint32_t tokenBytes;
+	uint32_t rewriteCount;
+	uint32_t rewriteBytes;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(TokenFileHeader) == 40, "TokenFileHeader must not have padding.");
+
+/**
+ * The tables whose identifiers are tagged. Every other table of the library
+ * is empty.
+ */
+static const ShaderRewriteTable *const TAGGED_TABLES[] = {
+	&SHADER_GL33_VERTEX_TABLE,
+	&SHADER_GL33_FRAGMENT_TABLE
+};
+
+static bool isTaggedName(std::string_view name) {
+	for (const ShaderRewriteTable *table : TAGGED_TABLES) {
+		if (table->find(name))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Appends a variable length integer, seven bits at a time, lowest bits first.
+ */
+static void appendVarint(std::string &data, uint32_t value) {
+	do {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		data.push_back(static_cast<char>(byte));
+	} while (value);
+}
+
+/**
+ * Reads a variable length integer written by appendVarint().
+ * @return false if it runs past the end or does not fit in 32 bits.
+ */
+static inline bool readVarint(const uint8_t *&pos, const uint8_t *end, uint32_t &value) {
+	uint64_t result = 0;
+	uint8_t byte = 0;
+	unsigned shift = 0;
+	do {
+		if (pos == end || shift > 28)
+			return false;
+		byte = *pos++;
+		result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (result > UINT32_MAX)
+		return false;
+	value = static_cast<uint32_t>(result);
+	return true;
+}
+
+/**
+ * Works out the kind of the token that starts at 'offset' from its first two
+ * characters, the same way shaderScanToken() does.
+ */
+static inline ShaderToken::Kind getTokenKind(std::string_view source, size_t offset) {
+	char c = source[offset];
+	if (c == '/' && offset + 1 < source.length() && (source[offset + 1] == '/' || source[offset + 1] == '*'))
+		return ShaderToken::COMMENT;
+	if (SHADER_CHAR_TABLE.is(c, SHADER_CHAR_SPACE))
+		return ShaderToken::WHITESPACE;
+	if (SHADER_CHAR_TABLE.is(c, SHADER_CHAR_WORD))
+		return SHADER_CHAR_TABLE.is(c, SHADER_CHAR_DIGIT) ? ShaderToken::NUMBER : ShaderToken::IDENTIFIER;
+	return ShaderToken::PUNCTUATION;
+}
+
+ShaderTokenFile::ShaderTokenFile() :
+	mRewrites(nullptr),
+	mRewriteBytes(0),
+	mTokens(nullptr),
+	mTokenBytes(0),
+	mTokenCount(0),
+	mRewriteCount(0),
+	mLoaded(false) {
+}
+
+bool ShaderTokenFile::build(std::string_view source, std::string &data) {
+	if (source.length() > UINT32_MAX)
+		return false;
+
+	ShaderTranslationContext context;
+	context.tokenize(source);
+	const ShaderTokenList &tokens = context.getTokens();
+
+	std::string rewrites;
+	std::string stream;
+	uint32_t rewriteCount = 0;
+	uint32_t end = 0;
+	stream.reserve(tokens.size());
+	for (const ShaderToken &token : tokens) {
+		// Punctuation is always a single character.
+		if (token.kind != ShaderToken::PUNCTUATION)
+			appendVarint(stream, token.length);
+
+		if (token.kind == ShaderToken::IDENTIFIER && isTaggedName(context.getTokenText(token))) {
+			appendVarint(rewrites, token.offset - end);
+			appendVarint(rewrites, token.length);
+			end = token.offset + token.length;
+			rewriteCount++;
+		}
+	}
+
+	TokenFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SHADER_TOKEN_FILE_MAGIC, sizeof(header.magic));
+	header.formatVersion = SHADER_TOKEN_FILE_VERSION;
+	header.rulesVersion = SHADER_TRANSLATOR_RULES_VERSION;
+	header.sourceLength = static_cast<uint32_t>(source.length());
+	header.tokenCount = static_cast<uint32_t>(tokens.size());
+	header.tokenBytes = static_cast<uint32_t>(stream.length());
+	header.rewriteCount = rewriteCount;
+	header.rewriteBytes = static_cast<uint32_t>(rewrites.length());
+
+	data.clear();
+	data.reserve(sizeof(header) + source.length() + rewrites.length() + stream.length());
+	data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+	data.append(source);
+	data.append(rewrites);
+	data.append(stream);
+	return true;
+}
+
+bool ShaderTokenFile::write(const std::string &path, std::string_view source) {
+	std::string data;
+	return build(source, data) && shaderWriteFileAtomic(path, data.data(), data.length());
+}
+
+bool ShaderTokenFile::open(const std::string &path) {
+	close();
+	if (!mMapping.open(path))
+		return false;
+	if (!parse(mMapping.getData(), mMapping.getSize())) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ShaderTokenFile::load(const char *data, size_t size) {
+	close();
+	return parse(data, size);
+}
+
+void ShaderTokenFile::close() {
+	mMapping.close();
+	mSource = std::string_view();
+	mRewrites = nullptr;
+	mRewriteBytes = 0;
+	mTokens = nullptr;
+	mTokenBytes = 0;
+	mTokenCount = 0;
+	mRewriteCount = 0;
+	mLoaded = false;
+}
+
+bool ShaderTokenFile::parse(const char *data, size_t size) {
+	TokenFileHeader header;
+	if (!data || size < sizeof(header))
+		return false;
+
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, SHADER_TOKEN_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.formatVersion != SHADER_TOKEN_FILE_VERSION ||
+		header.rulesVersion != SHADER_TRANSLATOR_RULES_VERSION)
+		return false;
+
+	if (sizeof(header) + static_cast<uint64_t>(header.sourceLength) + header.rewriteBytes + header.tokenBytes != size)
+		return false;
+
+	// Every token takes at least one character of the source.
+	if (header.tokenCount > header.sourceLength)
+		return false;
+
+	const char *pos = data + sizeof(header);
+	std::string_view source(pos, header.sourceLength);
+	pos += header.sourceLength;
+	const uint8_t *rewrites = reinterpret_cast<const uint8_t *>(pos);
+	pos += header.rewriteBytes;
+
+	// Everything a translation reads through the uses has to be inside of
+	// the source. nextRewrite() relies on this and does not check again.
+	const uint8_t *rewrite = rewrites;
+	const uint8_t *rewritesEnd = rewrites + header.rewriteBytes;
+	uint64_t end = 0;
+	uint32_t count = 0;
+	while (rewrite < rewritesEnd) {
+		uint32_t gap;
+		uint32_t length;
+		if (!readVarint(rewrite, rewritesEnd, gap) || !readVarint(rewrite, rewritesEnd, length) || length == 0)
+			return false;
+		end += static_cast<uint64_t>(gap) + length;
+		if (end > source.length())
+			return false;
+		count++;
+	}
+	if (count != header.rewriteCount)
+		return false;
+
+	mSource = source;
+	mRewrites = rewrites;
+	mRewriteBytes = header.rewriteBytes;
+	mTokens = reinterpret_cast<const uint8_t *>(pos);
+	mTokenBytes = header.tokenBytes;
+	mTokenCount = header.tokenCount;
+	mRewriteCount = header.rewriteCount;
+	mLoaded = true;
+	return true;
+}
+
+bool ShaderTokenFile::nextRewrite(RewriteCursor &cursor, Rewrite &rewrite) const {
+	if (cursor.pos == mRewriteBytes)
+		return false;
+
+	const uint8_t *pos = mRewrites + cursor.pos;
+	const uint8_t *end = mRewrites + mRewriteBytes;
+	uint32_t gap = 0;
+	readVarint(pos, end, gap);
+	readVarint(pos, end, rewrite.length);
+	rewrite.offset = cursor.end + gap;
+	cursor.pos = pos - mRewrites;
+	cursor.end = rewrite.offset + rewrite.length;
+	return true;
+}
+
+bool ShaderTokenFile::decodeTokens(ShaderTranslationContext &context) const {
+	ShaderTokenList &tokens = context.resetTokens(mSource);
+	tokens.reserve(mTokenCount);
+
+	const uint8_t *pos = mTokens;
+	const uint8_t *end = mTokens + mTokenBytes;
+	size_t offset = 0;
+	while (offset < mSource.length()) {
+		ShaderToken::Kind kind = getTokenKind(mSource, offset);
+		uint32_t length = 1;
+		if (kind != ShaderToken::PUNCTUATION && !readVarint(pos, end, length))
+			return false;
+		if (length == 0 || length > mSource.length() - offset)
+			return false;
+		tokens.push_back({ static_cast<uint32_t>(offset), length, kind });
+		offset += length;
+	}
+	return pos == end && tokens.size() == mTokenCount;
+}
+
+bool ShaderTokenFile::isTagged(const ShaderRewriteTable &table) {
+	// The tables are inline variables, so the library's own have the same
+	// address everywhere and do not need their rules checked.
+	for (const ShaderRewriteTable *tagged : TAGGED_TABLES) {
+		if (&table == tagged)
+			return true;
+	}
+
+	for (size_t i = 0; i < table.getRuleCount(); i++) {
+		if (!isTaggedName(table.getRule(i).keyword))
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderTokenFile_h
+#define shaderTokenFile_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "shaderFile.h"
+#include "shaderRewriteRules.h"
+#include "shaderTranslationContext.h"
+
+/**
+ * The version of the token file layout. Bump this when the layout changes.
+ */
+#define SHADER_TOKEN_FILE_VERSION 2
+
+/**
+ * A shader that was tokenized ahead of time, so that loading it at runtime
+ * costs one read or mapping and no scanning of characters.
+ *
+ * The file holds a header, the source, the uses of the identifiers that a
+ * rewrite rule may rewrite, and the token stream. Only what can not be read
+ * off the source with a glance at its first characters is stored: a use is
+ * two variable length integers, the gap from the end of the use before it
+ * and its length, and the token stream only has the lengths of the tokens
+ * that are not punctuation, which are always one character long, usually a
+ * byte each. The kind of a token follows from its first two characters.
+ * Translating with ShaderTranslator::translateTokenFile()
+ * copies the source between the tagged uses and only looks those up, and
+ * the token stream is decoded only for translators that preprocess or
+ * minify.
+ *
+ * Files are written by the same version of the library that reads them,
+ * usually at build time, and a file with a different format or rules
+ * version is refused. The uses are checked against the size of the file
+ * when it is loaded, so a damaged file cannot make a translation read
+ * outside of it. The header is in the byte order of the machine.
+ * Example usage:
+ *
+ * // At build time.
+ * ShaderTokenFile::write("mesh.frag.gltk", source);
+ *
+ * // At runtime.
+ * ShaderTokenFile file;
+ * if (file.open("mesh.frag.gltk"))
+ *     translator.translateTokenFile(context, file, ShaderTranslator::FRAGMENT, shader);
+ */
+class ShaderTokenFile {
+public:
+	/**
+	 * A use of an identifier that may be rewritten.
+	 */
+	struct Rewrite {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	/**
+	 * Where nextRewrite() carries on reading the uses.
+	 */
+	struct RewriteCursor {
+		size_t pos = 0;
+		uint32_t end = 0;
+	};
+
+	ShaderTokenFile();
+
+	ShaderTokenFile(const ShaderTokenFile &) = delete;
+	ShaderTokenFile &operator=(const ShaderTokenFile &) = delete;
+
+	/**
+	 * Tokenizes a shader into the token file format.
+	 * @param source The shader source.
+	 * @param data Receives the contents of the token file.
+	 * @return false if the shader is 4 GB or larger.
+	 */
+	static bool build(std::string_view source, std::string &data);
+
+	/**
+	 * Tokenizes a shader and writes it to a token file atomically.
+	 * @param path The path of the token file.
+	 * @param source The shader source.
+	 * @return true if the file was written, false otherwise.
+	 */
+	static bool write(const std::string &path, std::string_view source);
+
+	/**
+	 * Maps a token file, closing any file that was loaded before.
+	 * @param path The path of the token file.
+	 * @return true if the file is valid and was mapped, false otherwise.
+	 */
+	bool open(const std::string &path);
+
+	/**
+	 * Loads a token file that the caller keeps in memory, for example after
+	 * reading it from an archive.
+	 * @param data The contents of the token file. It must stay alive while
+	 *  the file is used.
+	 * @param size The size of the contents in bytes.
+	 * @return true if the file is valid, false otherwise.
+	 */
+	bool load(const char *data, size_t size);
+
+	/**
+	 * Unloads the file.
+	 */
+	void close();
+
+	bool isLoaded() const {
+		return mLoaded;
+	}
+
+	/**
+	 * Get's the shader source.
+	 * @return the source, inside of the file.
+	 */
+	std::string_view getSource() const {
+		return mSource;
+	}
+
+	size_t getTokenCount() const {
+		return mTokenCount;
+	}
+
+	size_t getRewriteCount() const {
+		return mRewriteCount;
+	}
+
+	/**
+	 * Reads the next use of an identifier that may be rewritten, in source
+	 * order.
+	 * @param cursor Where to read from, default constructed for the first use.
+	 * @param rewrite Receives the use.
+	 * @return false once every use was read.
+	 */
+	bool nextRewrite(RewriteCursor &cursor, Rewrite &rewrite) const;
+
+	/**
+	 * Decodes the token stream into a context, in place of tokenizing the
+	 * source.
+	 * @param context The context that receives the source and its tokens.
+	 * @return false if the token stream does not cover the source.
+	 */
+	bool decodeTokens(ShaderTranslationContext &context) const;
+
+	/**
+	 * Determines if a rewrite table only has rules for identifiers that token
+	 * files tag, so that translating with it only has to look at the tagged
+	 * uses.
+	 * @param table The rewrite table.
+	 * @return true if the tagged uses are enough for the table.
+	 */
+	static bool isTagged(const ShaderRewriteTable &table);
+
+private:
+	/**
+	 * Checks a token file and points the tables into it.
+	 * @return true if the file is valid, false otherwise.
+	 */
+	bool parse(const char *data, size_t size);
+
+	ShaderMappedFile mMapping;
+	std::string_view mSource;
+	const uint8_t *mRewrites;
+	size_t mRewriteBytes;
+	const uint8_t *mTokens;
+	size_t mTokenBytes;
+	size_t mTokenCount;
+	size_t mRewriteCount;
+	bool mLoaded;
+};
+
+#endif /* shaderTokenFile_h */
\ No newline at end of file
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderHash.h"
+#include "shaderTranslationCache.h"
+
+/**
+ * The bookkeeping cost of a cached shader that is counted against the budget
+ * on top of the translated source itself.
+ */
+#define SHADER_CACHE_ENTRY_OVERHEAD 96
+
+ShaderTranslationCache::ShaderTranslationCache(size_t byteBudget) :
+	mByteBudget(byteBudget),
+	mByteSize(0),
+	mHits(0),
+	mMisses(0),
+	mEvictions(0) {
+}
+
+const std::string ShaderTranslationCache::translate(const ShaderTranslator &translator, const std::string &str, ShaderTranslator::ShaderType shaderType) {
+	Key key = makeKey(translator, str, shaderType);
+	auto cached = find(key);
+	if (cached)
+		return *cached;
+
+	std::string translated = translator.translate(str, shaderType);
+	insert(key, translated);
+	return translated;
+}
+
+ShaderTranslationCache::Key ShaderTranslationCache::makeKey(const ShaderTranslator &translator, std::string_view str, ShaderTranslator::ShaderType shaderType) {
+	Key key;
+	key.hash = shaderHash64(str.data(), str.length());
+	key.length = str.length();
+	key.configuration = translator.getConfigurationHash();
+	key.shaderType = shaderType;
+	return key;
+}
+
+std::shared_ptr<const std::string> ShaderTranslationCache::find(const Key &key) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mIndex.find(key);
+	if (it == mIndex.end()) {
+		mMisses.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	// Move it to the front, it is now the most recently used.
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+	mHits.fetch_add(1, std::memory_order_relaxed);
+	return it->second->translated;
+}
+
+std::shared_ptr<const std::string> ShaderTranslationCache::insert(const Key &key, std::string translated) {
+	size_t bytes = translated.length() + SHADER_CACHE_ENTRY_OVERHEAD;
+	auto shared = std::make_shared<const std::string>(std::move(translated));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (bytes > mByteBudget)
+		return shared;
+
+	// Another thread may have translated the same shader in the meantime.
+	auto it = mIndex.find(key);
+	if (it != mIndex.end()) {
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return it->second->translated;
+	}
+
+	mEntries.push_front({ key, shared, bytes });
+	mIndex[key] = mEntries.begin();
+	mByteSize += bytes;
+	evict();
+	return shared;
+}
+
+void ShaderTranslationCache::clear() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.clear();
+	mIndex.clear();
+	mByteSize = 0;
+}
+
+void ShaderTranslationCache::setByteBudget(size_t byteBudget) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mByteBudget = byteBudget;
+	evict();
+}
+
+size_t ShaderTranslationCache::getByteBudget() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mByteBudget;
+}
+
+size_t ShaderTranslationCache::getByteSize() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mByteSize;
+}
+
+size_t ShaderTranslationCache::getEntryCount() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mEntries.size();
+}
+
+void ShaderTranslationCache::evict() {
+	while (mByteSize > mByteBudget && !mEntries.empty()) {
+		const Entry &entry = mEntries.back();
+		mByteSize -= entry.bytes;
+		mIndex.erase(entry.key);
+		mEntries.pop_back();
+		mEvictions.fetch_add(1, std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
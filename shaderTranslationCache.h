@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderTranslationCache_h
+#define shaderTranslationCache_h
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "shaderTranslator.h"
+
+/**
+ * The default amount of translated source a cache holds, in bytes.
+ */
+#define SHADER_CACHE_DEFAULT_BUDGET (16 * 1024 * 1024)
+
+/**
+ * An in memory cache of translated shaders that sits in front of the
+ * translators. Shaders are keyed by a hash of their source bytes together
+ * with the translator's backend and options and the shader type, so a hit
+ * returns the translated source without tokenizing at all. When the cache
+ * grows past its byte budget, the least recently used shaders are evicted.
+ * The cache can be shared between threads.
+ * Example usage:
+ *
+ * ShaderTranslationCache cache(4 * 1024 * 1024);
+ * ShaderTranslatorGL33 translator;
+ * auto shader = cache.translate(translator, source, ShaderTranslator::FRAGMENT);
+ */
+class ShaderTranslationCache {
+public:
+	/**
+	 * The key a translated shader is stored under.
+	 */
+	struct Key {
+		uint64_t hash;
+		uint64_t length;
+		uint64_t configuration;
+		ShaderTranslator::ShaderType shaderType;
+
+		bool operator==(const Key &other) const {
+			return hash == other.hash && length == other.length && configuration == other.configuration && shaderType == other.shaderType;
+		}
+
+		struct Hasher {
+			size_t operator()(const Key &key) const {
+				return static_cast<size_t>(key.hash ^ key.configuration ^ (static_cast<uint64_t>(key.shaderType) << 32));
+			}
+		};
+	};
+
+	/**
+	 * Creates a cache.
+	 * @param byteBudget The amount of translated source the cache may hold.
+	 */
+	explicit ShaderTranslationCache(size_t byteBudget = SHADER_CACHE_DEFAULT_BUDGET);
+
+	/**
+	 * Translates a shader, or returns the translation from the cache if the
+	 * same source was already translated with the same configuration.
+	 * @param translator The translator to use when the shader is not cached.
+	 * @param str The shader source.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 * @return the translated shader source.
+	 */
+	const std::string translate(const ShaderTranslator &translator, const std::string &str, ShaderTranslator::ShaderType shaderType);
+
+	/**
+	 * Builds the key a shader is stored under.
+	 * @param translator The translator the shader is translated with.
+	 * @param str The shader source.
+	 * @param shaderType The type of shader stream.
+	 * @return the key of the shader.
+	 */
+	static Key makeKey(const ShaderTranslator &translator, std::string_view str, ShaderTranslator::ShaderType shaderType);
+
+	/**
+	 * Looks up a translated shader, counting a hit or a miss.
+	 * @param key The key of the shader.
+	 * @return the translated source, or null if it is not cached.
+	 */
+	std::shared_ptr<const std::string> find(const Key &key);
+
+	/**
+	 * Adds a translated shader, evicting old shaders to stay in budget.
+	 * Shaders bigger than the whole budget are not stored.
+	 * @param key The key of the shader.
+	 * @param translated The translated source.
+	 * @return the stored translated source.
+	 */
+	std::shared_ptr<const std::string> insert(const Key &key, std::string translated);
+
+	/**
+	 * Removes every shader from the cache. The counters are kept.
+	 */
+	void clear();
+
+	/**
+	 * Changes the byte budget, evicting shaders if the cache is now over it.
+	 * @param byteBudget The amount of translated source the cache may hold.
+	 */
+	void setByteBudget(size_t byteBudget);
+
+	size_t getByteBudget() const;
+	size_t getByteSize() const;
+	size_t getEntryCount() const;
+
+	uint64_t getHitCount() const {
+		return mHits.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getMissCount() const {
+		return mMisses.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getEvictionCount() const {
+		return mEvictions.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry {
+		Key key;
+		std::shared_ptr<const std::string> translated;
+		size_t bytes;
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	/**
+	 * Evicts the least recently used shaders until the cache fits its budget.
+	 * The mutex must be held.
+	 */
+	void evict();
+
+	mutable std::mutex mMutex;
+
+	/**
+	 * The shaders, most recently used first.
+	 */
+	EntryList mEntries;
+	std::unordered_map<Key, EntryList::iterator, Key::Hasher> mIndex;
+
+	size_t mByteBudget;
+	size_t mByteSize;
+
+	std::atomic<uint64_t> mHits;
+	std::atomic<uint64_t> mMisses;
+	std::atomic<uint64_t> mEvictions;
+};
+
+#endif /* shaderTranslationCache_h */
\ No newline at end of file
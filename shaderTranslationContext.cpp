@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include <cstring>
+#include "shaderMinifier.h"
+#include "shaderPreprocessor.h"
+#include "shaderReflection.h"
+#include "shaderTranslationContext.h"
+
+ShaderTranslationContext::ShaderTranslationContext() = default;
+ShaderTranslationContext::ShaderTranslationContext(ShaderTranslationContext &&other) noexcept = default;
+ShaderTranslationContext &ShaderTranslationContext::operator=(ShaderTranslationContext &&other) noexcept = default;
+ShaderTranslationContext::~ShaderTranslationContext() = default;
+
+/**
+ * Finds the ends of runs with the SIMD scanner and memchr. Kept inline so
+ * the tokenize loop does not pay for a call per token.
+ */
+struct ShaderRuntimeScan {
+	static inline size_t findWordEnd(const char *data, size_t pos, size_t len) {
+		return ShaderScanner::findWordEnd(data, pos, len);
+	}
+
+	static inline size_t findSpaceEnd(const char *data, size_t pos, size_t len) {
+		return ShaderScanner::findSpaceEnd(data, pos, len);
+	}
+
+	static inline size_t findChar(const char *data, size_t pos, size_t len, char c) {
+		const void *found = memchr(data + pos, c, len - pos);
+		return found ? static_cast<const char *>(found) - data : len;
+	}
+};
+
+ShaderToken ShaderTranslationContext::readToken(std::string_view str, size_t offset) {
+	return shaderScanToken<ShaderRuntimeScan>(str.data(), str.length(), offset);
+}
+
+bool ShaderTranslationContext::tokenize(std::string_view str) {
+	// Clear out the tokens and any rewrites from the last shader. The vectors
+	// keep their capacity so a reused context does not allocate again.
+	mTokens.clear();
+	mReplacements.clear();
+	mSource = std::string_view();
+	if (str.length() > UINT32_MAX)
+		return false;
+
+	mSource = str;
+	size_t len = str.length();
+
+	// Roughly one token for every four characters of source is typical for
+	// GLSL, so reserve that up front to avoid growing the vector token by token.
+	mTokens.reserve(len / 4 + 1);
+
+	const char *data = str.data();
+	size_t i = 0;
+	while (i < len) {
+		ShaderToken token = shaderScanToken<ShaderRuntimeScan>(data, len, i);
+		mTokens.push_back(token);
+		i += token.length;
+	}
+	return true;
+}
+
+ShaderTokenList &ShaderTranslationContext::resetTokens(std::string_view str) {
+	mTokens.clear();
+	mReplacements.clear();
+	mSource = str;
+	return mTokens;
+}
+
+ShaderPreprocessor &ShaderTranslationContext::getPreprocessor() {
+	if (!mPreprocessor)
+		mPreprocessor.reset(new ShaderPreprocessor());
+	return *mPreprocessor;
+}
+
+ShaderMinifier &ShaderTranslationContext::getMinifier() {
+	if (!mMinifier)
+		mMinifier.reset(new ShaderMinifier());
+	return *mMinifier;
+}
+
+ShaderReflection &ShaderTranslationContext::getReflection() {
+	if (!mReflection)
+		mReflection.reset(new ShaderReflection());
+	return *mReflection;
+}
+
+const std::string ShaderTranslationContext::emit(std::string_view header) const {
+	std::string shader;
+	emit(header, shader);
+	return shader;
+}
+
+void ShaderTranslationContext::emit(std::string_view header, std::string &shader) const {
+	// Work out the exact size of the output so that it is allocated only once.
+	size_t size = header.length() + mSource.length();
+	for (const auto &rep : mReplacements) {
+		const ShaderToken &first = mTokens[rep.token];
+		const ShaderToken &last = mTokens[rep.token + rep.count - 1];
+		size += rep.text.length();
+		size -= last.offset + last.length - first.offset;
+	}
+
+	shader.clear();
+	shader.reserve(size);
+	shader.append(header);
+
+	// Copy the source between the rewritten tokens straight across.
+	size_t pos = 0;
+	for (const auto &rep : mReplacements) {
+		const ShaderToken &first = mTokens[rep.token];
+		const ShaderToken &last = mTokens[rep.token + rep.count - 1];
+		shader.append(mSource, pos, first.offset - pos);
+		shader.append(rep.text);
+		pos = last.offset + last.length;
+	}
+	shader.append(mSource, pos, std::string_view::npos);
+}
\ No newline at end of file
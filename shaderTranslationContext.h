@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderTranslationContext_h
+#define shaderTranslationContext_h
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "shaderScanner.h"
+#include "shaderTranslatorStats.h"
+
+/**
+ * A single token of shader source. Tokens do not own any text, they are a
+ * span (offset and length) into the source string that was tokenized.
+ */
+struct ShaderToken {
+	/**
+	 * Enum that handles the different kinds of tokens the tokenizer produces.
+	 * Whitespace and comments are kept as tokens so that the source can be
+	 * rebuilt byte for byte from the token list.
+	 */
+	enum Kind : uint8_t {
+		IDENTIFIER,
+		NUMBER,
+		PUNCTUATION,
+		WHITESPACE,
+		COMMENT
+	};
+
+	uint32_t offset;
+	uint32_t length;
+	Kind kind;
+};
+
+static_assert(ShaderToken::COMMENT + 1 == SHADER_STATS_TOKEN_KINDS, "SHADER_STATS_TOKEN_KINDS is out of date.");
+
+/**
+ * Reads the token that starts at 'offset'. The tokenizer and the compile time
+ * translator share these rules and only differ in how they find where runs of
+ * characters end, which 'Scan' supplies with findWordEnd(), findSpaceEnd()
+ * and findChar(). Each takes the source, a position and the source length
+ * and returns the position the run ends at, or the length.
+ * @param data The shader source.
+ * @param len The length of the source.
+ * @param offset Where the token starts. Must be less than the length.
+ * @return the token.
+ */
+template <typename Scan>
+constexpr ShaderToken shaderScanToken(const char *data, size_t len, size_t offset) {
+	size_t i = offset;
+	ShaderToken::Kind kind = ShaderToken::PUNCTUATION;
+	if (data[i] == '/' && (i + 1) < len && data[i + 1] == '/') {
+		// line comment, runs up to the end of the line.
+		kind = ShaderToken::COMMENT;
+		i = Scan::findChar(data, i, len, '\n');
+	} else if (data[i] == '/' && (i + 1) < len && data[i + 1] == '*') {
+		// block comment, runs up to and including the closing */
+		kind = ShaderToken::COMMENT;
+		i += 2;
+		for (;;) {
+			i = Scan::findChar(data, i, len, '*');
+			if (i == len)
+				break;
+			i++;
+			if (i < len && data[i] == '/') {
+				i++;
+				break;
+			}
+		}
+	} else if (SHADER_CHAR_TABLE.is(data[i], SHADER_CHAR_SPACE)) {
+		// grab the full whitespace run and push that as a token.
+		kind = ShaderToken::WHITESPACE;
+		i = Scan::findSpaceEnd(data, i, len);
+	} else if (SHADER_CHAR_TABLE.is(data[i], SHADER_CHAR_WORD)) {
+		// grab full word and push that as a token. This has to be checked
+		// before punctuation, as '_' is both and can start an identifier.
+		kind = SHADER_CHAR_TABLE.is(data[i], SHADER_CHAR_DIGIT) ? ShaderToken::NUMBER : ShaderToken::IDENTIFIER;
+		i = Scan::findWordEnd(data, i, len);
+	} else {
+		i++;
+	}
+	return { static_cast<uint32_t>(offset), static_cast<uint32_t>(i - offset), kind };
+}
+
+typedef std::vector<ShaderToken> ShaderTokenList;
+
+/**
+ * A rewrite of a token, or of a range of tokens. Instead of modifying the
+ * tokens, the translator records the replacement text and splices it in when
+ * the output is emitted.
+ */
+struct ShaderReplacement {
+	size_t token;
+	size_t count;
+	std::string_view text;
+};
+
+typedef std::vector<ShaderReplacement> ShaderReplacementList;
+
+class ShaderMinifier;
+class ShaderPreprocessor;
+class ShaderReflection;
+
+/**
+ * Holds everything a single translation works on: the source, its tokens,
+ * and the rewrites decided for them. Translators themselves keep no state
+ * between calls, so one translator can be shared between threads as long as
+ * every thread uses its own context. Reusing a context for many shaders also
+ * reuses its memory.
+ */
+class ShaderTranslationContext {
+public:
+	ShaderTranslationContext();
+	ShaderTranslationContext(ShaderTranslationContext &&other) noexcept;
+	ShaderTranslationContext &operator=(ShaderTranslationContext &&other) noexcept;
+	~ShaderTranslationContext();
+
+	/**
+	 * Tokenizes a stream of shader source, replacing the tokens and rewrites
+	 * of the last shader.
+	 * @param str The shader source. It must stay alive while the tokens are used.
+	 * @return false if the source is 4 GB or more, which token offsets can
+	 *  not hold. The context is then left with an empty source and no tokens.
+	 */
+	bool tokenize(std::string_view str);
+
+	/**
+	 * Starts a token list that the caller fills instead of tokenize(), for
+	 * example from a ShaderTokenFile. The tokens and rewrites of the last
+	 * shader are dropped.
+	 * @param str The shader source. It must stay alive while the tokens are used.
+	 * @return the empty token list. The tokens must cover the whole source.
+	 */
+	ShaderTokenList &resetTokens(std::string_view str);
+
+	/**
+	 * Reads the single token that starts at 'offset'. Tokenizing a source
+	 * from any token boundary gives the same tokens as tokenizing it whole.
+	 * @param str The shader source.
+	 * @param offset Where the token starts. Must be less than the length.
+	 * @return the token.
+	 * @note A token only depends on the characters from its start up to and
+	 *       including the first character after it.
+	 */
+	static ShaderToken readToken(std::string_view str, size_t offset);
+
+	/**
+	 * Get's the list of tokens from the tokenizer's job.
+	 * @return the list of tokens.
+	 * @note The tokens are spans into the source that was tokenized and are
+	 *       only valid while that string is alive.
+	 */
+	const ShaderTokenList &getTokens() const {
+		return mTokens;
+	}
+
+	/**
+	 * Get's the list of token rewrites, in token order.
+	 * @return the list of rewrites.
+	 */
+	const ShaderReplacementList &getReplacements() const {
+		return mReplacements;
+	}
+
+	/**
+	 * Get's the source that was last tokenized.
+	 * @return the source.
+	 */
+	std::string_view getSource() const {
+		return mSource;
+	}
+
+	/**
+	 * Get's the text of a token from the last tokenized source.
+	 * @param token The token to get the text of.
+	 * @return a view of the token's text inside of the source.
+	 */
+	std::string_view getTokenText(const ShaderToken &token) const {
+		return mSource.substr(token.offset, token.length);
+	}
+
+	/**
+	 * Get's the first character of the token after 'currentId'.
+	 * @param currentId The current token.
+	 * @return the first character of the next token, or 0 if there is none.
+	 */
+	inline char getNextCharacter(size_t currentId) const {
+		return ((currentId + 1) < mTokens.size()) ? mSource[mTokens[currentId + 1].offset] : '\0';
+	}
+
+	/**
+	 * Records that the token at 'currentId' will be replaced with 'text' when
+	 * the shader is emitted. Tokens must be replaced in order.
+	 * @param currentId The token that is being replaced.
+	 * @param text The replacement text. Must outlive the emit call.
+	 */
+	inline void replaceToken(size_t currentId, std::string_view text) {
+		mReplacements.push_back({ currentId, 1, text });
+	}
+
+	/**
+	 * Records that a range of tokens will be replaced with 'text' when the
+	 * shader is emitted.
+	 * @param first The first token that is being replaced.
+	 * @param count The number of tokens that are being replaced.
+	 * @param text The replacement text. Must outlive the emit call.
+	 */
+	inline void replaceTokens(size_t first, size_t count, std::string_view text) {
+		mReplacements.push_back({ first, count, text });
+	}
+
+	/**
+	 * Forgets the recorded rewrites but keeps the tokens, so that the same
+	 * tokens can be emitted again with different rewrites.
+	 */
+	inline void clearReplacements() {
+		mReplacements.clear();
+	}
+
+	/**
+	 * Builds the translated shader from the header, the token spans of the
+	 * source, and the recorded replacements.
+	 * @param header The text that is placed before the shader source.
+	 * @return the translated shader source, back in a string form.
+	 */
+	const std::string emit(std::string_view header) const;
+
+	/**
+	 * Builds the translated shader into a string owned by the caller. The
+	 * exact size is reserved up front, so a string that is reused for every
+	 * shader stops allocating once it has grown to fit the largest one.
+	 * @param header The text that is placed before the shader source.
+	 * @param shader Receives the translated shader source, replacing what
+	 *  it held before.
+	 */
+	void emit(std::string_view header, std::string &shader) const;
+
+	/**
+	 * Get's the statistics of the last shader translated with this context.
+	 * @return the statistics, all zero unless built with GLSL_TRANSLATOR_STATS.
+	 */
+	const ShaderTranslationStats &getStats() const {
+		return mStats;
+	}
+
+	ShaderTranslationStats &getStats() {
+		return mStats;
+	}
+
+	/**
+	 * Get's the preprocessor of this context, which is created the first
+	 * time it is needed.
+	 * @return the preprocessor.
+	 */
+	ShaderPreprocessor &getPreprocessor();
+
+	/**
+	 * Get's the minifier of this context, which is created the first time
+	 * it is needed.
+	 * @return the minifier.
+	 */
+	ShaderMinifier &getMinifier();
+
+	/**
+	 * Get's the reflection of the last shader translated with this context
+	 * by a translator that reflects, which is created the first time it is
+	 * needed.
+	 * @return the reflection.
+	 */
+	ShaderReflection &getReflection();
+
+private:
+	/**
+	 * The source that was last tokenized. The tokens are spans into it.
+	 */
+	std::string_view mSource;
+
+	/**
+	 * A vector of tokens represented as spans into the source.
+	 */
+	ShaderTokenList mTokens;
+
+	/**
+	 * A vector of token rewrites, in token order.
+	 */
+	ShaderReplacementList mReplacements;
+
+	/**
+	 * The statistics of the last translation.
+	 */
+	ShaderTranslationStats mStats = ShaderTranslationStats();
+
+	/**
+	 * The preprocessor, only created for translators that preprocess.
+	 */
+	std::unique_ptr<ShaderPreprocessor> mPreprocessor;
+
+	/**
+	 * The minifier, only created for translators that minify.
+	 */
+	std::unique_ptr<ShaderMinifier> mMinifier;
+
+	/**
+	 * The reflection, only created for translators that reflect.
+	 */
+	std::unique_ptr<ShaderReflection> mReflection;
+};
+
+#endif /* shaderTranslationContext_h */
\ No newline at end of file
@@ -28,34 +28,426 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //------------------------------------------------------------------------------
 
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include "shaderHash.h"
+#include "shaderMinifier.h"
+#include "shaderReflection.h"
+#include "shaderTokenFile.h"
 #include "shaderTranslator.h"
 
-void ShaderTranslator::tokenize(const std::string &str) {
-	// Clear out the tokens.
-	mTokens.clear();
-
-	size_t len = str.length();
-	size_t i = 0;
-	while (i < len) {
-		if (ispunct(str[i]) != 0 || !isWordcharacter(str[i]))
-			mTokens.push_back(str.substr(i, 1));
-		else {
-			// grab full word and push that as a token.
-			size_t l = 0;
-			size_t start = i;
-			while ((start + l) < len && isWordcharacter(str[start + l]))
-				l++;
-			
-			std::string tmp = str.substr(start, l);
-			mTokens.push_back(tmp);
-			
-			// Only add if we are greater than 0. If we are zero, we will just
-			// grab the increment below.
-			if (l > 0) {
-				i += l;
+static_assert(ShaderRewriteRule::FRAG_COLOR + 1 == SHADER_STATS_REWRITE_KINDS, "SHADER_STATS_REWRITE_KINDS is out of date.");
+static_assert(sizeof(ShaderTranslationStats) % sizeof(uint64_t) == 0, "ShaderTranslationStats must only hold 64 bit counters.");
+
+// The process wide statistics, one atomic per counter of ShaderTranslationStats.
+#define SHADER_STATS_COUNTERS (sizeof(ShaderTranslationStats) / sizeof(uint64_t))
+
+static std::atomic<uint64_t> sGlobalStats[SHADER_STATS_COUNTERS];
+static std::mutex sStatsCallbackMutex;
+static std::shared_ptr<const ShaderTranslator::StatsCallback> sStatsCallback;
+
+ShaderTranslationStats ShaderTranslator::getGlobalStats() {
+	uint64_t counters[SHADER_STATS_COUNTERS];
+	for (size_t i = 0; i < SHADER_STATS_COUNTERS; i++)
+		counters[i] = sGlobalStats[i].load(std::memory_order_relaxed);
+
+	ShaderTranslationStats stats;
+	memcpy(&stats, counters, sizeof(stats));
+	return stats;
+}
+
+void ShaderTranslator::resetGlobalStats() {
+	for (size_t i = 0; i < SHADER_STATS_COUNTERS; i++)
+		sGlobalStats[i].store(0, std::memory_order_relaxed);
+}
+
+void ShaderTranslator::setStatsCallback(StatsCallback callback) {
+	std::shared_ptr<const StatsCallback> ptr;
+	if (callback)
+		ptr = std::make_shared<const StatsCallback>(std::move(callback));
+
+	std::lock_guard<std::mutex> lock(sStatsCallbackMutex);
+	sStatsCallback = std::move(ptr);
+}
+
+#ifdef GLSL_TRANSLATOR_STATS
+/**
+ * Adds the statistics of one translation to the process wide statistics and
+ * hands them to the callback.
+ */
+static void publishStats(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType, const ShaderTranslationStats &stats) {
+	uint64_t counters[SHADER_STATS_COUNTERS];
+	memcpy(counters, &stats, sizeof(counters));
+	for (size_t i = 0; i < SHADER_STATS_COUNTERS; i++) {
+		if (counters[i])
+			sGlobalStats[i].fetch_add(counters[i], std::memory_order_relaxed);
+	}
+
+	std::shared_ptr<const ShaderTranslator::StatsCallback> callback;
+	{
+		std::lock_guard<std::mutex> lock(sStatsCallbackMutex);
+		callback = sStatsCallback;
+	}
+	if (callback)
+		(*callback)(translator, shaderType, stats);
+}
+#endif
+
+uint64_t ShaderTranslator::getConfigurationHash() const {
+	uint64_t hash = static_cast<uint64_t>(getBackend());
+
+	// Preprocessed output depends on the defines it was resolved against.
+	if (mPreprocess)
+		hash = shaderHashCombine(hash, mDefines.getHash());
+	if (mMinify)
+		hash = shaderHashCombine(hash, mMinifyNameMap ? 2 : 1);
+	if (mReflect)
+		hash = shaderHashCombine(hash, 3);
+	if (mExplicitLocations)
+		hash = shaderHashCombine(hash, 4);
+	return hash;
+}
+
+std::string_view ShaderTranslator::placeAttribute(ShaderReflectionVariable &variable, uint32_t &location) const {
+	if (variable.storage != ShaderReflectionVariable::ATTRIBUTE)
+		return std::string_view();
+
+	uint32_t count = variable.getLocationCount();
+	std::string_view qualifier = getAttributeQualifier(location);
+	if (qualifier.empty() || location + count > SHADER_MAX_ATTRIBUTE_LOCATIONS)
+		return std::string_view();
+
+	variable.location = static_cast<int32_t>(location);
+	location += count;
+	return qualifier;
+}
+
+const ShaderDefineSet &ShaderTranslator::getBuiltinDefines() const {
+	static const ShaderDefineSet defines;
+	return defines;
+}
+
+const std::string ShaderTranslator::translate(const std::string &str, ShaderType shaderType) const {
+	ShaderTranslationContext context;
+	return translate(context, str, shaderType);
+}
+
+const std::string ShaderTranslator::translate(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType) const {
+	std::string shader;
+	translateInto(context, str, shaderType, shader);
+	return shader;
+}
+
+void ShaderTranslator::translateInto(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType, std::string &shader) const {
+	SHADER_STATS(ShaderTranslationStats &stats = context.getStats());
+	SHADER_STATS(stats.clear());
+	SHADER_STATS(size_t tokenCapacity = context.getTokens().capacity());
+	SHADER_STATS(uint64_t time = ShaderTranslationStats::now());
+
+	// first tokenize
+	if (!context.tokenize(str)) {
+		shader.clear();
+		return;
+	}
+
+	SHADER_STATS(stats.tokenizeNs = ShaderTranslationStats::now() - time);
+	SHADER_STATS(stats.bufferGrowths = (context.getTokens().capacity() != tokenCapacity));
+
+	translateTokens(context, shaderType, shader);
+}
+
+void ShaderTranslator::translateTokens(ShaderTranslationContext &context, ShaderType shaderType, std::string &shader) const {
+	SHADER_STATS(ShaderTranslationStats &stats = context.getStats());
+	SHADER_STATS(size_t replacementCapacity = context.getReplacements().capacity());
+	SHADER_STATS(size_t shaderCapacity = shader.capacity());
+	SHADER_STATS(uint64_t tokenized = ShaderTranslationStats::now());
+	context.clearReplacements();
+
+	// Resolve the conditionals, which gives a list of token ranges to drop
+	// or change. They are applied in order along with the rewrites.
+	std::string_view header = getHeader(shaderType);
+	const ShaderReplacementList *edits = nullptr;
+	if (mPreprocess) {
+		ShaderPreprocessor &preprocessor = context.getPreprocessor();
+		preprocessor.run(context.getSource(), context.getTokens(), header, getBuiltinDefines(), mDefines);
+		header = preprocessor.getHeader();
+		edits = &preprocessor.getEdits();
+	}
+	size_t edit = 0;
+	size_t nextEdit = (edits && !edits->empty()) ? edits->front().token : SIZE_MAX;
+
+	// Declarations are reflected as their qualifiers come up, which is also
+	// when the attributes are given their locations.
+	ShaderReflection *reflection = nullptr;
+	if (mReflect || mExplicitLocations) {
+		reflection = &context.getReflection();
+		reflection->clear(shaderType);
+	}
+	uint32_t location = 0;
+
+	// Look up every identifier in the language's rewrite table.
+	const ShaderRewriteTable &table = getRewriteTable(shaderType);
+	const ShaderTokenList &tokens = context.getTokens();
+	size_t size = tokens.size();
+	for (size_t i = 0; i < size; i++) {
+		if (i == nextEdit) {
+			const ShaderReplacement &rep = (*edits)[edit++];
+			context.replaceTokens(rep.token, rep.count, rep.text);
+			i += rep.count - 1;
+			nextEdit = (edit < edits->size()) ? (*edits)[edit].token : SIZE_MAX;
+			continue;
+		}
+
+		SHADER_STATS(stats.tokens[tokens[i].kind]++);
+		if (tokens[i].kind != ShaderToken::IDENTIFIER)
+			continue;
+
+		const ShaderRewriteRule *rule = table.match(context.getTokenText(tokens[i]), context.getNextCharacter(i));
+		std::string_view replacement = rule ? rule->replacement : std::string_view();
+		if (reflection) {
+			size_t first = reflection->getVariableCount();
+			// A location covers a whole declaration, so attributes that are
+			// declared together are left to the linker.
+			if (reflection->readDeclaration(context, i) == 1 && shaderType == VERTEX) {
+				std::string_view qualifier = placeAttribute(reflection->getVariable(first), location);
+				if (!qualifier.empty())
+					replacement = qualifier;
+			}
+		}
+
+		if (!replacement.empty()) {
+			context.replaceToken(i, replacement);
+			SHADER_STATS(if (rule) stats.rewrites[rule->kind]++);
+		}
+	}
+	if (reflection)
+		reflectHeader(shaderType, *reflection);
+
+	SHADER_STATS(uint64_t rewritten = ShaderTranslationStats::now());
+	SHADER_STATS(stats.rewriteNs = rewritten - tokenized);
+
+	// create the shader and return it.
+	// first add our shader header.
+	context.emit(header, shader);
+	if (mMinify)
+		context.getMinifier().minify(shader, mMinifyNameMap);
+	if (mReflect)
+		reflection->write(shader);
+
+	SHADER_STATS(stats.emitNs = ShaderTranslationStats::now() - rewritten);
+	SHADER_STATS(stats.translations = 1);
+	SHADER_STATS(stats.bytesIn = context.getSource().length());
+	SHADER_STATS(stats.bytesOut = shader.length());
+	SHADER_STATS(stats.bufferGrowths += (context.getReplacements().capacity() != replacementCapacity) + (shader.capacity() != shaderCapacity));
+	SHADER_STATS(publishStats(*this, shaderType, stats));
+}
+
+/**
+ * Finds the rule that rewrites a tagged use of an identifier in a token file.
+ */
+static const ShaderRewriteRule *matchRewrite(const ShaderRewriteTable &table, std::string_view source, const ShaderTokenFile::Rewrite &rewrite) {
+	size_t end = rewrite.offset + rewrite.length;
+	return table.match(source.substr(rewrite.offset, rewrite.length), (end < source.length()) ? source[end] : '\0');
+}
+
+void ShaderTranslator::translateTokenFile(ShaderTranslationContext &context, const ShaderTokenFile &file, ShaderType shaderType, std::string &shader) const {
+	if (!canTranslateTokens()) {
+		translateInto(context, file.getSource(), shaderType, shader);
+		return;
+	}
+
+	SHADER_STATS(ShaderTranslationStats &stats = context.getStats());
+	SHADER_STATS(stats.clear());
+	SHADER_STATS(uint64_t time = ShaderTranslationStats::now());
+
+	const ShaderRewriteTable &table = getRewriteTable(shaderType);
+	if (needsTokenList() || !ShaderTokenFile::isTagged(table)) {
+		// These need every token, which the file has without scanning. A
+		// damaged token stream falls back to tokenizing the source.
+		SHADER_STATS(size_t tokenCapacity = context.getTokens().capacity());
+		if (!file.decodeTokens(context))
+			context.tokenize(file.getSource());
+		SHADER_STATS(stats.tokenizeNs = ShaderTranslationStats::now() - time);
+		SHADER_STATS(stats.bufferGrowths = (context.getTokens().capacity() != tokenCapacity));
+		translateTokens(context, shaderType, shader);
+		return;
+	}
+
+	SHADER_STATS(size_t shaderCapacity = shader.capacity());
+	std::string_view source = file.getSource();
+	std::string_view header = getHeader(shaderType);
+	ShaderTokenFile::Rewrite rewrite;
+
+	// Work out the exact size of the output so that it is allocated only once.
+	size_t size = header.length() + source.length();
+	ShaderTokenFile::RewriteCursor cursor;
+	while (file.nextRewrite(cursor, rewrite)) {
+		const ShaderRewriteRule *rule = matchRewrite(table, source, rewrite);
+		if (rule)
+			size = size + rule->replacement.length() - rule->keyword.length();
+	}
+
+	shader.clear();
+	shader.reserve(size);
+	shader.append(header);
+	size_t pos = 0;
+	cursor = ShaderTokenFile::RewriteCursor();
+	while (file.nextRewrite(cursor, rewrite)) {
+		const ShaderRewriteRule *rule = matchRewrite(table, source, rewrite);
+		if (!rule)
+			continue;
+
+		shader.append(source, pos, rewrite.offset - pos);
+		shader.append(rule->replacement);
+		pos = rewrite.offset + rule->keyword.length();
+		SHADER_STATS(stats.rewrites[rule->kind]++);
+	}
+	shader.append(source, pos, std::string_view::npos);
+
+	SHADER_STATS(stats.rewriteNs = ShaderTranslationStats::now() - time);
+	SHADER_STATS(stats.translations = 1);
+	SHADER_STATS(stats.bytesIn = source.length());
+	SHADER_STATS(stats.bytesOut = shader.length());
+	SHADER_STATS(stats.bufferGrowths = (shader.capacity() != shaderCapacity));
+	SHADER_STATS(publishStats(*this, shaderType, stats));
+}
+
+/**
+ * The most targets that translateAll() rewrites during one walk over the
+ * tokens. More targets take more walks.
+ */
+#define SHADER_MAX_PASS_TARGETS 8
+
+/**
+ * A target of translateAll() while the tokens are walked.
+ */
+struct ShaderPassTarget {
+	const ShaderTranslator::Target *target;
+	const ShaderRewriteTable *table;
+
+	/**
+	 * How much of the source has been written to the output.
+	 */
+	size_t pos;
+
+#ifdef GLSL_TRANSLATOR_STATS
+	uint64_t rewrites[SHADER_STATS_REWRITE_KINDS];
+	size_t capacity;
+#endif
+};
+
+/**
+ * Rewrites the tokens in the context for several targets during one walk.
+ * Instead of recording replacements, each output is written as the walk
+ * goes: the source up to a rewritten token, then its replacement.
+ */
+static void rewriteTogether(ShaderTranslationContext &context, ShaderPassTarget *targets, size_t count) {
+	std::string_view source = context.getSource();
+	for (size_t t = 0; t < count; t++) {
+		const ShaderTranslator::Target &target = *targets[t].target;
+		std::string_view header = target.translator->getHeader(target.shaderType);
+		target.output->clear();
+		target.output->reserve(header.length() + source.length());
+		target.output->append(header);
+	}
+
+	const ShaderTokenList &tokens = context.getTokens();
+	size_t size = tokens.size();
+	for (size_t i = 0; i < size; i++) {
+		const ShaderToken &token = tokens[i];
+		if (token.kind != ShaderToken::IDENTIFIER)
+			continue;
+
+		std::string_view text = context.getTokenText(token);
+		char next = context.getNextCharacter(i);
+		for (size_t t = 0; t < count; t++) {
+			const ShaderRewriteRule *rule = targets[t].table->match(text, next);
+			if (!rule)
 				continue;
+
+			std::string &output = *targets[t].target->output;
+			output.append(source.substr(targets[t].pos, token.offset - targets[t].pos));
+			output.append(rule->replacement);
+			targets[t].pos = token.offset + token.length;
+			SHADER_STATS(targets[t].rewrites[rule->kind]++);
+		}
+	}
+
+	for (size_t t = 0; t < count; t++)
+		targets[t].target->output->append(source.substr(targets[t].pos));
+}
+
+void ShaderTranslator::translateAll(ShaderTranslationContext &context, std::string_view str, const std::vector<Target> &targets) {
+	SHADER_STATS(ShaderTranslationStats &stats = context.getStats());
+	SHADER_STATS(size_t tokenCapacity = context.getTokens().capacity());
+	SHADER_STATS(uint64_t time = ShaderTranslationStats::now());
+
+	if (!context.tokenize(str)) {
+		for (const Target &target : targets)
+			target.output->clear();
+		return;
+	}
+
+	// The time and buffer growths of tokenizing go to the first target only,
+	// so that the process wide statistics add up.
+	SHADER_STATS(uint64_t tokenizeNs = ShaderTranslationStats::now() - time);
+	SHADER_STATS(uint64_t tokenGrowths = (context.getTokens().capacity() != tokenCapacity));
+
+	// Targets that preprocess resolve the conditionals against their own
+	// defines, targets that minify rework their output afterwards, and
+	// targets that reflect read the declarations, so each of them takes its
+	// own walk over the tokens. Targets such as cached translators go
+	// through their own translateInto(), which tokenizes the same source
+	// again if it needs to and so leaves the same tokens behind.
+	ShaderPassTarget pass[SHADER_MAX_PASS_TARGETS];
+	size_t count = 0;
+	for (size_t i = 0; i < targets.size(); i++) {
+		const Target &target = targets[i];
+		if (!target.translator->canTranslateTokens()) {
+			target.translator->translateInto(context, str, target.shaderType, *target.output);
+		} else if (target.translator->needsTokenList()) {
+			SHADER_STATS(stats.clear());
+			SHADER_STATS(stats.tokenizeNs = tokenizeNs);
+			SHADER_STATS(stats.bufferGrowths = tokenGrowths);
+			SHADER_STATS(tokenizeNs = tokenGrowths = 0);
+			target.translator->translateTokens(context, target.shaderType, *target.output);
+		} else {
+			pass[count] = ShaderPassTarget();
+			pass[count].target = &target;
+			pass[count].table = &target.translator->getRewriteTable(target.shaderType);
+			SHADER_STATS(pass[count].capacity = target.output->capacity());
+			count++;
+		}
+
+		if (count == SHADER_MAX_PASS_TARGETS || (count && i + 1 == targets.size())) {
+			SHADER_STATS(uint64_t start = ShaderTranslationStats::now());
+			rewriteTogether(context, pass, count);
+
+#ifdef GLSL_TRANSLATOR_STATS
+			// Every target of the walk is published as its own translation,
+			// with an even share of the time the walk took.
+			uint64_t kinds[SHADER_STATS_TOKEN_KINDS] = {};
+			for (const ShaderToken &token : context.getTokens())
+				kinds[token.kind]++;
+			uint64_t share = (ShaderTranslationStats::now() - start) / count;
+			for (size_t t = 0; t < count; t++) {
+				const Target &done = *pass[t].target;
+				stats.clear();
+				stats.translations = 1;
+				stats.tokenizeNs = tokenizeNs;
+				stats.rewriteNs = share;
+				stats.bytesIn = str.length();
+				stats.bytesOut = done.output->length();
+				memcpy(stats.tokens, kinds, sizeof(kinds));
+				memcpy(stats.rewrites, pass[t].rewrites, sizeof(pass[t].rewrites));
+				stats.bufferGrowths = tokenGrowths + (done.output->capacity() != pass[t].capacity);
+				tokenizeNs = tokenGrowths = 0;
+				publishStats(*done.translator, done.shaderType, stats);
 			}
+#endif
+			count = 0;
 		}
-		i++;
 	}
 }
\ No newline at end of file
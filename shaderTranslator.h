@@ -31,15 +31,44 @@
 #ifndef shaderTranslator_h
 #define shaderTranslator_h
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "shaderPreprocessor.h"
+#include "shaderRewriteRules.h"
+#include "shaderScanner.h"
+#include "shaderTranslationContext.h"
 
-typedef std::vector<std::string> ShaderTokenList;
+/**
+ * The version of the rewrite rules. Bump this whenever a change to the rules
+ * changes the output for the same input, so that translations cached on disk
+ * by an older version of the library are thrown away.
+ */
+#define SHADER_TRANSLATOR_RULES_VERSION 2
+
+/**
+ * The number of values in ShaderTranslator::ShaderBackend.
+ */
+#define SHADER_BACKEND_COUNT 2
+
+/**
+ * The number of vertex attribute locations the translator places attributes
+ * at, which is the GL_MAX_VERTEX_ATTRIBS every GL 3.3 driver has to support.
+ */
+#define SHADER_MAX_ATTRIBUTE_LOCATIONS 16
+
+class ShaderReflection;
+struct ShaderReflectionVariable;
+class ShaderTokenFile;
 
 /**
  * A class that translates OpenGL GLSL 120 shaders other high level
  * shading languages. Currently only GLSL 120 and GLSL 330 are supported.
+ * Translators keep no state between calls, so a single translator can be used
+ * for every shader, even from several threads at once.
  * Example usage of the library:
  *
  * std::string vertex   = "void main() {\n gl_Position = vec4(1);\n}";
@@ -47,14 +76,14 @@ typedef std::vector<std::string> ShaderTokenList;
  * printf("%s\n", vertex.c_str());
  * printf("%s\n", fragment.c_str());
  *
+ * ShaderTranslatorGL33 translator;
+ *
  * // Tokenize and translate the Vertex Shader.
- * auto vertexTranslator = new ShaderTranslatorGL33();
- * const auto &shader = vertexTranslator->translate(vertex, ShaderTranslator::VERTEX);
+ * auto shader = translator.translate(vertex, ShaderTranslator::VERTEX);
  * printf("%s\n", shader.c_str());
  *
  * // Now tokenize and translate the Fragment Shader.
- * auto = fragmentTranslator = new ShaderTranslatorGL33();
- * shader = fragmentTranslator->translate(fragment, ShaderTranslator::FRAGMENT);
+ * shader = translator.translate(fragment, ShaderTranslator::FRAGMENT);
  * printf("%s\n", shader.c_str());
  */
 class ShaderTranslator {
@@ -70,6 +99,24 @@ public:
 		VERTEX,
 		FRAGMENT
 	};
+
+	/**
+	 * Enum of the shading languages that shaders can be translated to.
+	 */
+	enum ShaderBackend {
+		GL21,
+		GL33
+	};
+
+	/**
+	 * One output of translateAll(): a translator, the type of shader to
+	 * translate the source as, and the string that receives the result.
+	 */
+	struct Target {
+		const ShaderTranslator *translator;
+		ShaderType shaderType;
+		std::string *output;
+	};
 	
 	/**
 	 * Translates the shader in it's tokenized list form from GLSL 120 to GLSL
@@ -80,21 +127,297 @@ public:
 	 *  vertex shader or a fragment (pixel) shader.
 	 * @return the translated shader source, back in a string form.
 	 */
-	virtual const std::string translate(const std::string &str, ShaderType shaderType) = 0;
+	const std::string translate(const std::string &str, ShaderType shaderType) const;
+
+	/**
+	 * Translates the shader using a context supplied by the caller. Reusing
+	 * one context per thread avoids allocating new token lists for every shader.
+	 * @param context The context that holds the tokens of this translation.
+	 * @param str The stream of shader source to be tokenized and translated.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 * @return the translated shader source, back in a string form.
+	 */
+	const std::string translate(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType) const;
+
+	/**
+	 * Translates the shader into a string owned by the caller. Reusing one
+	 * context and one output string for a stream of shaders means nothing is
+	 * allocated once they have grown to fit the largest shader.
+	 * @param context The context that holds the tokens of this translation.
+	 * @param str The stream of shader source to be tokenized and translated.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 * @param shader Receives the translated shader source, replacing what
+	 *  it held before. Sources of 4 GB or more leave it empty.
+	 */
+	virtual void translateInto(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType, std::string &shader) const;
 
 	/**
-	 * Get's the list of tokens from the tokenizer's job.
-	 * @return the list of tokens.
+	 * Translates a shader for several targets at once. The source is
+	 * tokenized once, and the targets that do not need the whole token list
+	 * are all rewritten and written out during a single walk over the tokens, so
+	 * adding a backend costs a rewrite table lookup per identifier instead
+	 * of another full translation.
+	 * @param context The context that holds the tokens of this translation.
+	 * @param str The stream of shader source to be tokenized and translated.
+	 * @param targets The translators, shader types and output strings.
+	 * @note Targets whose translator cannot translate tokens read elsewhere,
+	 *       such as ShaderTranslatorCached, are translated with their own
+	 *       translateInto() instead. Sources of 4 GB or more leave every
+	 *       output empty.
 	 */
-	const ShaderTokenList getTokens() const {
-		return mTokens;
+	static void translateAll(ShaderTranslationContext &context, std::string_view str, const std::vector<Target> &targets);
+
+	/**
+	 * Translates a shader that was tokenized ahead of time. Only the uses
+	 * of identifiers the file tagged as rewritable are looked at, and the
+	 * source between them is copied straight across. Translators that
+	 * need the whole token list, or have rules for identifiers the file does not
+	 * tag, translate the file's decoded tokens the usual way instead.
+	 * @param context The context that holds the tokens of this translation.
+	 * @param file The token file, which must be loaded.
+	 * @param shaderType The type of shader the file holds.
+	 * @param shader Receives the translated shader source, replacing what
+	 *  it held before.
+	 * @note Translators that can not translate tokens read elsewhere, such
+	 *       as ShaderTranslatorCached, translate the file's source with
+	 *       translateInto() instead.
+	 */
+	void translateTokenFile(ShaderTranslationContext &context, const ShaderTokenFile &file, ShaderType shaderType, std::string &shader) const;
+
+	/**
+	 * Called after every translation with the statistics of that shader.
+	 * Statistics are only collected when built with GLSL_TRANSLATOR_STATS.
+	 */
+	typedef std::function<void(const ShaderTranslator &translator, ShaderType shaderType, const ShaderTranslationStats &stats)> StatsCallback;
+
+	/**
+	 * Get's the statistics of every translation in the process so far.
+	 * @return the sum of the statistics of every translation.
+	 */
+	static ShaderTranslationStats getGlobalStats();
+
+	/**
+	 * Resets the process wide statistics to zero.
+	 */
+	static void resetGlobalStats();
+
+	/**
+	 * Sets the function that is called with the statistics of every
+	 * translation, for example to forward them to telemetry. The callback is
+	 * called on the thread that translated the shader.
+	 * @param callback The callback, or an empty function to remove it.
+	 */
+	static void setStatsCallback(StatsCallback callback);
+
+	/**
+	 * Get's the shading language this translator translates to.
+	 * @return the backend of the translator.
+	 */
+	virtual ShaderBackend getBackend() const = 0;
+
+	/**
+	 * Get's a hash of everything about this translator that changes its
+	 * output, which is the backend and any options. Two translators with the
+	 * same hash produce the same output for the same source.
+	 * @return the configuration hash.
+	 */
+	virtual uint64_t getConfigurationHash() const;
+
+	/**
+	 * Turns the preprocessing pass on or off. When it is on, #ifdef, #ifndef,
+	 * #if, #elif and #else blocks are resolved against the backend's defines
+	 * and the defines given to define() and undefine(), and branches that can
+	 * never be compiled are dropped from the output. Options must be set
+	 * before the translator is shared between threads.
+	 * @param enabled true to preprocess shaders.
+	 * @note ShaderStreamTranslator does not preprocess.
+	 */
+	void setPreprocessing(bool enabled) {
+		mPreprocess = enabled;
 	}
-	
-protected:
+
+	virtual bool isPreprocessing() const {
+		return mPreprocess;
+	}
+
+	/**
+	 * Turns minification of the output on or off. Minified shaders have no
+	 * comments, next to no whitespace, and short names for local variables,
+	 * parameters and functions, while uniforms, attributes, varyings and
+	 * GEN_OUTPUT_FINAL_COLOR keep theirs. See ShaderMinifier.
+	 * @param enabled true to minify shaders.
+	 * @param nameMap true to append the map of short names to original names
+	 *  to every shader as comments, for debugging.
+	 * @note ShaderStreamTranslator does not minify.
+	 */
+	void setMinify(bool enabled, bool nameMap = false) {
+		mMinify = enabled;
+		mMinifyNameMap = enabled && nameMap;
+	}
+
+	virtual bool isMinifying() const {
+		return mMinify;
+	}
+
+	virtual bool isMinifyNameMap() const {
+		return mMinifyNameMap;
+	}
+
 	/**
-	 * Tokenizes a stream of shader source.
+	 * Turns reflection on or off. When it is on, the attributes, varyings
+	 * and uniforms of every shader are read while its tokens are rewritten,
+	 * along with the outputs the backend declares, and the result is left in
+	 * ShaderTranslationContext::getReflection() and written to the end of
+	 * the shader as comments, so that it is cached along with it. See
+	 * ShaderReflection.
+	 * @param enabled true to reflect shaders.
+	 * @note Without preprocessing, the declarations of every #if branch are
+	 *       reflected. ShaderStreamTranslator and ShaderVariantTranslator
+	 *       do not reflect.
 	 */
-	void tokenize(const std::string &str);
+	void setReflection(bool enabled) {
+		mReflect = enabled;
+	}
+
+	virtual bool isReflecting() const {
+		return mReflect;
+	}
+
+	/**
+	 * Turns explicit locations on or off. When they are on, backends with
+	 * layout qualifiers place every vertex attribute at the next free
+	 * location, in the order they are declared, and the fragment output at
+	 * location 0, so that the application can bind them without querying
+	 * the linked program. Attributes declared together in one list, and
+	 * attributes past SHADER_MAX_ATTRIBUTE_LOCATIONS, are left to the linker.
+	 * GLSL 120 has no layout qualifiers, so GL21 ignores this.
+	 * @param enabled true to place inputs and outputs at explicit locations.
+	 * @note ShaderStreamTranslator and ShaderVariantTranslator only place
+	 *       the fragment output.
+	 */
+	void setExplicitLocations(bool enabled) {
+		mExplicitLocations = enabled;
+	}
+
+	virtual bool isExplicitLocations() const {
+		return mExplicitLocations;
+	}
+
+	/**
+	 * Determines if translations need the whole token list, rather than just
+	 * the rewrite of each identifier on its own, which is the case when they
+	 * are preprocessed, minified, reflected or given explicit locations.
+	 * @return true if the translator needs the whole token list.
+	 */
+	bool needsTokenList() const {
+		return isPreprocessing() || isMinifying() || isReflecting() || isExplicitLocations();
+	}
+
+	/**
+	 * Determines if translateAll() and translateTokenFile() may translate
+	 * for this translator from tokens that were read elsewhere. Translators
+	 * that do more than translate in translateInto(), such as
+	 * ShaderTranslatorCached, return false and are always called through it.
+	 * @return true if the translator can translate tokens read elsewhere.
+	 */
+	virtual bool canTranslateTokens() const {
+		return true;
+	}
+
+	/**
+	 * Defines a macro for the preprocessing pass. It is added to the output
+	 * header if the shader still refers to it after preprocessing.
+	 * @param name The name of the macro.
+	 * @param value The value of the macro, which may be empty.
+	 */
+	void define(std::string_view name, std::string_view value = std::string_view()) {
+		mDefines.define(name, value);
+	}
+
+	/**
+	 * Marks a macro as undefined for the preprocessing pass, so that blocks
+	 * that depend on it can be resolved.
+	 * @param name The name of the macro.
+	 */
+	void undefine(std::string_view name) {
+		mDefines.undefine(name);
+	}
+
+	/**
+	 * Get's the macros given to define() and undefine().
+	 * @return the set of macros.
+	 */
+	virtual const ShaderDefineSet &getDefines() const {
+		return mDefines;
+	}
+
+	/**
+	 * Get's the macros the language itself defines, or is known not to.
+	 * @return the set of macros.
+	 */
+	virtual const ShaderDefineSet &getBuiltinDefines() const;
+
+	/**
+	 * Get's the text that is placed in front of every translated shader, such
+	 * as the version number and the language define.
+	 * @param shaderType The type of shader the header is for.
+	 * @return the header text.
+	 */
+	virtual std::string_view getHeader(ShaderType shaderType) const = 0;
+
+	/**
+	 * Get's the rewrite rules of this language for a type of shader.
+	 * @param shaderType The type of shader.
+	 * @return the table of rewrite rules.
+	 */
+	virtual const ShaderRewriteTable &getRewriteTable(ShaderType shaderType) const {
+		return SHADER_EMPTY_REWRITE_TABLE;
+	}
+
+	/**
+	 * Decides how a single identifier token is rewritten for this language.
+	 * The rules only ever need one character of lookahead, which is what lets
+	 * the same rules run over a token list or over a stream of source.
+	 * @param shaderType The type of shader the token belongs to.
+	 * @param token The text of the identifier token.
+	 * @param next The first character of the token that follows, or 0 if the
+	 *  identifier is the last token of the shader.
+	 * @return the replacement text, or an empty view if the token is kept.
+	 */
+	std::string_view rewriteToken(ShaderType shaderType, std::string_view token, char next) const {
+		return getRewriteTable(shaderType).rewrite(token, next);
+	}
+
+	/**
+	 * Get's the text that replaces the attribute qualifier of a vertex
+	 * attribute that is placed at an explicit location.
+	 * @param location The location, less than SHADER_MAX_ATTRIBUTE_LOCATIONS.
+	 * @return the replacement text, or an empty view if the language has no
+	 *  explicit locations or they are off.
+	 */
+	virtual std::string_view getAttributeQualifier(uint32_t location) const {
+		return std::string_view();
+	}
+
+	/**
+	 * Places a vertex attribute at the next free location, when the language
+	 * has explicit locations and they are on.
+	 * @param variable The attribute. Its location is set if it is placed.
+	 * @param location The next free location, which is moved past the
+	 *  locations the attribute takes up.
+	 * @return the text that replaces the attribute qualifier, or an empty
+	 *  view if the attribute is left to the linker.
+	 */
+	std::string_view placeAttribute(ShaderReflectionVariable &variable, uint32_t &location) const;
+
+	/**
+	 * Adds the variables the header declares to a reflection, such as the
+	 * output that replaces gl_FragColor.
+	 * @param shaderType The type of shader the header is for.
+	 * @param reflection The reflection of the shader.
+	 */
+	virtual void reflectHeader(ShaderType shaderType, ShaderReflection &reflection) const {
+	}
 
 	/**
 	 * Determines if character 'x' is a word character and is not a space.
@@ -102,27 +425,51 @@ protected:
 	 * @return true if 'x' is a word character and is not a space, false otherwise.
 	 */
 	static inline bool isWordcharacter(char x) {
-		return (!isspace(x) && iswalnum(x)) || x == '_';
+		return SHADER_CHAR_TABLE.is(x, SHADER_CHAR_WORD);
 	}
 
 	/**
-	 * Determines if the token at 'currentId' is calling the fuction or function
-	 * pattern.
-	 * @param fn The function or pattern we are checking at the token currentId.
-	 * @param tokens The vector containing the token list.
-	 * @param currentId The current token we are checking.
-	 * @return true if we are calling a function of pattern 'fn', false otherwise.
-	 * @note A function call grammar we are checking is defined as the following:
-	 *       'fn_pattern' '('
+	 * Determines if 'token' is calling the fuction 'fn'.
+	 * @param fn The function we are checking.
+	 * @param token The text of the token we are checking.
+	 * @param next The first character of the token that follows 'token'.
+	 * @return true if we are calling the function 'fn', false otherwise.
 	 */
-	inline bool isFunctionCallAtPos(const std::string &fn, size_t currentId) {
-		return (mTokens[currentId].find(fn) != std::string::npos) && ((currentId + 1) < mTokens.size()) && (mTokens[currentId + 1] == "(");
+	static inline bool isFunctionCall(std::string_view fn, std::string_view token, char next) {
+		return (token == fn) && (next == '(');
 	}
 
+protected:
+	/**
+	 * Translates the tokens that are in the context, after tokenize().
+	 * @param context The context that holds the tokens of this translation.
+	 * @param shaderType The type of shader stream that is being parsed.
+	 * @param shader Receives the translated shader source.
+	 */
+	void translateTokens(ShaderTranslationContext &context, ShaderType shaderType, std::string &shader) const;
+
+	/**
+	 * Set if the preprocessing pass is on.
+	 */
+	bool mPreprocess = false;
+
+	/**
+	 * Set if the output is minified, and if the name map is appended to it.
+	 */
+	bool mMinify = false;
+	bool mMinifyNameMap = false;
+
+	/**
+	 * Set if shaders are reflected, and if inputs and outputs are placed at
+	 * explicit locations.
+	 */
+	bool mReflect = false;
+	bool mExplicitLocations = false;
+
 	/**
-	 * A vector of tokens represented as strings.
+	 * The macros of the caller for the preprocessing pass.
 	 */
-	ShaderTokenList mTokens;
+	ShaderDefineSet mDefines;
 };
 
 #endif /* shaderTranslator_h */
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderTranslatorCached.h"
+
+ShaderTranslatorCached::ShaderTranslatorCached(const ShaderTranslator &translator, ShaderDiskCache &cache) :
+	mTranslator(translator),
+	mCache(cache) {
+}
+
+void ShaderTranslatorCached::translateInto(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType, std::string &shader) const {
+	ShaderDiskCache::Key key = ShaderTranslationCache::makeKey(mTranslator, str, shaderType);
+	std::string_view cached;
+	if (mCache.find(key, cached)) {
+		shader.assign(cached);
+		return;
+	}
+
+	mTranslator.translateInto(context, str, shaderType, shader);
+	mCache.store(key, shader);
+}
+
+ShaderTranslator::ShaderBackend ShaderTranslatorCached::getBackend() const {
+	return mTranslator.getBackend();
+}
+
+uint64_t ShaderTranslatorCached::getConfigurationHash() const {
+	return mTranslator.getConfigurationHash();
+}
+
+std::string_view ShaderTranslatorCached::getHeader(ShaderType shaderType) const {
+	return mTranslator.getHeader(shaderType);
+}
+
+const ShaderRewriteTable &ShaderTranslatorCached::getRewriteTable(ShaderType shaderType) const {
+	return mTranslator.getRewriteTable(shaderType);
+}
+
+const ShaderDefineSet &ShaderTranslatorCached::getBuiltinDefines() const {
+	return mTranslator.getBuiltinDefines();
+}
+
+std::string_view ShaderTranslatorCached::getAttributeQualifier(uint32_t location) const {
+	return mTranslator.getAttributeQualifier(location);
+}
+
+void ShaderTranslatorCached::reflectHeader(ShaderType shaderType, ShaderReflection &reflection) const {
+	mTranslator.reflectHeader(shaderType, reflection);
+}
+
+bool ShaderTranslatorCached::isPreprocessing() const {
+	return mTranslator.isPreprocessing();
+}
+
+bool ShaderTranslatorCached::isMinifying() const {
+	return mTranslator.isMinifying();
+}
+
+bool ShaderTranslatorCached::isMinifyNameMap() const {
+	return mTranslator.isMinifyNameMap();
+}
+
+bool ShaderTranslatorCached::isReflecting() const {
+	return mTranslator.isReflecting();
+}
+
+bool ShaderTranslatorCached::isExplicitLocations() const {
+	return mTranslator.isExplicitLocations();
+}
+
+const ShaderDefineSet &ShaderTranslatorCached::getDefines() const {
+	return mTranslator.getDefines();
+}
+
+bool ShaderTranslatorCached::canTranslateTokens() const {
+	return false;
+}
\ No newline at end of file
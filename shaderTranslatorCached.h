@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderTranslatorCached_h
+#define shaderTranslatorCached_h
+
+#include "shaderDiskCache.h"
+#include "shaderTranslator.h"
+
+/**
+ * A translator that serves translations out of a persistent disk cache, and
+ * only asks the translator it wraps when a shader is not in the cache yet.
+ * Because it is a ShaderTranslator itself, code that translates shaders does
+ * not need to know that a cache is in use.
+ * Example usage:
+ *
+ * ShaderDiskCache cache;
+ * cache.open(ShaderDiskCache::getDefaultPath());
+ *
+ * ShaderTranslatorGL33 gl33;
+ * ShaderTranslatorCached translator(gl33, cache);
+ * auto shader = translator.translate(source, ShaderTranslator::VERTEX);
+ */
+class ShaderTranslatorCached : public ShaderTranslator {
+public:
+	/**
+	 * Creates a cached translator.
+	 * @param translator The translator used on a cache miss.
+	 * @param cache The cache to use. Both must outlive the cached translator.
+	 */
+	ShaderTranslatorCached(const ShaderTranslator &translator, ShaderDiskCache &cache);
+
+	/**
+	 * Translates the shader, or returns it from the cache.
+	 * @param context The context used when the shader has to be translated.
+	 * @param str The stream of shader source to be translated.
+	 * @param shaderType The type of shader stream that is being parsed, such as a
+	 *  vertex shader or a fragment (pixel) shader.
+	 * @param shader Receives the translated shader source.
+	 * @note On a cache hit nothing is tokenized, so the context is left empty.
+	 */
+	virtual void translateInto(ShaderTranslationContext &context, std::string_view str, ShaderType shaderType, std::string &shader) const override;
+
+	virtual ShaderBackend getBackend() const override;
+	virtual uint64_t getConfigurationHash() const override;
+	virtual std::string_view getHeader(ShaderType shaderType) const override;
+	virtual const ShaderRewriteTable &getRewriteTable(ShaderType shaderType) const override;
+	virtual const ShaderDefineSet &getBuiltinDefines() const override;
+	virtual std::string_view getAttributeQualifier(uint32_t location) const override;
+	virtual void reflectHeader(ShaderType shaderType, ShaderReflection &reflection) const override;
+
+	/**
+	 * The options are those of the wrapped translator. Setting them on the
+	 * cached translator itself has no effect.
+	 */
+	virtual bool isPreprocessing() const override;
+	virtual bool isMinifying() const override;
+	virtual bool isMinifyNameMap() const override;
+	virtual bool isReflecting() const override;
+	virtual bool isExplicitLocations() const override;
+	virtual const ShaderDefineSet &getDefines() const override;
+
+	/**
+	 * Cached shaders are only found through translateInto().
+	 * @return false.
+	 */
+	virtual bool canTranslateTokens() const override;
+
+protected:
+	const ShaderTranslator &mTranslator;
+	ShaderDiskCache &mCache;
+};
+
+#endif /* shaderTranslatorCached_h */
\ No newline at end of file
@@ -30,12 +30,19 @@
 
 #include "shaderTranslatorGL21.h"
 
-const std::string SHADER_GL21_HEADER = "#version 120\n#define GL21\n\n";
+std::string_view ShaderTranslatorGL21::getHeader(ShaderType shaderType) const {
+	return SHADER_GL21_HEADER;
+}
 
-const std::string ShaderTranslatorGL21::translate(const std::string &str, ShaderType shaderType) {
-	// We do this just so we can use the token API. I know its silly,
-	// but what if we want to debug it!
-	tokenize(str);
+static ShaderDefineSet createBuiltinDefines() {
+	ShaderDefineSet defines;
+	defines.define("GL21");
+	defines.undefine("GL33");
+	defines.define("__VERSION__", "120");
+	return defines;
+}
 
-	return SHADER_GL21_HEADER + str;
+const ShaderDefineSet &ShaderTranslatorGL21::getBuiltinDefines() const {
+	static const ShaderDefineSet defines = createBuiltinDefines();
+	return defines;
 }
\ No newline at end of file
@@ -38,13 +38,26 @@ public:
 	ShaderTranslatorGL21() {}
 
 	/**
-	 * Translates the shader in it's tokenized list form from the base to GLSL 120.
-	 * @param str The stream of shader source to be tokenized and translated..
-	 * @param shaderType The type of shader stream that is being parsed, such as a
-	 *  vertex shader or a fragment (pixel) shader.
-	 * @return the translated shader source, back in a string form.
+	 * Get's the shading language this translator translates to.
+	 * @return ShaderBackend::GL21
 	 */
-	virtual const std::string translate(const std::string &str, ShaderType shaderType) override;
+	virtual ShaderBackend getBackend() const override {
+		return ShaderBackend::GL21;
+	}
+
+	/**
+	 * Get's the header for GLSL 120. The base shader is already GLSL 120, so
+	 * translating to it only adds the version number and language define.
+	 * @param shaderType The type of shader the header is for.
+	 * @return the header text.
+	 */
+	virtual std::string_view getHeader(ShaderType shaderType) const override;
+
+	/**
+	 * Get's the macros GLSL 120 defines, which are the macros of its header.
+	 * @return the set of macros.
+	 */
+	virtual const ShaderDefineSet &getBuiltinDefines() const override;
 };
 
 #endif /* shaderTranslatorGL21_h */
\ No newline at end of file
@@ -28,80 +28,53 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //------------------------------------------------------------------------------
 
+#include "shaderReflection.h"
 #include "shaderTranslatorGL33.h"
 
-#define FRAG_OUTPUT "GEN_OUTPUT_FINAL_COLOR"
+/**
+ * What the attribute qualifier becomes at every location.
+ */
+static const std::string_view ATTRIBUTE_QUALIFIERS[SHADER_MAX_ATTRIBUTE_LOCATIONS] = {
+	"layout(location = 0) in", "layout(location = 1) in", "layout(location = 2) in", "layout(location = 3) in",
+	"layout(location = 4) in", "layout(location = 5) in", "layout(location = 6) in", "layout(location = 7) in",
+	"layout(location = 8) in", "layout(location = 9) in", "layout(location = 10) in", "layout(location = 11) in",
+	"layout(location = 12) in", "layout(location = 13) in", "layout(location = 14) in", "layout(location = 15) in"
+};
 
-const std::string SHADER_GL33_VERTEX_HEADER = "#version 330 core\n#define GL33\n\n";
-const std::string SHADER_GL33_FRAGMENT_HEADER = "#version 330 core\n#define GL33\n\nout vec4 " + std::string(FRAG_OUTPUT) + ";\n\n";
-
-const std::string ShaderTranslatorGL33::translate(const std::string &str, ShaderType shaderType) {
-	// first tokenize
-	tokenize(str);
-
-	std::string shader = "";
-	if (shaderType == ShaderType::VERTEX)
-		shader = translateVertexShader(str);
-	else if (shaderType == ShaderType::FRAGMENT)
-		shader = translateFragmentShader(str);
-	return shader;
+std::string_view ShaderTranslatorGL33::getHeader(ShaderType shaderType) const {
+	if (shaderType == ShaderType::FRAGMENT)
+		return mExplicitLocations ? SHADER_GL33_FRAGMENT_LOCATION_HEADER : SHADER_GL33_FRAGMENT_HEADER;
+	return SHADER_GL33_VERTEX_HEADER;
 }
 
-const std::string ShaderTranslatorGL33::translateVertexShader(const std::string &str) {
-	size_t size = mTokens.size();
-	for (size_t i = 0; i < size; i++) {
-		if (mTokens[i] == "attribute") {
-			// check for the attribute keyword. in GLSL core profile, it is changed
-			// to the in keyword.
-			mTokens[i] = "in";
-		} else if (mTokens[i] == "varying") {
-			// In vertex shaders, varying turns to out.
-			// in fragment shaders, varying turns to in.
-			mTokens[i] = "out";
-		} else if (isFunctionCallAtPos("texture", i)) {
-			// texture2D, textureCube, texture2DLod, ect is handled here. Basically
-			// this case handles texture functions
-			// In GLSL core profile, texture() is overloaded.
-			mTokens[i] = "texture";
-		}
-	}
+const ShaderRewriteTable &ShaderTranslatorGL33::getRewriteTable(ShaderType shaderType) const {
+	// The rules themselves live in shaderRewriteRules.h.
+	if (shaderType == ShaderType::FRAGMENT)
+		return SHADER_GL33_FRAGMENT_TABLE;
+	return SHADER_GL33_VERTEX_TABLE;
+}
 
-	// create the shader and return it.
-	// first add our shader header.
-	std::string shader = SHADER_GL33_VERTEX_HEADER;
-	for (const auto &tok : mTokens) {
-		shader += tok.c_str();
-	}
-	return shader;
+std::string_view ShaderTranslatorGL33::getAttributeQualifier(uint32_t location) const {
+	if (!mExplicitLocations || location >= SHADER_MAX_ATTRIBUTE_LOCATIONS)
+		return std::string_view();
+	return ATTRIBUTE_QUALIFIERS[location];
 }
 
-const std::string ShaderTranslatorGL33::translateFragmentShader(const std::string &str) {
-	size_t size = mTokens.size();
-	for (size_t i = 0; i < size; i++) {
-		if (mTokens[i].find("gl_") != std::string::npos) {
-			// Handle built in variables for GLSL here in fragment shaders.
+void ShaderTranslatorGL33::reflectHeader(ShaderType shaderType, ShaderReflection &reflection) const {
+	if (shaderType == ShaderType::FRAGMENT)
+		reflection.add(ShaderReflectionVariable::OUTPUT, "vec4", SHADER_GL33_FRAG_OUTPUT, 0, mExplicitLocations ? 0 : -1);
+}
 
-			// Handle output of color.
-			if (mTokens[i] == "gl_FragColor") {
-				mTokens[i] = FRAG_OUTPUT;
-			}
-		} else if (mTokens[i] == "varying") {
-			// In vertex shaders, varying turns to out.
-			// in fragment shaders, varying turns to in.
-			mTokens[i] = "in";
-		} else if (isFunctionCallAtPos("texture", i)) {
-			// texture2D, textureCube, texture2DLod, ect is handled here. Basically
-			// this case handles texture functions
-			// In GLSL core profile, texture() is overloaded.
-			mTokens[i] = "texture";
-		}
-	}
+static ShaderDefineSet createBuiltinDefines() {
+	ShaderDefineSet defines;
+	defines.define("GL33");
+	defines.undefine("GL21");
+	defines.define("GL_core_profile", "1");
+	defines.define("__VERSION__", "330");
+	return defines;
+}
 
-	// create the shader and return it.
-	// first add our shader header.
-	std::string shader = SHADER_GL33_FRAGMENT_HEADER;
-	for (const auto &tok : mTokens) {
-		shader += tok.c_str();
-	}
-	return shader;
+const ShaderDefineSet &ShaderTranslatorGL33::getBuiltinDefines() const {
+	static const ShaderDefineSet defines = createBuiltinDefines();
+	return defines;
 }
\ No newline at end of file
@@ -38,30 +38,48 @@ public:
 	ShaderTranslatorGL33() {}
 
 	/**
-	 * Translates the shader in it's tokenized list form from GLSL 120 to GLSL
-	 * 330. It will print out the old shader and the new shader once the tokenization
-	 * process is completed.
-	 * @param str The stream of shader source to be tokenized and translated.
-	 * @param shaderType The type of shader stream that is being parsed, such as a
-	 *  vertex shader or a fragment (pixel) shader.
-	 * @return the translated shader source, back in a string form.
+	 * Get's the shading language this translator translates to.
+	 * @return ShaderBackend::GL33
 	 */
-	virtual const std::string translate(const std::string &str, ShaderType shaderType) override;
+	virtual ShaderBackend getBackend() const override {
+		return ShaderBackend::GL33;
+	}
 
-protected:
 	/**
-	 * Translates a vertex shader and turns it back into a proper shader.
-	 * @param str The stream of shader source to be tokenized and translated.
-	 * @return the translated shader source, back in a string form.
+	 * Get's the header for GLSL 330 core. Fragment shaders also declare the
+	 * generated output variable that replaces gl_FragColor.
+	 * @param shaderType The type of shader the header is for.
+	 * @return the header text.
 	 */
-	const std::string translateVertexShader(const std::string &str);
+	virtual std::string_view getHeader(ShaderType shaderType) const override;
 
 	/**
-	 * Translates a fragment shader and turns it back into a proper shader.
-	 * @param str The stream of shader source to be tokenized and translated.
-	 * @return the translated shader source, back in a string form.
+	 * Get's the macros GLSL 330 core defines, which are the macros of its header.
+	 * @return the set of macros.
 	 */
-	const std::string translateFragmentShader(const std::string &str);
+	virtual const ShaderDefineSet &getBuiltinDefines() const override;
+
+	/**
+	 * Get's the rewrite rules from GLSL 120 to GLSL 330.
+	 * @param shaderType The type of shader.
+	 * @return the table of rewrite rules.
+	 */
+	virtual const ShaderRewriteTable &getRewriteTable(ShaderType shaderType) const override;
+
+	/**
+	 * Get's layout(location = N) in, when explicit locations are on.
+	 * @param location The location of the attribute.
+	 * @return the replacement for the attribute qualifier.
+	 */
+	virtual std::string_view getAttributeQualifier(uint32_t location) const override;
+
+	/**
+	 * Adds the output that replaces gl_FragColor to the reflection of
+	 * fragment shaders.
+	 * @param shaderType The type of shader the header is for.
+	 * @param reflection The reflection of the shader.
+	 */
+	virtual void reflectHeader(ShaderType shaderType, ShaderReflection &reflection) const override;
 };
 
 #endif /* shaderTranslatorGL33_h */
\ No newline at end of file
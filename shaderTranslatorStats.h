@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderTranslatorStats_h
+#define shaderTranslatorStats_h
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Statistics are only collected when the library is built with
+ * GLSL_TRANSLATOR_STATS defined (the GLSL_TRANSLATOR_STATS CMake option).
+ * Otherwise everything wrapped in SHADER_STATS compiles to nothing.
+ */
+#ifdef GLSL_TRANSLATOR_STATS
+#define SHADER_STATS(x) x
+#else
+#define SHADER_STATS(x)
+#endif
+
+/**
+ * The number of values in ShaderToken::Kind.
+ */
+#define SHADER_STATS_TOKEN_KINDS 5
+
+/**
+ * The number of values in ShaderRewriteRule::Kind.
+ */
+#define SHADER_STATS_REWRITE_KINDS 4
+
+/**
+ * What translating shaders cost, split by phase. A context holds the numbers
+ * of the last shader it translated, and the translator adds them up for the
+ * whole process. Every member is a 64 bit counter.
+ */
+struct ShaderTranslationStats {
+	/**
+	 * The number of shaders the numbers are for.
+	 */
+	uint64_t translations;
+
+	/**
+	 * Nanoseconds spent tokenizing, rewriting tokens and emitting the output.
+	 */
+	uint64_t tokenizeNs;
+	uint64_t rewriteNs;
+	uint64_t emitNs;
+
+	/**
+	 * Bytes of shader source in and of translated shader out.
+	 */
+	uint64_t bytesIn;
+	uint64_t bytesOut;
+
+	/**
+	 * The number of tokens, indexed by ShaderToken::Kind.
+	 */
+	uint64_t tokens[SHADER_STATS_TOKEN_KINDS];
+
+	/**
+	 * The number of rewritten tokens, indexed by ShaderRewriteRule::Kind.
+	 */
+	uint64_t rewrites[SHADER_STATS_REWRITE_KINDS];
+
+	/**
+	 * The number of the context's buffers whose capacity changed while the
+	 * shader was translated, out of the token list, the replacement list and
+	 * the output string. A buffer counts once no matter how often it grew,
+	 * and memory used elsewhere, such as by the preprocessor or the minifier,
+	 * is not counted, so this is not a count of heap allocations.
+	 */
+	uint64_t bufferGrowths;
+
+	/**
+	 * Resets every counter to zero.
+	 */
+	void clear() {
+		*this = ShaderTranslationStats();
+	}
+
+	/**
+	 * Get's the current time for timing a phase.
+	 * @return a monotonic time in nanoseconds.
+	 */
+	static uint64_t now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+};
+
+#endif /* shaderTranslatorStats_h */
\ No newline at end of file
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#include "shaderHash.h"
+#include "shaderMinifier.h"
+#include "shaderVariantTranslator.h"
+
+ShaderVariantTranslator::ShaderVariantTranslator() {
+	mTranslators[ShaderTranslator::GL21] = &mGL21;
+	mTranslators[ShaderTranslator::GL33] = &mGL33;
+}
+
+void ShaderVariantTranslator::setTranslator(ShaderTranslator::ShaderBackend backend, const ShaderTranslator *translator) {
+	if (!translator) {
+		if (backend == ShaderTranslator::GL21)
+			translator = &mGL21;
+		else
+			translator = &mGL33;
+	}
+	mTranslators[backend] = translator;
+}
+
+ShaderVariantList ShaderVariantTranslator::translate(std::string_view source, ShaderTranslator::ShaderType shaderType, const std::vector<ShaderDefineSet> &defineSets, const std::vector<ShaderTranslator::ShaderBackend> &backends) {
+	// Collect every macro a variant or translator can define, so that the
+	// scan finds the places that use them.
+	mVariantNames.clear();
+	for (const auto &set : defineSets) {
+		for (const auto &define : set.getDefines())
+			mVariantNames.undefine(define.name);
+	}
+	mNames = mVariantNames;
+	for (ShaderTranslator::ShaderBackend backend : backends) {
+		for (const auto &define : mTranslators[backend]->getDefines().getDefines())
+			mNames.undefine(define.name);
+	}
+
+	// Tokenize and scan the source once for every variant.
+	if (!mContext.tokenize(source))
+		return ShaderVariantList();
+	ShaderPreprocessor &preprocessor = mContext.getPreprocessor();
+	preprocessor.scan(mContext.getSource(), mContext.getTokens(), mNames);
+
+	ShaderVariantList list;
+	list.variants.reserve(defineSets.size() * backends.size());
+	mOutputs.clear();
+	for (ShaderTranslator::ShaderBackend backend : backends) {
+		const ShaderTranslator &translator = *mTranslators[backend];
+		findRewrites(translator, shaderType);
+		mShaders.clear();
+
+		for (size_t i = 0; i < defineSets.size(); i++) {
+			// The variant's defines win over the translator's, and anything
+			// only other variants define is undefined.
+			mDefines = translator.getDefines();
+			for (const auto &name : mVariantNames.getDefines()) {
+				if (!mDefines.find(name.name))
+					mDefines.undefine(name.name);
+			}
+			for (const auto &define : defineSets[i].getDefines()) {
+				if (define.defined)
+					mDefines.define(define.name, define.value);
+				else
+					mDefines.undefine(define.name);
+			}
+			preprocessor.resolve(translator.getHeader(shaderType), translator.getBuiltinDefines(), mDefines);
+
+			// Variants with the same header and edits have the same output.
+			const ShaderReplacementList &edits = preprocessor.getEdits();
+			mKey.assign(preprocessor.getHeader());
+			for (const auto &edit : edits) {
+				mKey.append(reinterpret_cast<const char *>(&edit.token), sizeof(edit.token));
+				mKey.append(reinterpret_cast<const char *>(&edit.count), sizeof(edit.count));
+				mKey.append(edit.text);
+				mKey.push_back('\0');
+			}
+
+			auto it = mShaders.find(mKey);
+			if (it == mShaders.end()) {
+				applyEdits(edits);
+				std::string shader = mContext.emit(preprocessor.getHeader());
+				if (translator.isMinifying())
+					mContext.getMinifier().minify(shader, translator.isMinifyNameMap());
+				it = mShaders.emplace(mKey, addShader(list, std::move(shader))).first;
+			}
+			list.variants.push_back({ i, backend, it->second });
+		}
+	}
+	return list;
+}
+
+size_t ShaderVariantTranslator::addShader(ShaderVariantList &list, std::string shader) {
+	// Different edits can still give the same code, for example once the
+	// minifier has removed the line breaks that set them apart.
+	uint64_t hash = shaderHash64(shader.data(), shader.length());
+	auto range = mOutputs.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (list.shaders[it->second] == shader)
+			return it->second;
+	}
+
+	mOutputs.emplace(hash, list.shaders.size());
+	list.shaders.push_back(std::move(shader));
+	return list.shaders.size() - 1;
+}
+
+void ShaderVariantTranslator::findRewrites(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType) {
+	// The rewrites do not depend on the defines, so they are looked up once
+	// per backend for the whole source.
+	const ShaderRewriteTable &table = translator.getRewriteTable(shaderType);
+	const ShaderTokenList &tokens = mContext.getTokens();
+	mRewrites.clear();
+	for (size_t i = 0; i < tokens.size(); i++) {
+		if (tokens[i].kind != ShaderToken::IDENTIFIER)
+			continue;
+
+		const ShaderRewriteRule *rule = table.match(mContext.getTokenText(tokens[i]), mContext.getNextCharacter(i));
+		if (rule)
+			mRewrites.push_back({ i, 1, rule->replacement });
+	}
+}
+
+void ShaderVariantTranslator::applyEdits(const ShaderReplacementList &edits) {
+	// Merge the rewrites with the edits of the preprocessor, leaving out the
+	// rewrites of tokens that an edit replaces.
+	mContext.clearReplacements();
+	size_t rewrite = 0;
+	for (const auto &edit : edits) {
+		for (; rewrite < mRewrites.size() && mRewrites[rewrite].token < edit.token; rewrite++)
+			mContext.replaceToken(mRewrites[rewrite].token, mRewrites[rewrite].text);
+		mContext.replaceTokens(edit.token, edit.count, edit.text);
+		while (rewrite < mRewrites.size() && mRewrites[rewrite].token < edit.token + edit.count)
+			rewrite++;
+	}
+	for (; rewrite < mRewrites.size(); rewrite++)
+		mContext.replaceToken(mRewrites[rewrite].token, mRewrites[rewrite].text);
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of glslTranslator nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//	SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//------------------------------------------------------------------------------
+
+#ifndef shaderVariantTranslator_h
+#define shaderVariantTranslator_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "shaderTranslator.h"
+#include "shaderTranslatorGL21.h"
+#include "shaderTranslatorGL33.h"
+
+/**
+ * One variant of a shader: a set of defines translated for a backend.
+ */
+struct ShaderVariant {
+	/**
+	 * The index of the define set the variant was made with.
+	 */
+	size_t defines;
+	ShaderTranslator::ShaderBackend backend;
+
+	/**
+	 * The index of the translated shader in ShaderVariantList::shaders.
+	 * Variants whose code turned out the same share one shader.
+	 */
+	size_t shader;
+};
+
+/**
+ * The variants of a shader and their translated sources.
+ */
+struct ShaderVariantList {
+	std::vector<std::string> shaders;
+	std::vector<ShaderVariant> variants;
+};
+
+/**
+ * Translates the variants of an uber shader, one for every combination of
+ * a set of defines and a backend. The source is tokenized and scanned for
+ * directives once, the rewrites are looked up once per backend, and each
+ * variant then only resolves the directives and emits its output, so the
+ * cost grows with the size of the output instead of with the number of
+ * variants times the size of the source.
+ *
+ * Every macro that is defined in any of the define sets is treated as
+ * undefined in the variants that do not define it. Variants are always
+ * preprocessed, whether or not the translator has preprocessing turned on,
+ * and the translator's own defines apply to every variant. Variants are
+ * minified if the translator minifies.
+ * Example usage:
+ *
+ * std::vector<ShaderDefineSet> sets(2);
+ * sets[1].define("FOG");
+ *
+ * ShaderVariantTranslator translator;
+ * ShaderVariantList list = translator.translate(source, ShaderTranslator::FRAGMENT, sets,
+ *	{ ShaderTranslator::GL21, ShaderTranslator::GL33 });
+ */
+class ShaderVariantTranslator {
+public:
+	ShaderVariantTranslator();
+
+	/**
+	 * Changes the translator used for a backend.
+	 * @param backend The backend.
+	 * @param translator The translator to use, or null for the default one.
+	 *  It must outlive the variant translator.
+	 */
+	void setTranslator(ShaderTranslator::ShaderBackend backend, const ShaderTranslator *translator);
+
+	/**
+	 * Translates every variant of a shader.
+	 * @param source The shader source.
+	 * @param shaderType The type of shader.
+	 * @param defineSets The define sets, one per variant.
+	 * @param backends The backends to translate every variant for.
+	 * @return the variants, ordered by backend and then by define set, and
+	 *  the distinct translated shaders they use. Sources of 4 GB or more
+	 *  have no variants.
+	 */
+	ShaderVariantList translate(std::string_view source, ShaderTranslator::ShaderType shaderType, const std::vector<ShaderDefineSet> &defineSets, const std::vector<ShaderTranslator::ShaderBackend> &backends);
+
+private:
+	/**
+	 * Adds a translated shader to the list, unless the same code is in it.
+	 * @param list The list of the variants.
+	 * @param shader The translated shader.
+	 * @return the index of the shader in the list.
+	 */
+	size_t addShader(ShaderVariantList &list, std::string shader);
+
+	void findRewrites(const ShaderTranslator &translator, ShaderTranslator::ShaderType shaderType);
+	void applyEdits(const ShaderReplacementList &edits);
+
+	ShaderTranslatorGL21 mGL21;
+	ShaderTranslatorGL33 mGL33;
+	const ShaderTranslator *mTranslators[SHADER_BACKEND_COUNT];
+
+	ShaderTranslationContext mContext;
+
+	/**
+	 * The rewrites of every identifier for the current backend, applied to
+	 * each of its variants.
+	 */
+	ShaderReplacementList mRewrites;
+
+	/**
+	 * Every macro of the define sets, every macro the scan looks for, and
+	 * the macros of the current variant.
+	 */
+	ShaderDefineSet mVariantNames;
+	ShaderDefineSet mNames;
+	ShaderDefineSet mDefines;
+
+	/**
+	 * The shaders of the current backend by their header and edits.
+	 */
+	std::unordered_map<std::string, size_t> mShaders;
+	std::string mKey;
+
+	/**
+	 * The shaders of the list by a hash of their code.
+	 */
+	std::unordered_multimap<uint64_t, size_t> mOutputs;
+};
+
+#endif /* shaderVariantTranslator_h */
\ No newline at end of file